@@ -26,10 +26,15 @@
 #include "tree/TreeIO.h"
 #include "tree/Node.h"
 #include "tree/TreeIO.h"
+#include "tree/FrozenTree.h"
+#include "tree/TreeStream.h"
+#include "tree/CladeHash.h"
 #include "utils/AnError.h"
 #include "draw/DrawTreeCairo.h"
 #include "layout/Layoutrees.h"
+#include "lgt/ScenarioIO.h"
 
+#include <algorithm>
 #include <vector>
 #include <boost/dynamic_bitset.hpp>
 #include <boost/foreach.hpp>
@@ -38,7 +43,7 @@
 
 using namespace std;
 
-Mainops::Mainops() : parameters(0)
+Mainops::Mainops() : parameters(0), progress(0)
 {
 
 }
@@ -65,38 +70,63 @@ bool Mainops::lateralTransfer(const std::string &mapname, bool dp)
     late.g_input.min_cost = parameters->lateralmincost;
     late.g_input.gene_tree = genesTree.get();
     late.g_input.species_tree = speciesTree.get();
+    late.set_progress(progress);
+    // the scenarios of earlier runs are kept while the trees stay the same
+    uniquescenarios.setTrees(*genesTree, *speciesTree);
+    late.set_unique_scenarios(&uniquescenarios);
     
     if (dp)
     {
+        if (parameters->lateralanytime)
+        {
+            std::cerr << "The anytime LGT search needs a cost range, the "
+                         "dynamic programming algorithm is used instead.." << std::endl;
+        }
         late.g_input.print_only_minimal_loss_scenarios = false;
         late.g_input.print_only_minimal_transfer_scenarios = false;
     }
     
-    if (parameters->isreconciled)
+    // the species tree is only read by the LGT algorithms, it stays frozen
+    // while they run
+    speciesTree->freeze();
+    try
     {
-        late.g_input.sigma_fname = mapname;
-        late.read_sigma();
-    }
-    else
-    {
-        late.read_sigma(gs.getMapping());
-    }
+        if (parameters->isreconciled)
+        {
+            late.g_input.sigma_fname = mapname;
+            late.read_sigma();
+        }
+        else
+        {
+            late.read_sigma(gs);
+        }
     
-    if (dp)
-    {
-        late.dp_algorithm();
-        late.backtrack();
+        if (dp)
+        {
+            late.dp_algorithm();
+            late.backtrack();
+        }
+        else if (parameters->lateralanytime)
+        {
+            late.fpt_anytime(0.0, parameters->lateralmaxscenarios, parameters->lateraltimebudget,
+                             &Mainops::reportLGTLayer);
+        }
+        else
+        {
+            late.fpt_algorithm();
+        }
     }
-    else
+    catch (...)
     {
-        late.fpt_algorithm();
+        speciesTree->thaw();
+        throw;
     }
+    speciesTree->thaw();
 
     if (late.scenarios.size() > 0 && thereAreLGT(late.scenarios))
     {
         Scenario scenario = late.getMinCostScenario();
-        //lambda = scenario.cp.getLambda();
-        transferedges = scenario.transfer_edges;
+        transferedges = scenario.getTransferEdges();
         parameters->transferedges = transferedges;
         sigma = late.g_input.sigma;
         scenarios = late.scenarios;
@@ -110,6 +140,12 @@ bool Mainops::lateralTransfer(const std::string &mapname, bool dp)
     }
 }
 
+void Mainops::reportLGTLayer(double bound, const std::vector<Scenario> &layer)
+{
+    std::cout << "Found " << layer.size() << " LGT scenarios with cost up to "
+              << bound << ".." << std::endl;
+}
+
 void Mainops::printLGT()
 {
     std::cout << "List of computed LGT scenarios sorted by cost.." << std::endl;
@@ -117,13 +153,30 @@ void Mainops::printLGT()
     {
         std::cout << sc << std::endl;
     }
+    std::cout << uniquescenarios.size() << " distinct LGT scenarios have been "
+              << "computed for these trees.." << std::endl;
+}
+
+const ScenarioSet& Mainops::getUniqueScenarios() const
+{
+    return uniquescenarios;
+}
+
+void Mainops::exportLGT(const std::string &filename)
+{
+    ScenarioWriter writer(filename);
+    BOOST_FOREACH(const Scenario &sc, scenarios)
+    {
+        writer.write(sc);
+    }
+    writer.close();
 }
 
 bool Mainops::thereAreLGT(const std::vector<Scenario> &scenarios) const
 {
     BOOST_FOREACH(const Scenario &sc, scenarios)
     {
-        if (sc.transfer_edges.any())
+        if (!sc.transfer_edges.empty())
         {
             return true;
         }
@@ -182,6 +235,12 @@ void Mainops::CalculateGamma()
 
 void Mainops::reconcileTrees(const string &gene, const string &species, const string &mapfile)
 {
+    if (parameters->genesample)
+    {
+        reconcileSample(gene, species, mapfile);
+        return;
+    }
+
     io->setSourceFile(gene);
     genesTree.reset(io->readBeepTree(&AC, &gs));
 
@@ -205,19 +264,94 @@ void Mainops::reconcileTrees(const string &gene, const string &species, const st
     OpenHost(species);
 }
 
+void Mainops::reconcileSample(const string &gene, const string &species, const string &mapfile)
+{
+    io->setSourceFile(species);
+    speciesTree.reset(io->readNewickTree());
+
+    if (mapfile != "")
+    {
+        gs = TreeIO::readGeneSpeciesInfo(mapfile);
+    }
+    else
+    {
+        throw AnError(": The mapfile is empty!\n");
+    }
+
+    // the sample is collapsed while it is read, each topology is reconciled
+    // once and its result counts with the weight of the topology
+    TreeStream stream(gene);
+    TopologySet topologies;
+    const unsigned long trees = topologies.insert(stream);
+    const unsigned best = topologies.getMostFrequent();
+    const double total = topologies.getTotalWeight();
+    std::cout << "The Guest tree sample has " << trees << " trees and "
+              << topologies.size() << " topologies.." << std::endl;
+
+    // the topologies are compared with the most frequent one by their clades
+    const std::vector<unsigned> distances = topologies.getDistances(best);
+    double weighted_duplications = 0.0;
+    double weighted_distance = 0.0;
+    string textTree;
+    for (unsigned i = 0; i < topologies.size(); ++i)
+    {
+        const TopologySet::Topology &topology = topologies[i];
+        LambdaMapEx lambdamap_local(*topology.tree, *speciesTree, gs);
+        GammaMapEx gamma_local = GammaMapEx(GammaMapEx::MostParsimonious(*topology.tree, *speciesTree,
+                                                                           lambdamap_local));
+        unsigned duplications = 0;
+        for (unsigned v = 0; v < topology.tree->getNumberOfNodes(); ++v)
+        {
+            Node *u = topology.tree->getNode(v);
+            if (!u->isLeaf() && !gamma_local.isSpeciation(*u))
+            {
+                ++duplications;
+            }
+        }
+        weighted_duplications += topology.weight * duplications;
+        weighted_distance += topology.weight * distances[i];
+        std::cout << "Topology " << i + 1 << " : weight " << topology.weight
+                  << " (" << (total > 0.0 ? topology.weight / total : 0.0) << "), "
+                  << duplications << " duplications, RF distance "
+                  << distances[i] << " to the most frequent" << std::endl;
+        if (i == best)
+        {
+            textTree = io->writeGuestTree(*topology.tree, &gamma_local);
+        }
+    }
+    if (total > 0.0)
+    {
+        std::cout << "Expected number of duplications over the sample : "
+                  << weighted_duplications / total << std::endl;
+        std::cout << "Expected RF distance to the most frequent topology : "
+                  << weighted_distance / total << std::endl;
+    }
+    std::cout << "The most frequent topology (" << best + 1 << ") is drawn.." << std::endl;
+    const std::vector<double> support = topologies.getCladeSupport(best);
+    if (!support.empty())
+    {
+        std::cout << "Its clades are found in " << *std::min_element(support.begin(), support.end())
+                  << " to " << *std::max_element(support.begin(), support.end())
+                  << " of the sample.." << std::endl;
+    }
+
+    io->setSourceString(textTree);
+    genesTree.reset(io->readBeepTree(&AC, &gs));
+    OpenHost(species);
+}
+
 void Mainops::calculateCordinates()
 {
-    speciesTree->reset();
-    genesTree->reset();
     // reduce crossing lines or try to
     if (parameters->reduce)
     {
         std::cout << "NOTE : the option -R is still experimental.." << std::endl;
         gamma->twistAndTurn(genesTree.get(),speciesTree.get());
     }
-    // compute coordinates
+    // compute coordinates in a new layout, the trees are not modified
+    layout.reset(new LayoutBuffer(*speciesTree, *genesTree));
     LayoutTrees spcord = LayoutTrees(speciesTree.get(), genesTree.get(),
-                                     parameters, gamma.get(), lambdamap.get());
+                                     parameters, gamma.get(), lambdamap.get(), layout.get());
     spcord.start();
     parameters->leafwidth = spcord.getNodeHeight();
 }
@@ -237,7 +371,7 @@ bool Mainops::checkValidity()
 void Mainops::DrawTree(cairo_t *cr)
 {
     //starts makes a clean up
-    dt->start(parameters,genesTree.get(),speciesTree.get(),gamma.get(),lambdamap.get(),cr);
+    dt->start(parameters,genesTree.get(),speciesTree.get(),gamma.get(),lambdamap.get(),layout.get(),cr);
 
     dt->calculateTransformation();
     
@@ -312,6 +446,11 @@ void Mainops::setParameters(Parameters *p)
     parameters = p;
 }
 
+void Mainops::setProgress(Progress *p)
+{
+    progress = p;
+}
+
 bool Mainops::getValidityLGT()
 {
     if(gamma->validLGT())
@@ -324,10 +463,9 @@ bool Mainops::getValidityLGT()
 
         BOOST_FOREACH (Scenario &sc, scenarios)
         {
-            transferedges = sc.transfer_edges;
-            parameters->transferedges = sc.transfer_edges;
-            parameters->duplications = sc.duplications;
-            //lambda = sc.cp.getLambda();
+            transferedges = sc.getTransferEdges();
+            parameters->transferedges = transferedges;
+            parameters->duplications = sc.getDuplications();
             CalculateGamma();
             if(gamma->validLGT())
             {
@@ -367,10 +505,9 @@ void Mainops::drawAllLGT()
     sort(scenarios.begin(), scenarios.end());
     BOOST_FOREACH (Scenario &sc, scenarios)
     {
-        transferedges = sc.transfer_edges;
-        parameters->transferedges = sc.transfer_edges;
-        parameters->duplications = sc.duplications;
-        //lambda = sc.cp.getLambda();
+        transferedges = sc.getTransferEdges();
+        parameters->transferedges = transferedges;
+        parameters->duplications = sc.getDuplications();
         parameters->outfile = original_filename + boost::lexical_cast<string>(++index);
         CalculateGamma(); //calculation of gamma and lambdamap
         if (gamma->validLGT())
@@ -387,61 +524,90 @@ void Mainops::drawAllLGT()
 
 void Mainops::loadPreComputedScenario(const std::string &filename,const std::string &mapname)
 {
-    std::ifstream scenario_file;
-    std::string line;
-    scenario_file.open(filename.c_str(), std::ios::in);
-
-    if (!scenario_file)
-    {
-        throw AnError("Could not open file " + filename);
-    }
-
-    while (getline(scenario_file, line))
-    {
-        if (scenario_file.good())
+    if (ScenarioReader::isScenarioFile(filename))
+    {
+        // binary export, take the cheapest scenario (fewest losses on ties)
+        ScenarioReader reader(filename);
+        reader.checkTrees(*genesTree, *speciesTree);
+        Scenario sc(genesTree->getNumberOfNodes());
+        Scenario best(genesTree->getNumberOfNodes());
+        unsigned losses = 0;
+        unsigned best_losses = 0;
+        bool found = false;
+        while (reader.next(sc, losses))
         {
-            if (line.size() == 0)  // Skip any blank lines
-            {
-                continue;
-            }
-            else if (line[0] == '#')  // Skip any comment lines
+            if (!found || sc.cost < best.cost || (sc.cost == best.cost && losses < best_losses))
             {
-                continue;
+                best = sc;
+                best_losses = losses;
+                found = true;
             }
-            else if ((line.find("Transfer") != std::string::npos))
+        }
+        if (!found)
+        {
+            throw AnError("There are no scenarios in the file " + filename);
+        }
+        transferedges = best.getTransferEdges();
+        parameters->duplications = best.getDuplications();
+    }
+    else
+    {
+        std::ifstream scenario_file;
+        std::string line;
+        scenario_file.open(filename.c_str(), std::ios::in);
+
+        if (!scenario_file)
+        {
+            throw AnError("Could not open file " + filename);
+        }
+
+        while (getline(scenario_file, line))
+        {
+            if (scenario_file.good())
             {
-                const std::size_t start_pos = line.find(":");
-                const std::size_t stop_pos = line.size() - 1;
-                std::string temp = line.substr(start_pos + 1,stop_pos - start_pos);
-                stringstream lineStream(temp);
-                std::vector<std::string> transfer_nodes((istream_iterator<std::string>(lineStream)),
-                                                        istream_iterator<std::string>());
-                transferedges.clear();
-                transferedges.resize(genesTree->getNumberOfNodes());
-                for(std::vector<std::string>::const_iterator it = transfer_nodes.begin();
-                    it != transfer_nodes.end(); ++it)
+                if (line.size() == 0)  // Skip any blank lines
                 {
-                    std::vector<std::string> strs;
-                    std::string temp = *it;
-                    temp.erase(remove(temp.begin(),temp.end(),'('),temp.end());
-                    temp.erase(remove(temp.begin(),temp.end(),')'),temp.end());
-                    boost::split(strs, temp, boost::is_any_of(","));
-                    if(genesTree->getNode(boost::lexical_cast<unsigned>(strs.at(0))) != 0)
-                    {
-                        transferedges.set(boost::lexical_cast<unsigned>(strs.at(0))); //origin LGT
-                    }
-                    else
+                    continue;
+                }
+                else if (line[0] == '#')  // Skip any comment lines
+                {
+                    continue;
+                }
+                else if ((line.find("Transfer") != std::string::npos))
+                {
+                    const std::size_t start_pos = line.find(":");
+                    const std::size_t stop_pos = line.size() - 1;
+                    std::string temp = line.substr(start_pos + 1,stop_pos - start_pos);
+                    stringstream lineStream(temp);
+                    std::vector<std::string> transfer_nodes((istream_iterator<std::string>(lineStream)),
+                                                            istream_iterator<std::string>());
+                    transferedges.clear();
+                    transferedges.resize(genesTree->getNumberOfNodes());
+                    for(std::vector<std::string>::const_iterator it = transfer_nodes.begin();
+                        it != transfer_nodes.end(); ++it)
                     {
-                        throw AnError("Node read in the LGT scenario file does not exist in the Gene Tree");
+                        std::vector<std::string> strs;
+                        std::string temp = *it;
+                        temp.erase(remove(temp.begin(),temp.end(),'('),temp.end());
+                        temp.erase(remove(temp.begin(),temp.end(),')'),temp.end());
+                        boost::split(strs, temp, boost::is_any_of(","));
+                        if(genesTree->getNode(boost::lexical_cast<unsigned>(strs.at(0))) != 0)
+                        {
+                            transferedges.set(boost::lexical_cast<unsigned>(strs.at(0))); //origin LGT
+                        }
+                        else
+                        {
+                            throw AnError("Node read in the LGT scenario file does not exist in the Gene Tree");
+                        }
+                        // transferedges.set(boost::lexical_cast<unsigned>(strs.at(1))); //destiny LGT
+                        // strs.at(2) //this is the time NOTE not used yet (the idea is to put the time
+                        // in the node and use it to compute the cordinates
                     }
-                    // transferedges.set(boost::lexical_cast<unsigned>(strs.at(1))); //destiny LGT
-                    // strs.at(2) //this is the time NOTE not used yet (the idea is to put the time
-                    // in the node and use it to compute the cordinates
                 }
             }
         }
+        scenario_file.close();
     }
-    scenario_file.close();
     parameters->lattransfer = true;
     Phyltr late = Phyltr();
     late.g_input.gene_tree = genesTree.get();
@@ -454,7 +620,7 @@ void Mainops::loadPreComputedScenario(const std::string &filename,const std::str
     }
     else
     {
-        late.read_sigma(gs.getMapping());
+        late.read_sigma(gs);
     }
 
     parameters->transferedges = transferedges;
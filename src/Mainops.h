@@ -28,10 +28,12 @@
 #define MAINOPS_H
 
 #include "lgt/Phyltr.h"
+#include "lgt/ScenarioSet.h"
 #include "reconcilation/GammaMapEx.h"
 #include "reconcilation/LambdaMapEx.h"
 #include "reconcilation/SetOfNodesEx.h"
 #include "draw/DrawTreeCairo.h"
+#include "layout/LayoutBuffer.h"
 
 #include <boost/dynamic_bitset.hpp>
 
@@ -57,13 +59,19 @@ public:
     // return true if there is a valid scenario.
     bool lateralTransfer(const std::string &mapname, bool dp = false /*dynamic programming*/);
 
+    // prints a complete layer of scenarios found by the anytime LGT search,
+    // the GUI follows the layers through the Progress token instead
+    static void reportLGTLayer(double bound, const std::vector<Scenario> &layer);
+
     // load the reconciled gene tree and obtatins its information
     void OpenReconciled(const string &gene);
 
     // load the species tree and obtain its information
     void OpenHost(const string &species);
 
-    // reconcile the gene tree given as input, the species tree and the map file are needed
+    // reconcile the gene tree given as input, the species tree and the map file are needed.
+    // With the parameter genesample the gene file is a sample of trees, see
+    // reconcileSample()
     void reconcileTrees(const string &gene, const string &species, const string &mapfile);
 
     // calculate the gamma map and the lambda map of the trees loaded
@@ -87,9 +95,17 @@ public:
     // set the parameters object
     void setParameters(Parameters *p);
 
+    // set the token used to follow and cancel the LGT computations,
+    // a cancelled computation throws Progress::Cancelled
+    void setProgress(Progress *p);
+
     // print a selected numbef of LGT scenarios sorted by cost
     void printLGT();
 
+    // write the LGT scenarios in the binary format of lgt/ScenarioIO.h,
+    // the file can be loaded back with loadPreComputedScenario
+    void exportLGT(const std::string &filename);
+
     // draws and saves in a file the most optimal scenario
     void drawBest();
 
@@ -99,8 +115,14 @@ public:
     // loads a precomputed LGT scenario from a text file
     // file must look like :
     // Transfer edges Numbers:	(origin,destiny,time) (1,2,0.12)
+    // or from a binary file written by exportLGT, the cheapest scenario is taken
     void loadPreComputedScenario(const std::string &filename,const std::string &mapname); 
 
+    // the distinct LGT scenarios of all the runs of lateralTransfer on the
+    // current trees, duplicates across runs are only kept once. Loading
+    // other trees starts a new set
+    const ScenarioSet& getUniqueScenarios() const;
+
     // check if there are scenarios with LGT in the set of scenarios given
     bool thereAreLGT(const std::vector<Scenario> &scenarios) const;
 
@@ -114,9 +136,12 @@ protected:
     std::shared_ptr<GammaMapEx> gamma;
     std::shared_ptr<LambdaMapEx> lambdamap;
     std::unique_ptr<DrawTreeCairo> dt; //drawing
+    std::unique_ptr<LayoutBuffer> layout; //cordinates of the last layout
     Parameters *parameters;
+    Progress *progress;
 
     std::vector<Scenario> scenarios;
+    ScenarioSet uniquescenarios;
     dynamic_bitset<> transferedges;
     std::vector<unsigned> sigma;
     //std::vector<unsigned> lambda; //not user at the moment
@@ -124,6 +149,12 @@ protected:
     std::unique_ptr<TreeIO> io;
     std::vector<SetOfNodesEx<Node> > AC;
     StrStrMap gs;
+
+    // reconciles every distinct topology of the sample of gene trees once
+    // (see tree/CladeHash.h), prints the duplications of each one with its
+    // weight and their expected number over the sample, and keeps the most
+    // frequent topology as the gene tree to draw
+    void reconcileSample(const string &gene, const string &species, const string &mapfile);
 };  
 
 #endif // MAINOPS_H
@@ -65,6 +65,9 @@ Parameters& Parameters::operator=(const Parameters& p)
         lateralmaxcost = p.lateralmaxcost;
         lateralduplicost = p.lateralduplicost;
         lateraltrancost = p.lateraltrancost;
+        lateralanytime = p.lateralanytime;
+        lateralmaxscenarios = p.lateralmaxscenarios;
+        lateraltimebudget = p.lateraltimebudget;
         UI = p.UI;
         scaleByTime = p.scaleByTime;
         timeAtEdges = p.timeAtEdges;
@@ -79,6 +82,7 @@ Parameters& Parameters::operator=(const Parameters& p)
         uMarker = p.uMarker;
         ladd = p.ladd;
         isreconciled = p.isreconciled;
+        genesample = p.genesample;
         um_fontsize = p.um_fontsize;
         ux_offset = p.ux_offset;
         uy_offset = p.uy_offset;
@@ -133,6 +137,9 @@ void Parameters::reset()
     lateralmaxcost = 10.0;
     lateralduplicost = 1.0;
     lateraltrancost = 1.0;
+    lateralanytime = false;
+    lateralmaxscenarios = 0;
+    lateraltimebudget = 0.0;
     show_event_count = false;
     UI = false;
     scaleByTime = true;
@@ -146,6 +153,7 @@ void Parameters::reset()
     outfile = "image";
     ladd = 'n';
     isreconciled = false;
+    genesample = false;
     um_fontsize = 1.0;
     species_font_size = 10.0;
     gene_font_size = 10.0;
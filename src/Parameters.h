@@ -66,6 +66,9 @@ public:
     float lateralmaxcost;
     float lateralduplicost;
     float lateraltrancost;
+    bool lateralanytime;
+    unsigned lateralmaxscenarios;
+    float lateraltimebudget;
     bool show_event_count;
     bool UI;
     bool scaleByTime;
@@ -80,6 +83,7 @@ public:
     std::vector<double> uMarker;
     char ladd;
     bool isreconciled;
+    bool genesample;
     float um_fontsize;
     float ux_offset;
     float uy_offset;
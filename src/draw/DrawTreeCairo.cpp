@@ -34,6 +34,7 @@
 #include "../lgt/Phyltr.h"
 #include "../Parameters.h"
 #include "../layout/Edge.h"
+#include "../layout/LayoutBuffer.h"
 
 #include "math.h"
 
@@ -53,6 +54,8 @@ using namespace std;
 
 DrawTreeCairo::DrawTreeCairo()
     :
+      slayout(0),
+      glayout(0),
       config(0),
       surface(0),
       surfaceBackground(0),
@@ -70,12 +73,15 @@ void DrawTreeCairo::start(const Parameters *p,
                           TreeExtended *s,
                           const GammaMapEx *ga,
                           const LambdaMapEx *la,
+                          LayoutBuffer *l,
                           cairo_t* cr_)
 {
     parameters = p;
     gene = g;
     species = s;
     gamma = ga;
+    slayout = &l->getSpeciesLayout();
+    glayout = &l->getGeneLayout();
     config = parameters->colorConfig;
     lambda = la;
 
@@ -262,8 +268,8 @@ void DrawTreeCairo::calculateTransformation()
 
     if(parameters->horiz)
     {
-        //const double origin_x = species->getRootNode()->getX();
-        const double origin_y = species->getRootNode()->getY();
+        //const double origin_x = speciesLayout(species->getRootNode()).x;
+        const double origin_y = speciesLayout(species->getRootNode()).y;
 
         //we first translate to 0,0 then translate to height - y finally we rotate 90°
         cairo_matrix_t matrix_translation;
@@ -466,7 +472,7 @@ DrawTreeCairo::GeneTreeMarkers()
             ostringstream os;
             os << *i;
             const string st = os.str();
-            cairo_move_to(cr,n->getX() + parameters->ux_offset + offset,n->getY() + parameters->uy_offset + offset);
+            cairo_move_to(cr,geneLayout(n).x + parameters->ux_offset + offset,geneLayout(n).y + parameters->uy_offset + offset);
             cairo_show_text(cr,st.c_str()); 
         }
     }
@@ -481,6 +487,16 @@ DrawTreeCairo::double2charp(const double &x)
     return et.str();
 }
 
+NodeLayout& DrawTreeCairo::speciesLayout(const Node *n) const
+{
+    return (*slayout)[n];
+}
+
+NodeLayout& DrawTreeCairo::geneLayout(const Node *n) const
+{
+    return (*glayout)[n];
+}
+
 void DrawTreeCairo::DrawTimeEdges()
 {
     cairo_set_line_width (cr, linewidth);
@@ -498,8 +514,8 @@ void DrawTreeCairo::DrawTimeEdges()
         Node* n = species->getNode(u);
         if (!n->isLeaf())
         {		    
-            cairo_move_to(cr, n->getX(), pageheight);    
-            cairo_line_to(cr, n->getX(), n->getY() + midnode);
+            cairo_move_to(cr, speciesLayout(n).x, pageheight);    
+            cairo_line_to(cr, speciesLayout(n).x, speciesLayout(n).y + midnode);
         }
     }
 
@@ -519,10 +535,10 @@ void DrawTreeCairo::DrawSpeciesEdgesWithContour()
     const double midnode = leafWidth;
     Node *root = species->getRootNode();
 
-    cairo_move_to(cr, 0, root->getY()+midnode);
-    cairo_rel_line_to(cr, root->getX(), 0);
+    cairo_move_to(cr, 0, speciesLayout(root).y+midnode);
+    cairo_rel_line_to(cr, speciesLayout(root).x, 0);
     cairo_rel_line_to(cr,0, -(midnode * 2) );
-    cairo_rel_line_to(cr, -(root->getX()), 0);
+    cairo_rel_line_to(cr, -(speciesLayout(root).x), 0);
     cairo_close_path(cr);
 
     cairo_set_source_rgba(cr, cline.red, cline.green, cline.blue, 1);
@@ -532,24 +548,26 @@ void DrawTreeCairo::DrawSpeciesEdgesWithContour()
     
     for ( Node *n = species->preorder_begin(); n != 0; n = species->preorder_next(n) )
     {
-        const double x = n->getX();
-        const double y = n->getY();
+        const double x = speciesLayout(n).x;
+        const double y = speciesLayout(n).y;
 
         if (!n->isLeaf())
         { 
+            const NodeLayout &left = speciesLayout(slayout->getLeftChild(n));
+            const NodeLayout &right = speciesLayout(slayout->getRightChild(n));
             double pmidx;
             double pmidy;
             intersection(x, y - midnode,
-                    n->getLeftChild()->getX(), n->getLeftChild()->getY()-midnode,		      
+                    left.x, left.y-midnode,
                     x, y + midnode,
-                    n->getRightChild()->getX(), n->getRightChild()->getY()+midnode,
+                    right.x, right.y+midnode,
                     pmidx, pmidy);
 
             cairo_move_to(cr, x, y + midnode);
-            cairo_rel_line_to(cr,n->getLeftChild()->getX()-x,n->getLeftChild()->getY()-y);
+            cairo_rel_line_to(cr,left.x-x,left.y-y);
             cairo_rel_line_to(cr, 0, -(midnode * 2) );
             cairo_line_to(cr, pmidx, pmidy);
-            cairo_line_to(cr,n->getRightChild()->getX(),n->getRightChild()->getY()+midnode);
+            cairo_line_to(cr,right.x,right.y+midnode);
             cairo_rel_line_to(cr, 0, - (midnode * 2) );
             cairo_line_to(cr, x, y - midnode);
             cairo_close_path(cr);
@@ -570,34 +588,36 @@ void DrawTreeCairo::DrawSpeciesEdges()
     const double midnode = leafWidth;
     Node *root = species->getRootNode();
 
-    cairo_move_to(cr, 0, (root->getY() + midnode) );
-    cairo_rel_line_to(cr,root->getX(),0);
+    cairo_move_to(cr, 0, (speciesLayout(root).y + midnode) );
+    cairo_rel_line_to(cr,speciesLayout(root).x,0);
     cairo_rel_line_to(cr, 0, -(midnode * 2) );
-    cairo_rel_line_to(cr, -(root->getX()) , 0);
+    cairo_rel_line_to(cr, -(speciesLayout(root).x) , 0);
     cairo_close_path(cr);
     cairo_stroke_preserve(cr);
     cairo_fill(cr);
     
     for ( Node *n = species->preorder_begin(); n != 0; n = species->preorder_next(n) )
     {
-        const double x = n->getX();
-        const double y = n->getY();
+        const double x = speciesLayout(n).x;
+        const double y = speciesLayout(n).y;
 
         cairo_set_source_rgba(cr,config->species_edge_color.red,config->species_edge_color.green,config->species_edge_color.blue,1);
         if (!n->isLeaf())
         {
+            const NodeLayout &left = speciesLayout(slayout->getLeftChild(n));
+            const NodeLayout &right = speciesLayout(slayout->getRightChild(n));
             cairo_move_to(cr,x,y + midnode);
-            cairo_rel_line_to(cr,n->getLeftChild()->getX()-x,n->getLeftChild()->getY()-y);
+            cairo_rel_line_to(cr,left.x-x,left.y-y);
             cairo_rel_line_to(cr,0,-midnode*2);
-            cairo_rel_line_to(cr,x-n->getLeftChild()->getX(),(y) - (n->getLeftChild()->getY()));
+            cairo_rel_line_to(cr,x-left.x,(y) - (left.y));
             cairo_close_path(cr);
             cairo_stroke_preserve(cr);
             cairo_fill(cr);
 
             cairo_move_to(cr,x,y - midnode);
-            cairo_rel_line_to(cr,n->getRightChild()->getX()-x,n->getRightChild()->getY()-y);
+            cairo_rel_line_to(cr,right.x-x,right.y-y);
             cairo_rel_line_to(cr,0,midnode*2);
-            cairo_rel_line_to(cr,x-n->getRightChild()->getX(),y - n->getRightChild()->getY());
+            cairo_rel_line_to(cr,x-right.x,y - right.y);
             cairo_close_path(cr);
             cairo_stroke_preserve(cr);
             cairo_fill(cr);
@@ -637,7 +657,7 @@ void DrawTreeCairo::DrawTimeLabels()
         if (!n->isLeaf())
         {
             const string timelabel = double2charp(n->getNodeTime());
-            const double xpos = n->getX();
+            const double xpos = speciesLayout(n).x;
             const double ypos = pageheight;
             cairo_move_to(cr,xpos+offset,ypos);
             cairo_save(cr);
@@ -671,7 +691,7 @@ void DrawTreeCairo::DrawSpeciesNodes()
         if (!n->isLeaf())
         {
             cairo_save(cr);
-            cairo_translate (cr,n->getX(), n->getY());
+            cairo_translate (cr,speciesLayout(n).x, speciesLayout(n).y);
             cairo_scale(cr, 0.3, 1);
             cairo_arc (cr, 0.0, 0.0,leafWidth, 0.0, 2 * pi);
             cairo_set_source_rgba(cr, cfill.red, cfill.green, cfill.blue, 1);
@@ -706,8 +726,8 @@ void DrawTreeCairo::DrawSpeciesNodeLabels()
         }
 
         const string ns = st.str();
-        const double xpos = n->getX();
-        const double ypos = n->getY();
+        const double xpos = speciesLayout(n).x;
+        const double ypos = speciesLayout(n).y;
 
         cairo_text_extents (cr, ns.c_str(), &extents);
         if(n->isLeaf())
@@ -740,8 +760,8 @@ DrawTreeCairo::TimeLabelsOnEdges()
     {
         Node* n = species->getNode(u);
         const string timelabel = double2charp(n->getTime());
-        double xpos = n->getX();
-        double ypos = n->getY();
+        double xpos = speciesLayout(n).x;
+        double ypos = speciesLayout(n).y;
         if (!n->isLeaf())
         {
             cairo_text_extents (cr, timelabel.c_str(), &extents);
@@ -769,16 +789,16 @@ void DrawTreeCairo::DrawGeneNodes()
         
     for ( Node *n = gene->preorder_begin(); n != 0; n = gene->preorder_next(n) )
     {
-        const double x = n->getX();
-        const double y = n->getY();
+        const double x = geneLayout(n).x;
+        const double y = geneLayout(n).y;
         
-        if(n->getReconcilation() == Node::Leaf || n->getReconcilation() == Node::Speciation) //speciation or leaf
+        if(geneLayout(n).reconcilation == NodeLayout::Leaf || geneLayout(n).reconcilation == NodeLayout::Speciation) //speciation or leaf
         {
             cairo_set_source_rgba(cr, specCol.red, specCol.green, specCol.blue, 1);
             cairo_arc(cr,x, y, (leafWidth / 10), 0.0, 2*pi);
             cairo_fill(cr);
         }
-        else if (n->getReconcilation() == Node::Duplication) //duplication
+        else if (geneLayout(n).reconcilation == NodeLayout::Duplication) //duplication
         {
             nDupl++;
             cairo_set_source_rgba(cr, duplCol.red, duplCol.green, duplCol.blue, 1);
@@ -787,7 +807,7 @@ void DrawTreeCairo::DrawGeneNodes()
             cairo_fill(cr);
 
         }
-        else if (n->getReconcilation() == Node::LateralTransfer) //duplication
+        else if (geneLayout(n).reconcilation == NodeLayout::LateralTransfer) //duplication
         {
             nTrans++;
             cairo_set_source_rgba(cr, duplCol.red, duplCol.green, duplCol.blue, 1);
@@ -812,7 +832,7 @@ void DrawTreeCairo::DrawGeneEdges()
         Node *n = gene->getNode(i);
         if (!n->isRoot())
         {
-            if(n->getReconcilation() == Node::LateralTransfer)
+            if(geneLayout(n).reconcilation == NodeLayout::LateralTransfer)
             {
                 LGT.insert(std::make_pair(n,0));
             }
@@ -823,15 +843,15 @@ void DrawTreeCairo::DrawGeneEdges()
         }
         else if ((*lambda)[n]->isRoot())
         {
-            cairo_move_to(cr,n->getX(),n->getY());
-            cairo_line_to(cr,0,n->getY());
+            cairo_move_to(cr,geneLayout(n).x,geneLayout(n).y);
+            cairo_line_to(cr,0,geneLayout(n).y);
         }
         else 
         {    
             //TODO can the root be further away than 1 node?
-            cairo_move_to(cr,n->getX(),n->getY());
-            cairo_line_to(cr,species->getRootNode()->getX(),species->getRootNode()->getY());
-            cairo_line_to(cr,0,species->getRootNode()->getY());
+            cairo_move_to(cr,geneLayout(n).x,geneLayout(n).y);
+            cairo_line_to(cr,speciesLayout(species->getRootNode()).x,speciesLayout(species->getRootNode()).y);
+            cairo_line_to(cr,0,speciesLayout(species->getRootNode()).y);
         }
     }
 
@@ -861,8 +881,8 @@ void DrawTreeCairo::DrawGeneLabels()
                 os << n->getName() << " ";
             }
             cairo_text_extents(cr, os.str().c_str(), &extents);
-            double xpos = n->getX() + extents.height;
-            double ypos = n->getY() + (extents.height / 2);
+            double xpos = geneLayout(n).x + extents.height;
+            double ypos = geneLayout(n).y + (extents.height / 2);
             cairo_move_to(cr,xpos,ypos);
             cairo_save(cr);
             if(parameters->horiz)
@@ -881,29 +901,29 @@ void DrawTreeCairo::DrawGeneLabels()
 void DrawTreeCairo::newDrawPath(Node *n)
 {
 
-    Node *origin = n->getHostChild();
-    Node *destiny = n->getParent()->getHostChild();
+    Node *origin = geneLayout(n).hostChild;
+    Node *destiny = geneLayout(n->getParent()).hostChild;
     Node *nparent = n->getParent();
 
     //when there is a LGT in between we have to draw the path
     //until the next speciation or duplication node or LT node
-    if(n->getParent()->getReconcilation() == Node::LateralTransfer
+    if(geneLayout(n->getParent()).reconcilation == NodeLayout::LateralTransfer
         && ((*lambda)[n] == (*lambda)[n->getParent()]) && !destinyLGT(n))
     {
-        destiny = n->getHostParent();
+        destiny = geneLayout(n).hostParent;
         nparent = getHighestMappedLGT(n);
     }
-    else if (n->getParent()->getReconcilation() == Node::LateralTransfer)
+    else if (geneLayout(n->getParent()).reconcilation == NodeLayout::LateralTransfer)
     {
         destiny = origin;
     }
 
-    double xorigin = n->getX();
-    double yorigin = n->getY();
+    double xorigin = geneLayout(n).x;
+    double yorigin = geneLayout(n).y;
     double xend = 0.0;
     double yend = 0.0;
 
-    cairo_move_to(cr,n->getX(),n->getY());
+    cairo_move_to(cr,geneLayout(n).x,geneLayout(n).y);
 
     Node *o;
     //we start to draw from the lowest node and from leaves to root
@@ -911,26 +931,26 @@ void DrawTreeCairo::newDrawPath(Node *n)
     for (o = origin; o != destiny && !o->isRoot(); o = o->getParent() )
     {
 
-        if(nparent->getReconcilation() == Node::Speciation && o->getParent() == destiny)
+        if(geneLayout(nparent).reconcilation == NodeLayout::Speciation && o->getParent() == destiny)
         {
-            cairo_line_to(cr,nparent->getX(),nparent->getY());
-            xend = nparent->getX();
-            yend = nparent->getY();
+            cairo_line_to(cr,geneLayout(nparent).x,geneLayout(nparent).y);
+            xend = geneLayout(nparent).x;
+            yend = geneLayout(nparent).y;
             addEdge(o,destiny,n,nparent,xorigin,yorigin,xend,yend,Edge::Normal);
-            xorigin = nparent->getX();
-            yorigin = nparent->getY();
+            xorigin = geneLayout(nparent).x;
+            yorigin = geneLayout(nparent).y;
         }
         else
         {
-            double x = o->getParent()->getX();
+            double x = speciesLayout(o->getParent()).x;
             unsigned size = gamma->getSize(o->getParent());
-            double y = o->getParent()->getY();
+            double y = speciesLayout(o->getParent()).y;
             if(size > 1)
             {
                 double delta = leafWidth / (size - 1);
-                y = (o->getParent()->getY() - (leafWidth / 2) ) + ((o->getParent()->getVisited()) * delta);
+                y = (speciesLayout(o->getParent()).y - (leafWidth / 2) ) + ((speciesLayout(o->getParent()).visited) * delta);
             }
-            o->getParent()->incVisited();
+            speciesLayout(o->getParent()).visited++;
             cairo_line_to(cr,x,y);
             xend = x;
             yend = y;
@@ -942,10 +962,10 @@ void DrawTreeCairo::newDrawPath(Node *n)
 
     //we draw an extra edge if the destiny is a duplication
 
-    if(nparent->getReconcilation() == Node::Duplication)
+    if(geneLayout(nparent).reconcilation == NodeLayout::Duplication)
     {   
-        cairo_line_to(cr,nparent->getX(),nparent->getY());
-        addEdge(o,destiny,n,n->getParent(),xorigin,yorigin,nparent->getX(),nparent->getY(),Edge::Normal);
+        cairo_line_to(cr,geneLayout(nparent).x,geneLayout(nparent).y);
+        addEdge(o,destiny,n,n->getParent(),xorigin,yorigin,geneLayout(nparent).x,geneLayout(nparent).y,Edge::Normal);
 
     }
 }
@@ -971,7 +991,7 @@ void DrawTreeCairo::DrawLGT()
 void DrawTreeCairo::newLGTPath(Node *n)
 {
 
-    Node *destiny = n->getHostParent();
+    Node *destiny = geneLayout(n).hostParent;
     Node *GeneOrigin = getLowestMappedLGT(n);    
     Node *GeneDestiny = getLowestMappedNOLGT(n); 
 
@@ -982,10 +1002,10 @@ void DrawTreeCairo::newLGTPath(Node *n)
     double originx = retorno.second.first;
     double destinyx = retorno.second.second;
 
-    double x1 = origin->getParent()->getX();
-    double x2 = origin->getX();
-    double y1 = origin->getParent()->getY();
-    double y2 = origin->getY();
+    double x1 = speciesLayout(origin->getParent()).x;
+    double x2 = speciesLayout(origin).x;
+    double y1 = speciesLayout(origin->getParent()).y;
+    double y2 = speciesLayout(origin).y;
 
     Edge *e = 0;
     e = getEdge(origin,GeneOrigin);
@@ -1000,24 +1020,24 @@ void DrawTreeCairo::newLGTPath(Node *n)
     double n1 = y1 - (slope * x1);
     double y = (slope * originx) + n1;
 
-    n->setX(originx);
-    n->setY(y);
+    geneLayout(n).x = originx;
+    geneLayout(n).y = y;
 
     if(destinyx != -1)
     {
-        x2 = GeneDestiny->getX();
-        x1 = destiny->getParent()->getX();
-        y2 = GeneDestiny->getY();
-        y1 = destiny->getParent()->getY();
+        x2 = geneLayout(GeneDestiny).x;
+        x1 = speciesLayout(destiny->getParent()).x;
+        y2 = geneLayout(GeneDestiny).y;
+        y1 = speciesLayout(destiny->getParent()).y;
         slope = (y2 - y1) / (x2 - x1);      
         n1 = y1 - (slope * x1);
         y = (slope * destinyx) + n1;
 
-        cairo_move_to(cr,n->getX(),n->getY());
+        cairo_move_to(cr,geneLayout(n).x,geneLayout(n).y);
         cairo_line_to(cr,destinyx,y);
-        addEdge(origin,destiny,GeneOrigin,GeneDestiny,n->getX(),n->getY(),destinyx,y,Edge::LGT);
-        cairo_line_to(cr,GeneDestiny->getX(),GeneDestiny->getY());
-        addEdge(origin,destiny,GeneOrigin,GeneDestiny,destinyx,y,GeneDestiny->getX(),GeneDestiny->getY(),Edge::LGT);
+        addEdge(origin,destiny,GeneOrigin,GeneDestiny,geneLayout(n).x,geneLayout(n).y,destinyx,y,Edge::LGT);
+        cairo_line_to(cr,geneLayout(GeneDestiny).x,geneLayout(GeneDestiny).y);
+        addEdge(origin,destiny,GeneOrigin,GeneDestiny,destinyx,y,geneLayout(GeneDestiny).x,geneLayout(GeneDestiny).y,Edge::LGT);
     }
     else
     {
@@ -1025,7 +1045,7 @@ void DrawTreeCairo::newLGTPath(Node *n)
         origin->getParent()->getRightChild() : origin->getParent()->getLeftChild();  
         destinyx = originx;
                 
-        cairo_move_to(cr,GeneDestiny->getX(),GeneDestiny->getY());
+        cairo_move_to(cr,geneLayout(GeneDestiny).x,geneLayout(GeneDestiny).y);
         double xend = 0.0;
         double yend = 0.0;
         double xorigin = 0.0;
@@ -1033,18 +1053,18 @@ void DrawTreeCairo::newLGTPath(Node *n)
         
         for(Node *o = destiny; destiny != newdestiny && !destiny->isRoot(); destiny = destiny->getParent())
         {
-            double x = o->getParent()->getX();
-            double y = o->getParent()->getY();
+            double x = speciesLayout(o->getParent()).x;
+            double y = speciesLayout(o->getParent()).y;
             //TODO what if we have more LGT going trough this species node??
             const unsigned size = gamma->getSize(o->getParent()) + 1;
 
             if (size > 1)
             {
                 double delta = leafWidth / (size - 1);
-                y = ( o->getParent()->getY() - (leafWidth / 2) ) + ( o->getParent()->getVisited() * delta);
+                y = ( speciesLayout(o->getParent()).y - (leafWidth / 2) ) + ( speciesLayout(o->getParent()).visited * delta);
             }
             
-            o->getParent()->incVisited();
+            speciesLayout(o->getParent()).visited++;
             cairo_line_to(cr,x,y);
             xend = x;
             yend = y;
@@ -1053,18 +1073,18 @@ void DrawTreeCairo::newLGTPath(Node *n)
             yorigin = y;
         }
         
-        y1 = newdestiny->getParent()->getY();
+        y1 = speciesLayout(newdestiny->getParent()).y;
         y2 = yend;
-        x2 = newdestiny->getX();
-        x1 = newdestiny->getParent()->getX();
+        x2 = speciesLayout(newdestiny).x;
+        x1 = speciesLayout(newdestiny->getParent()).x;
         slope = (y2 - y1) / (x2 - x1);      
         n1 = y1 - (slope * x1);
         y = (slope * destinyx) + n1;
         
         cairo_line_to(cr,destinyx,y);
         addEdge(origin,destiny,GeneOrigin,GeneDestiny,xend,yend,destinyx,y,Edge::LGT);
-        cairo_line_to(cr,n->getX(),n->getY());
-        addEdge(origin,destiny,GeneOrigin,GeneDestiny,destinyx,y,n->getX(),n->getY(),Edge::LGT);
+        cairo_line_to(cr,geneLayout(n).x,geneLayout(n).y);
+        addEdge(origin,destiny,GeneOrigin,GeneDestiny,destinyx,y,geneLayout(n).x,geneLayout(n).y,Edge::LGT);
     }
 }
 
@@ -1074,7 +1094,7 @@ Node* DrawTreeCairo::getHighestMappedLGT(Node *n) const
 {
     Node *parent = n->getParent();
 
-    while(parent->getReconcilation() == Node::LateralTransfer && !parent->isRoot())
+    while(geneLayout(parent).reconcilation == NodeLayout::LateralTransfer && !parent->isRoot())
     {
         parent = parent->getParent();
     }
@@ -1090,7 +1110,7 @@ Node* DrawTreeCairo::getLowestMappedLGT(Node *n) const
 {
     Node *left = n->getLeftChild();
     Node *right = n->getRightChild();
-    Node *child = n->getHostChild();
+    Node *child = geneLayout(n).hostChild;
     Node *son;
 
     if ((*lambda)[right] == child)
@@ -1101,7 +1121,7 @@ Node* DrawTreeCairo::getLowestMappedLGT(Node *n) const
     {
         son = left;
     }
-    while(son->getReconcilation() == Node::LateralTransfer && !son->isLeaf())
+    while(geneLayout(son).reconcilation == NodeLayout::LateralTransfer && !son->isLeaf())
     {
         if ((*lambda)[son->getRightChild()] == child)
         {
@@ -1119,7 +1139,7 @@ Node* DrawTreeCairo::getLowestMappedNOLGT(Node *n) const
 {
     Node *left = n->getLeftChild();
     Node *right = n->getRightChild();
-    Node *child = n->getHostParent();
+    Node *child = geneLayout(n).hostParent;
     Node *son;
 
     if ((*lambda)[right] == child)
@@ -1130,7 +1150,7 @@ Node* DrawTreeCairo::getLowestMappedNOLGT(Node *n) const
     {
         son = left;
     }
-    while(son->getReconcilation() == Node::LateralTransfer && !son->isLeaf())
+    while(geneLayout(son).reconcilation == NodeLayout::LateralTransfer && !son->isLeaf())
     {
         if ((*lambda)[son->getRightChild()] == child)
         {
@@ -1195,8 +1215,8 @@ pair<Node*,pair<double,double> > DrawTreeCairo::getOriginLGT(Node *n)
 {
     //TODO REDO THIS FUNCTION either using a more robust geometric approach or using LGT origin times
 
-    Node *origin = n->getHostChild();
-    Node *destiny = n->getHostParent();
+    Node *origin = geneLayout(n).hostChild;
+    Node *destiny = geneLayout(n).hostParent;
 
     Node *GeneOrigin = getLowestMappedLGT(n); 
     Node *GeneDestiny = getLowestMappedNOLGT(n);
@@ -1204,24 +1224,24 @@ pair<Node*,pair<double,double> > DrawTreeCairo::getOriginLGT(Node *n)
     Node *originbound = (*lambda)[nparent];
 
     double destinyx;
-    double originx = (GeneDestiny->getX() + destiny->getParent()->getX()) / 2;
+    double originx = (geneLayout(GeneDestiny).x + speciesLayout(destiny->getParent()).x) / 2;
 
-    while((originx > ( origin->getX() - (leafWidth / 4) ) && originx > ( destiny->getParent()->getX() + ( leafWidth / 4) ))
+    while((originx > ( speciesLayout(origin).x - (leafWidth / 4) ) && originx > ( speciesLayout(destiny->getParent()).x + ( leafWidth / 4) ))
         || (existLGTEdge(originx) || overlapSpeciesNode(originx,origin,destiny)))
     {
         originx -= (parameters->linewidth * 5);
     }
 
-    while((originx < ( originbound->getX() + (leafWidth / 4) ) && originx < ( GeneDestiny->getX() - (leafWidth / 4) ))
+    while((originx < ( speciesLayout(originbound).x + (leafWidth / 4) ) && originx < ( geneLayout(GeneDestiny).x - (leafWidth / 4) ))
         || (existLGTEdge(originx) || overlapSpeciesNode(originx,origin,destiny)))
     {
         originx += (parameters->linewidth * 5);
     }
 
-    if (originx < originbound->getX() || originx > origin->getX() )
+    if (originx < speciesLayout(originbound).x || originx > speciesLayout(origin).x )
     {
-        originx = (origin->getX() + origin->getParent()->getX()) / 2; 
-        originx = (origin->getX() + originx) / 2;
+        originx = (speciesLayout(origin).x + speciesLayout(origin->getParent()).x) / 2; 
+        originx = (speciesLayout(origin).x + originx) / 2;
         destinyx = -1;
         
         while(existLGTEdge(originx) || overlapSpeciesNode(originx,origin,destiny))
@@ -1231,7 +1251,7 @@ pair<Node*,pair<double,double> > DrawTreeCairo::getOriginLGT(Node *n)
     }
     else
     {
-        while(originx < origin->getParent()->getX())
+        while(originx < speciesLayout(origin->getParent()).x)
         {
             origin = origin->getParent();
         }
@@ -1243,15 +1263,15 @@ pair<Node*,pair<double,double> > DrawTreeCairo::getOriginLGT(Node *n)
 
 bool DrawTreeCairo::overlapSpeciesNode(double x,Node *origin, Node *destiny) const
 {
-    const double y1 = (origin->getY() + origin->getParent()->getY()) / 2;
-    const double y2 = (destiny->getY() + destiny->getParent()->getY()) / 2;
+    const double y1 = (speciesLayout(origin).y + speciesLayout(origin->getParent()).y) / 2;
+    const double y2 = (speciesLayout(destiny).y + speciesLayout(destiny->getParent()).y) / 2;
 
     for(Node *n = species->postorder_begin(); n != 0; n = species->postorder_next(n))
     {
         if (n != destiny && !n->isLeaf())
         {
-            if ( (x >= (n->getX() - (leafWidth*0.3))) && (x <= (n->getX() + (leafWidth*0.3)))
-                && n->getY() >= y1 && n->getY() <= y2) 
+            if ( (x >= (speciesLayout(n).x - (leafWidth*0.3))) && (x <= (speciesLayout(n).x + (leafWidth*0.3)))
+                && speciesLayout(n).y >= y1 && speciesLayout(n).y <= y2) 
             {
                 return true;
             }
@@ -47,6 +47,9 @@
 class Node;
 class TreeExtended;
 class Parameters;
+class LayoutBuffer;
+class TreeLayout;
+struct NodeLayout;
 
 using namespace std;
 
@@ -67,12 +70,13 @@ class DrawTreeCairo
     
 public:
     
-    // constructor, parameters in constant, the trees are going to be modified
-    // the gamma object is constant and the cairo object is optional
+    // constructor, parameters in constant, the layout is going to be modified
+    // the trees and the gamma object are constant and the cairo object is optional
     DrawTreeCairo();
     
     void start(const Parameters *p, TreeExtended *g, TreeExtended *s,
-               const GammaMapEx *ga,const LambdaMapEx *la, cairo_t* cr_ = 0);
+               const GammaMapEx *ga,const LambdaMapEx *la, LayoutBuffer *l,
+               cairo_t* cr_ = 0);
     
     void cleanUp();
     
@@ -140,6 +144,10 @@ private:
 
     // this function converts double to string
     string double2charp(const double &x);
+
+    // the layout of a species or gene node
+    NodeLayout& speciesLayout(const Node *n) const;
+    NodeLayout& geneLayout(const Node *n) const;
     
     // this function is a helper function to draw the gene edges
     // it draws all the edges that are not Laterl Transfer
@@ -205,6 +213,8 @@ private:
     TreeExtended *gene;
     TreeExtended *species;
     const GammaMapEx *gamma;
+    TreeLayout *slayout;
+    TreeLayout *glayout;
     Colours *config;
     
     //Cairo objects
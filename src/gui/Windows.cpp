@@ -31,6 +31,7 @@
 #include <QTemporaryFile>
 #include <QShortcut>
 #include <QStyle>
+#include <QProgressDialog>
 #if defined Q_OS_WIN
 #include <windows.h>
 #include "qt_windows.h"
@@ -211,8 +212,52 @@ void MainWindow::generateTree()
 
             if (parameters->lattransfer)
             {
-                ops->lateralTransfer(mapfile.toStdString(),(parameters->lateralmincost == 1.0
-                                                            && parameters->lateralmaxcost == 1.0));
+                // the LGT computation can take long, keep the event loop alive
+                // and let the user cancel it
+                QProgressDialog dialog(tr("Computing LGT scenarios..."), tr("Cancel"), 0, 0, this);
+                dialog.setWindowModality(Qt::WindowModal);
+                dialog.setMinimumDuration(500);
+                Progress progress;
+                progress.setObserver([&dialog](const Progress &p)
+                {
+                    if (p.getCellsTotal() > 0)
+                    {
+                        dialog.setMaximum(1000);
+                        dialog.setValue(static_cast<int>(1000.0 * p.getCellsDone() / p.getCellsTotal()));
+                    }
+                    else if (!dialog.isVisible())
+                    {
+                        // the FPT search has no known size, show a busy dialog
+                        dialog.setMaximum(0);
+                        dialog.show();
+                    }
+                    QString label = tr("Computing LGT scenarios (%1)...\n%2 scenarios found, %3 MB in use")
+                                    .arg(p.getStage())
+                                    .arg(p.getScenariosFound())
+                                    .arg(p.getMemoryInUse() / (1024.0 * 1024.0), 0, 'f', 1);
+                    if (p.getLayersDone() > 0)
+                    {
+                        // the anytime search already has these results
+                        label += tr("\n%1 scenarios with cost up to %2 are complete")
+                                 .arg(p.getLayerScenarios())
+                                 .arg(p.getLayerBound());
+                    }
+                    dialog.setLabelText(label);
+                    QApplication::processEvents();
+                });
+                connect(&dialog, &QProgressDialog::canceled, [&progress]() { progress.cancel(); });
+                ops->setProgress(&progress);
+                try
+                {
+                    ops->lateralTransfer(mapfile.toStdString(),(parameters->lateralmincost == 1.0
+                                                                && parameters->lateralmaxcost == 1.0));
+                }
+                catch (...)
+                {
+                    ops->setProgress(0);
+                    throw;
+                }
+                ops->setProgress(0);
             }
             
             ops->drawBest(); //draw tree into temp file
@@ -220,10 +265,22 @@ void MainWindow::generateTree()
             paintTree();
 
             actionSave->setEnabled(true);
-            statusBar()->showMessage(tr("Tree Generated"));
+            if (parameters->lattransfer)
+            {
+                statusBar()->showMessage(tr("Tree Generated, %1 distinct LGT scenarios computed for these trees")
+                                         .arg(ops->getUniqueScenarios().size()));
+            }
+            else
+            {
+                statusBar()->showMessage(tr("Tree Generated"));
+            }
         }
 
     }
+    catch(Progress::Cancelled &)
+    {
+        statusBar()->showMessage(tr("LGT computation cancelled"));
+    }
     catch(AnError &e)
     {
         QErrorMessage errorMessage;
@@ -681,6 +738,7 @@ void MainWindow::loadConfigFile()
             parameters->markers = config->read<bool>(string("mark"),false);
             parameters->ladd = config->read<char>(string("ladderize"),'n');
             parameters->isreconciled = config->read<bool>(string("reconcile"),false);
+            parameters->genesample = config->read<bool>(string("geneSample"),false);
             parameters->do_not_draw_guest_tree = config->read<bool>(string("noguest"),false);
             parameters->horiz = config->read<bool>(string("vertical"),true);
             parameters->header = config->read<bool>(string("header"),false);
@@ -700,6 +758,9 @@ void MainWindow::loadConfigFile()
             parameters->lateralduplicost = config->read<float>(string("lateralDupli"),float(1.0));
             parameters->lateraltrancost = config->read<float>(string("lateralLGT"),float(2.0));
             parameters->lateralmincost = config->read<float>(string("lateralMin"),float(1.0));
+            parameters->lateralanytime = config->read<bool>(string("lateralAnytime"),false);
+            parameters->lateralmaxscenarios = config->read<unsigned>(string("lateralMaxScenarios"),0);
+            parameters->lateraltimebudget = config->read<float>(string("lateralTimeBudget"),float(0.0));
             parameters->noTimeAnnotation = config->read<bool>(string("notime"),false);
             parameters->timeAtEdges = config->read<bool>(string("timeex"),false);
             parameters->speciesFontColor.blue = config->read<double>(string("speciesfontcolorB"),0.0);
@@ -748,6 +809,7 @@ void MainWindow::saveConfigFile()
             out.open(filename.toStdString().c_str(),ios::out);
 
             out << "reconcile" << " = " << parameters->isreconciled << endl;
+            out << "geneSample" << " = " << parameters->genesample << endl;
             out << "genefont" << " = " << parameters->gene_font << endl;
             out << "speciefont" << " = " << parameters->species_font << endl;
             out << "allfont" << " = " << parameters->all_font << endl;
@@ -767,6 +829,9 @@ void MainWindow::saveConfigFile()
             out << "lateralDupli" << " = " << parameters->lateralduplicost << endl;
             out << "lateralLGT" << " = " << parameters->lateraltrancost << endl;
             out << "lateralMin" << " = " << parameters->lateralmincost << endl;
+            out << "lateralAnytime" << " = " << parameters->lateralanytime << endl;
+            out << "lateralMaxScenarios" << " = " << parameters->lateralmaxscenarios << endl;
+            out << "lateralTimeBudget" << " = " << parameters->lateraltimebudget << endl;
             out << "nohost" << " = " << parameters->do_not_draw_species_tree << endl;
             out << "inodes" << " = " << parameters->ids_on_inner_nodes << endl;
             out << "color" << " = " << parameters->colorConfig->getSet() << endl;
@@ -0,0 +1,111 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+#include "LayoutBuffer.h"
+
+#include "../tree/Treeextended.h"
+#include "../tree/Node.h"
+
+NodeLayout::NodeLayout()
+    :x(0.0),
+      y(0.0),
+      hostParent(0),
+      hostChild(0),
+      reconcilation(Undefined),
+      visited(0),
+      rotated(false)
+{
+
+}
+
+TreeLayout::TreeLayout(const TreeExtended &tree)
+    :nodes(tree.getNumberOfNodes())
+{
+
+}
+
+TreeLayout::~TreeLayout()
+{
+
+}
+
+NodeLayout& TreeLayout::operator[](const Node *n)
+{
+    return nodes[n->getNumber()];
+}
+
+const NodeLayout& TreeLayout::operator[](const Node *n) const
+{
+    return nodes[n->getNumber()];
+}
+
+Node* TreeLayout::getLeftChild(const Node *n) const
+{
+    return nodes[n->getNumber()].rotated ? n->getRightChild() : n->getLeftChild();
+}
+
+Node* TreeLayout::getRightChild(const Node *n) const
+{
+    return nodes[n->getNumber()].rotated ? n->getLeftChild() : n->getRightChild();
+}
+
+void TreeLayout::rotate(const Node *n)
+{
+    nodes[n->getNumber()].rotated = !nodes[n->getNumber()].rotated;
+}
+
+unsigned TreeLayout::size() const
+{
+    return nodes.size();
+}
+
+LayoutBuffer::LayoutBuffer(const TreeExtended &species, const TreeExtended &gene)
+    :speciesLayout(species),
+      geneLayout(gene)
+{
+
+}
+
+LayoutBuffer::~LayoutBuffer()
+{
+
+}
+
+TreeLayout& LayoutBuffer::getSpeciesLayout()
+{
+    return speciesLayout;
+}
+
+const TreeLayout& LayoutBuffer::getSpeciesLayout() const
+{
+    return speciesLayout;
+}
+
+TreeLayout& LayoutBuffer::getGeneLayout()
+{
+    return geneLayout;
+}
+
+const TreeLayout& LayoutBuffer::getGeneLayout() const
+{
+    return geneLayout;
+}
@@ -0,0 +1,108 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+/* LayoutBuffer holds the drawing state of one layout of a species and a gene
+ * tree, the cordinates, host species nodes, reconciliation type and visit
+ * counters of every node are stored in vectors indexed by the node numbers.
+ * LayoutTrees fills the buffer and DrawTreeCairo reads it (and adds the
+ * lateral transfer points), the trees are only read so several layouts of the
+ * same trees can be computed at the same time, each one with its own buffer.
+ * The ladderization is kept in the buffer as well, as a flag that swaps the
+ * children of a species node in the drawing order. */
+
+#ifndef LAYOUTBUFFER_H
+#define LAYOUTBUFFER_H
+
+#include <vector>
+
+class Node;
+class TreeExtended;
+
+using namespace std;
+
+struct NodeLayout
+{
+    enum Type{
+        Leaf = 0,
+        Speciation = 1,
+        Duplication = 2,
+        LateralTransfer = 3,
+        Undefined = 4
+    };
+
+    NodeLayout();
+
+    double x;
+    double y;
+    Node *hostParent;
+    Node *hostChild;
+    Type reconcilation;
+    unsigned visited;
+    bool rotated; // children swapped in the drawing order
+};
+
+class TreeLayout
+{
+
+public:
+
+    // one empty entry for every node of the tree
+    explicit TreeLayout(const TreeExtended &tree);
+    virtual ~TreeLayout();
+
+    NodeLayout& operator[](const Node *n);
+    const NodeLayout& operator[](const Node *n) const;
+
+    // children of n in the drawing order
+    Node* getLeftChild(const Node *n) const;
+    Node* getRightChild(const Node *n) const;
+
+    // swaps the drawing order of the children of n, the tree is not modified
+    void rotate(const Node *n);
+
+    unsigned size() const;
+
+private:
+
+    std::vector<NodeLayout> nodes;
+};
+
+class LayoutBuffer
+{
+
+public:
+
+    LayoutBuffer(const TreeExtended &species, const TreeExtended &gene);
+    virtual ~LayoutBuffer();
+
+    TreeLayout& getSpeciesLayout();
+    const TreeLayout& getSpeciesLayout() const;
+    TreeLayout& getGeneLayout();
+    const TreeLayout& getGeneLayout() const;
+
+private:
+
+    TreeLayout speciesLayout;
+    TreeLayout geneLayout;
+};
+
+#endif // LAYOUTBUFFER_H
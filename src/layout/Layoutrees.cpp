@@ -25,6 +25,7 @@
 #include "../tree/Treeextended.h"
 #include "../Parameters.h"
 #include "../tree/Node.h"
+#include "LayoutBuffer.h"
 
 static bool sort_double(const double u, const double v)
 {
@@ -35,12 +36,15 @@ LayoutTrees::LayoutTrees(TreeExtended *r,
                          TreeExtended *g,
                          Parameters *p,
                          const GammaMapEx *gm,
-                         const LambdaMapEx *l)
+                         const LambdaMapEx *l,
+                         LayoutBuffer *lb)
     :species(r),
       gene(g),
       parameters(p),
       gamma(gm),
       lambda(l),
+      slayout(lb->getSpeciesLayout()),
+      glayout(lb->getGeneLayout()),
       bv(r->getNumberOfNodes()),
       Adress(g->getNumberOfNodes())
 {
@@ -182,12 +186,12 @@ double LayoutTrees::getRightMostCoordinate (Node* o) const
 {
     if (o->isLeaf())
     {
-        return o->getY();
+        return slayout[o].y;
     }
     
     else
     {
-        return getRightMostCoordinate(o->getRightChild());
+        return getRightMostCoordinate(slayout.getRightChild(o));
     }
 }
 
@@ -195,12 +199,12 @@ double LayoutTrees::getLeftMostCoordinate (Node* o) const
 {
     if(o->isLeaf())
     {
-        return o->getY();
+        return slayout[o].y;
     }
     
     else
     {
-        return getLeftMostCoordinate(o->getRightChild());
+        return getLeftMostCoordinate(slayout.getRightChild(o));
     }
 }
 
@@ -213,16 +217,16 @@ void LayoutTrees::CountSpeciesCoordinates(Node *n, unsigned depth)
 {
     if (n->isLeaf())
     {
-        n->setY(currentY);
+        slayout[n].y = currentY;
         currentY -= yspace;
         //x is equal to the size of the drawin canvas for x plus the root node
         //drawing size but no the separation
-        n->setX(XCanvasSize + xCanvasXtra);
+        slayout[n].x = XCanvasSize + xCanvasXtra;
     }
     else
     {
-        Node *left = n->getLeftChild();
-        Node *right = n->getRightChild();
+        Node *left = slayout.getLeftChild(n);
+        Node *right = slayout.getRightChild(n);
 
         CountSpeciesCoordinates(left, depth + 1);
         CountSpeciesCoordinates(right, depth + 1);
@@ -245,8 +249,8 @@ void LayoutTrees::CountSpeciesCoordinates(Node *n, unsigned depth)
         {
             xposition = numXPositions.at(depth) + xCanvasXtra;
         }
-        n->setY(yposition);
-        n->setX(xposition);
+        slayout[n].y = yposition;
+        slayout[n].x = xposition;
         CalcLegIntersection(left,right,n);
     }
     
@@ -272,34 +276,35 @@ unsigned LayoutTrees::MostGenes() const
 void LayoutTrees::AssignLeafGene(Node *n)
 {
     Node *spn = gamma->getLowestGammaPath(*n);
-    n->setX(spn->getX());
+    NodeLayout &nl = glayout[n];
+    nl.x = slayout[spn].x;
     double y;
     const unsigned size = gamma->getSize(spn);
     
     if(size > 1)
     {
-        const unsigned yoffset = spn->getVisited();
+        const unsigned yoffset = slayout[spn].visited;
         const unsigned delta = NodeHeight / (size - 1);
-        y = (spn->getY() - (NodeHeight / 2) ) + (delta * yoffset);
+        y = (slayout[spn].y - (NodeHeight / 2) ) + (delta * yoffset);
     }
     else
     {
-        y = spn->getY();
+        y = slayout[spn].y;
     }
     
-    spn->incVisited();
-    n->setY(y);
-    n->setHostChild(spn);
+    slayout[spn].visited++;
+    nl.y = y;
+    nl.hostChild = spn;
     
     if (!n->isRoot() && gamma->isLateralTransfer(*n->getParent())
             && ((*lambda)[n] == (*lambda)[n->getParent()]))
     {
         Node *destiny = (*lambda)[getHighestMappedLGT(n)];
-        n->setHostParent(destiny);
+        nl.hostParent = destiny;
     }
     else
     {
-        n->setHostParent(spn);
+        nl.hostParent = spn;
     }
 }
 
@@ -307,7 +312,7 @@ void LayoutTrees::CountGeneCoordinates(Node* n)
 {
     if(n->isLeaf())
     {
-        n->setReconcilation(Node::Leaf);
+        glayout[n].reconcilation = NodeLayout::Leaf;
         AssignLeafGene(n);
     }
     else
@@ -320,7 +325,7 @@ void LayoutTrees::CountGeneCoordinates(Node* n)
 
         if(gamma->isSpeciation(*n) && !gamma->isLateralTransfer(*n)) //speciation
         {
-            n->setReconcilation(Node::Speciation);
+            glayout[n].reconcilation = NodeLayout::Speciation;
             AssignLeafGene(n);
         }
         else if (gamma->isLateralTransfer(*n)) //lateral transfer
@@ -337,19 +342,20 @@ void LayoutTrees::CountGeneCoordinates(Node* n)
 void LayoutTrees::AssignGeneDuplication(Node *n)
 {
     Node *spb = Adress[n];
+    NodeLayout &nl = glayout[n];
     double proportion = 0;
     double delta = 0;
     double edge = 0;
     if (!spb->isRoot())
     {
         Node *spbP = spb->getParent();
-        edge = spb->getX() - spbP->getX();
-        proportion = ((spbP->getY() - spb->getY()) / edge);
-        n->setHostParent(spbP);
+        edge = slayout[spb].x - slayout[spbP].x;
+        proportion = ((slayout[spbP].y - slayout[spb].y) / edge);
+        nl.hostParent = spbP;
     }
     else
     {
-        edge = spb->getX();
+        edge = slayout[spb].x;
     }
     
     // we obtain the number of duplication and the duplications levels
@@ -359,19 +365,20 @@ void LayoutTrees::AssignGeneDuplication(Node *n)
     const unsigned duplilevel = Duplevel(n,spb->getNumber());
     delta = (edge/ndupli) * duplilevel;
     
-    n->setX(spb->getX()-delta);
+    nl.x = slayout[spb].x - delta;
     
     const double rightMost = RightMostCoordinate(n,spb,duplilevel);
     const double leftMost = LeftMostCoordinate(n,spb,duplilevel);
 
-    n->setY( ((rightMost + leftMost) /2) + (proportion * delta) );
-    n->setReconcilation(Node::Duplication);
-    n->setHostChild(spb);
+    nl.y = ((rightMost + leftMost) /2) + (proportion * delta);
+    nl.reconcilation = NodeLayout::Duplication;
+    nl.hostChild = spb;
 }
 
 void LayoutTrees::AssignGeneLGT(Node *n)
 {
-    n->setReconcilation(Node::LateralTransfer);
+    NodeLayout &nl = glayout[n];
+    nl.reconcilation = NodeLayout::LateralTransfer;
     
     Node *SoriginLT = (*lambda)[n];
     Node *SdestinyLT = (*lambda)[n->getLeftChild()];
@@ -381,8 +388,8 @@ void LayoutTrees::AssignGeneLGT(Node *n)
         SdestinyLT = (*lambda)[n->getRightChild()];
     }
     
-    n->setHostParent(SdestinyLT);
-    n->setHostChild(SoriginLT);
+    nl.hostParent = SdestinyLT;
+    nl.hostChild = SoriginLT;
 }
 
 Node*
@@ -477,12 +484,12 @@ LayoutTrees::LeftMostCoordinate(Node* o, Node *end_of_slice, unsigned duplevel)
         {
             double size = gamma->getSize(end_of_slice);
             double delta = NodeHeight / (size - 1);
-            double y = (end_of_slice->getY() - (NodeHeight /2) ) + (duplevel * delta);
+            double y = (slayout[end_of_slice].y - (NodeHeight /2) ) + (duplevel * delta);
             return y;
         }
         else
         {
-            return o->getY();
+            return glayout[o].y;
         }
     }
     else
@@ -495,7 +502,7 @@ LayoutTrees::LeftMostCoordinate(Node* o, Node *end_of_slice, unsigned duplevel)
         {
             double size = gamma->getSize(end_of_slice);
             double delta = NodeHeight / (size - 1);
-            double y = (end_of_slice->getY() - (NodeHeight / 2)) + (duplevel * delta);
+            double y = (slayout[end_of_slice].y - (NodeHeight / 2)) + (duplevel * delta);
             return y;
         }
     }
@@ -511,12 +518,12 @@ LayoutTrees::RightMostCoordinate (Node* o, Node *end_of_slice, unsigned duplevel
         {
             double size = gamma->getSize(end_of_slice);
             double delta = NodeHeight / size - 1;
-            double y = (end_of_slice->getY() - (NodeHeight / 2)) + (duplevel * delta);
+            double y = (slayout[end_of_slice].y - (NodeHeight / 2)) + (duplevel * delta);
             return y;
         }
         else
         {
-            return o->getY();
+            return glayout[o].y;
         }
     }
     else
@@ -529,7 +536,7 @@ LayoutTrees::RightMostCoordinate (Node* o, Node *end_of_slice, unsigned duplevel
         {
             double size = gamma->getSize(end_of_slice);
             double delta = NodeHeight / size - 1;
-            double y = (end_of_slice->getY() - (NodeHeight / 2)) + (duplevel * delta);
+            double y = (slayout[end_of_slice].y - (NodeHeight / 2)) + (duplevel * delta);
             return y; ;
         }
     }
@@ -546,23 +553,23 @@ LayoutTrees::Ladderize_left() const
     return Ladderize_left(species->getRootNode());
 }
 
+// The rotations only swap the drawing order of the children in the layout,
+// the species tree itself is left as it is
 unsigned
 LayoutTrees::Ladderize_left(Node* n) const
 {
-    if(n->isLeaf())
-    {
-        return 1;
-    }
-    else
+    const std::vector<unsigned> leaves = subtreeLeaves(n);
+    // nodes outside the subtree of n have no leaves counted
+    for(unsigned i = 0; i < leaves.size(); i++)
     {
-        unsigned leftsize = Ladderize_left(n->getLeftChild());
-        unsigned rightsize = Ladderize_left(n->getRightChild());
-        if(leftsize > rightsize)
+        Node *v = species->getNode(i);
+        if(leaves[i] > 1 &&
+                leaves[slayout.getLeftChild(v)->getNumber()] > leaves[slayout.getRightChild(v)->getNumber()])
         {
-            n->rotate();
+            slayout.rotate(v);
         }
-        return leftsize + rightsize;
     }
+    return leaves[n->getNumber()];
 }
 
 unsigned
@@ -574,20 +581,32 @@ LayoutTrees::Ladderize_right() const
 unsigned
 LayoutTrees::Ladderize_right(Node* n) const
 {
-    if(n->isLeaf())
+    const std::vector<unsigned> leaves = subtreeLeaves(n);
+    for(unsigned i = 0; i < leaves.size(); i++)
     {
-        return 1;
-    }
-    else
-    {
-        unsigned leftsize = Ladderize_right(n->getLeftChild());
-        unsigned rightsize = Ladderize_right(n->getRightChild());
-        if(rightsize > leftsize)
+        Node *v = species->getNode(i);
+        if(leaves[i] > 1 &&
+                leaves[slayout.getRightChild(v)->getNumber()] > leaves[slayout.getLeftChild(v)->getNumber()])
         {
-            n->rotate();
+            slayout.rotate(v);
         }
-        return leftsize + rightsize;
     }
+    return leaves[n->getNumber()];
+}
+
+// number of leaves below each node of the subtree of n, indexed by node number
+std::vector<unsigned>
+LayoutTrees::subtreeLeaves(Node *n) const
+{
+    std::vector<unsigned> leaves(species->getNumberOfNodes(), 0);
+    const unsigned first = species->dfs_entry(n->getNumber());
+    const unsigned last = species->dfs_exit(n->getNumber());
+    for(unsigned i = first; i <= last; i++)
+    {
+        Node *v = species->getNode(species->preorder()[i]);
+        leaves[v->getNumber()] = v->getNumberOfLeaves();
+    }
+    return leaves;
 }
 
 
@@ -596,17 +615,17 @@ LayoutTrees::CalcLegIntersection(Node *left, Node *right, Node *u)
 {
     double x0, y0, x1, y1, x2, y2, x3, y3;
 
-    x0 = left->getX();
-    y0 = left->getY() - NodeHeight;
+    x0 = slayout[left].x;
+    y0 = slayout[left].y - NodeHeight;
 
-    x1 = u->getX();
-    y1 = u->getY() - NodeHeight;
+    x1 = slayout[u].x;
+    y1 = slayout[u].y - NodeHeight;
 
-    x2 = right->getX();
-    y2 = right->getY() + NodeHeight;
+    x2 = slayout[right].x;
+    y2 = slayout[right].y + NodeHeight;
 
-    x3 = u->getX();
-    y3 = u->getY() + NodeHeight;
+    x3 = slayout[u].x;
+    y3 = slayout[u].y + NodeHeight;
     
     // The slants of the two lines
     double k_L = (y1 - y0) / (x1 - x0);
@@ -615,8 +634,8 @@ LayoutTrees::CalcLegIntersection(Node *left, Node *right, Node *u)
     double D_R = (y3 - y0 - k_L * (x3 - x0)) / (k_L - k_R);
     double D_L = x3 + D_R - x0;
 
-    u->setX(x0 + D_L);
-    u->setY(y0 + k_L * D_L);
+    slayout[u].x = x0 + D_L;
+    slayout[u].y = y0 + k_L * D_L;
 }
 
 //get the highest not LGT mapped node of n
@@ -673,12 +692,8 @@ void LayoutTrees::replaceNodes(const std::map<unsigned,unsigned>& replacements)
         if(first && second)
         {
             //HostParent and HostChild should not change
-            double temp_x = first->getX();
-            double temp_y = first->getY();
-            first->setX(second->getX());
-            first->setY(second->getY());
-            second->setX(temp_x);
-            second->setY(temp_y);
+            std::swap(glayout[first].x, glayout[second].x);
+            std::swap(glayout[first].y, glayout[second].y);
         }
     }
 }
@@ -20,7 +20,7 @@
 */
 
 /* this class calculates all the information needed to draw the trees, it calculates
- * all the node cordinates and assign them to the nodes, it also calculates the most important
+ * all the node cordinates and stores them in the LayoutBuffer given, it also calculates the most important
  * information needed to draw, it uses the tree size and the dimensions of the picture to calculate
  * all the cordinates and it does it dinamically according to the dimensions, it also increments the size
  * of the picture if the size is too small to fit the tree*/
@@ -33,6 +33,8 @@
 class Parameters;
 class TreeExtended;
 class Node;
+class LayoutBuffer;
+class TreeLayout;
 
 using namespace std;
 
@@ -41,10 +43,11 @@ class LayoutTrees
 
 public:
 
-    // constructor : gene tree, species tree and parameters are going to be modified
+    // constructor : the parameters and the layout buffer are going to be modified,
+    // the trees are only read
     LayoutTrees(TreeExtended *r,TreeExtended *g,
                 Parameters *p,const GammaMapEx *gm,
-                const LambdaMapEx *l);
+                const LambdaMapEx *l, LayoutBuffer *lb);
     
     void start();
     
@@ -53,18 +56,21 @@ public:
     double getNodeHeight();
     
     // this functions takes a map of node->node and replaces their cordinates in
-    // the gene tree
+    // the gene tree layout
     void replaceNodes(const std::map<unsigned,unsigned> &replacements);
     
 private:
 
-    // this function ladderize the tree to the right, it swapes the nodes
+    // this function ladderize the tree to the right, it swapes the nodes in the layout
     unsigned Ladderize_right() const;
     unsigned Ladderize_right(Node *n) const;
     
     // the same to the left
     unsigned Ladderize_left() const;
     unsigned Ladderize_left(Node *n) const;
+
+    // number of leaves below every node of the subtree of n
+    std::vector<unsigned> subtreeLeaves(Node *n) const;
     
     // this function calculates the Species node cordinates using three different time approaches
     void CountSpeciesCoordinates(Node *n, unsigned depth);
@@ -137,8 +143,10 @@ private:
     Parameters *parameters;
     const GammaMapEx *gamma;
     const LambdaMapEx *lambda;
-    BeepVector<unsigned> bv;
-    BeepVector<Node*> Adress;
+    TreeLayout &slayout;
+    TreeLayout &glayout;
+    NodeMap<unsigned> bv;
+    NodeMap<Node*> Adress;
     
     double NodeHeight;
     double yspace;
@@ -34,6 +34,9 @@
 
 #include "Phyltr.h"
 #include "../tree/Node.h"
+#include "ScenarioSet.h"
+#include "../utils/AnError.h"
+#include "../utils/InputFile.h"
 
 using namespace std;
 
@@ -42,10 +45,148 @@ ProgramInput Phyltr::g_input;
 vector<Scenario> Phyltr::scenarios;
 const cost_type COST_INF = numeric_limits<cost_type>::infinity();
 
+Phyltr::Phyltr()
+    :progress(0),
+      unique_scenarios(0),
+      scenario_memory(0)
+{
+
+}
+
+void Phyltr::set_progress(Progress *p)
+{
+    progress = p;
+}
+
+void Phyltr::set_unique_scenarios(ScenarioSet *set)
+{
+    unique_scenarios = set;
+}
+
+size_t Phyltr::memory_in_use() const
+{
+    return (g_below.num_elements() + g_outside.num_elements()) * sizeof(cost_type) +
+            g_backtrack_matrix.num_elements() * sizeof(BacktrackElement) +
+            scenario_memory;
+}
+
+size_t scenario_bytes(const Scenario &sc)
+{
+    return sizeof(Scenario) +
+            (sc.duplications.capacity() + sc.transfer_edges.capacity()) * sizeof(vid_t);
+}
+
+size_t scenario_bytes(const vector<Scenario> &scenarios)
+{
+    size_t bytes = (scenarios.capacity() - scenarios.size()) * sizeof(Scenario);
+    BOOST_FOREACH (const Scenario &sc, scenarios)
+    {
+        bytes += scenario_bytes(sc);
+    }
+    return bytes;
+}
+
 void Phyltr::fpt_algorithm()
 {
-    typedef std::shared_ptr<Candidate> cand_ptr;
     scenarios.clear();
+    scenario_memory = 0;
+    if (progress)
+    {
+        progress->setScenarios(0);
+    }
+    fpt_search(g_input.min_cost, g_input.max_cost, scenarios);
+    scenario_memory = scenario_bytes(scenarios);
+    if (unique_scenarios)
+    {
+        unique_scenarios->insert(scenarios);
+    }
+}
+
+void Phyltr::fpt_anytime(double step, unsigned max_scenarios, double max_seconds,
+                         const LayerCallback &on_layer)
+{
+    typedef std::chrono::steady_clock clock_type;
+    scenarios.clear();
+    scenario_memory = 0;
+
+    if (step <= 0.0)
+    {
+        step = min(g_input.duplication_cost, g_input.transfer_cost);
+    }
+
+    if (progress)
+    {
+        progress->setScenarios(0);
+    }
+
+    clock_type::time_point start = clock_type::now();
+    clock_type::time_point deadline = clock_type::time_point::max();
+    if (max_seconds > 0.0)
+    {
+        deadline = start + std::chrono::duration_cast<clock_type::duration>(
+                    std::chrono::duration<double>(max_seconds));
+    }
+
+    // The cheapest possible scenario only has the forced duplications
+    // of the initial candidate, so there is no point in starting lower.
+    // With free events every bound contains all the scenarios, they
+    // form a single layer up to max_cost.
+    double bound = step > 0.0 ? Candidate().cost() : g_input.max_cost;
+    double previous = -1.0;
+    const double tolerance = 1e-6;
+
+    while (previous + tolerance < g_input.max_cost)
+    {
+        // Each layer only keeps the scenarios that are more expensive
+        // than the previous bound, the cheaper ones have been reported.
+        vector<Scenario> layer;
+        const double layer_min = max(g_input.min_cost, previous + tolerance);
+        const double layer_max = min(bound + tolerance, g_input.max_cost);
+        bool complete = false;
+        try
+        {
+            complete = fpt_search(layer_min, layer_max, layer, &deadline);
+        }
+        catch (const Progress::Cancelled &)
+        {
+            complete = false;
+        }
+        if (!complete)
+        {
+            // the layer was interrupted, only complete layers are reported
+            break;
+        }
+
+        scenarios.insert(scenarios.end(), layer.begin(), layer.end());
+        scenario_memory += scenario_bytes(layer);
+        if (unique_scenarios)
+        {
+            unique_scenarios->insert(layer);
+        }
+        if (on_layer)
+        {
+            on_layer(layer_max, layer);
+        }
+        if (progress)
+        {
+            progress->completeLayer(layer_max, scenarios.size());
+        }
+
+        if ((max_scenarios > 0 && scenarios.size() >= max_scenarios) ||
+                clock_type::now() >= deadline)
+        {
+            break;
+        }
+
+        previous = bound;
+        bound += step;
+    }
+}
+
+bool Phyltr::fpt_search(double min_cost, double max_cost, vector<Scenario> &found,
+                        const std::chrono::steady_clock::time_point *deadline)
+{
+    typedef std::shared_ptr<Candidate> cand_ptr;
 
     // We will do a depth first search, so we need a stack.
     stack<cand_ptr> cand_stack;
@@ -53,7 +194,7 @@ void Phyltr::fpt_algorithm()
     // Push the initial candidate onto the stack. Note that the
     // initial candidate may have some duplications set already!
     cand_ptr initial_candidate(new Candidate);
-    if (initial_candidate->cost() <= g_input.max_cost)
+    if (initial_candidate->cost() <= max_cost)
     {
         cand_stack.push(initial_candidate);
     }
@@ -61,11 +202,37 @@ void Phyltr::fpt_algorithm()
     // Do the depth-first search.
     //unsigned gene_tree_size = g_input.gene_tree->size();
     unsigned gene_tree_size = g_input.gene_tree->getNumberOfNodes();
+    unsigned long visited = 0;
+    size_t found_bytes = 0;   // bytes of the scenarios added to found
+    const size_t candidate_bytes = sizeof(Candidate) + gene_tree_size * (5 * sizeof(vid_t) + 1);
+
+    if (progress)
+    {
+        progress->startStage("fpt", 0);
+    }
     
     while (!cand_stack.empty())
     {
-        cand_ptr cp = cand_stack.top(); cand_stack.pop();
+        // looking at the clock is not free, do it every now and then
+        if ((++visited & 0x3ff) == 0)
+        {
+            if (deadline != 0 && std::chrono::steady_clock::now() >= *deadline)
+            {
+                return false;
+            }
+            if (progress)
+            {
+                progress->setMemory(memory_in_use() + found_bytes +
+                                    cand_stack.size() * candidate_bytes);
+            }
+        }
+        if (progress)
+        {
+            progress->addCells(1);
+            progress->poll();
+        }
 
+        cand_ptr cp = cand_stack.top(); cand_stack.pop();
 
         vid_t s_move = cp->get_s_move();
         double cp_cost = cp->cost();
@@ -73,29 +240,29 @@ void Phyltr::fpt_algorithm()
         if (s_move != NONE)
         {
             // Resvole the s-move in three ways.
-            if (cp_cost + g_input.duplication_cost <= g_input.max_cost)
+            if (cp_cost + g_input.duplication_cost <= max_cost)
             {
                 cand_ptr cp1(new Candidate(*cp));
                 cp1->set_duplication(cp->parent(s_move));
-                if (cp1->cost() <= g_input.max_cost)
+                if (cp1->cost() <= max_cost)
                 {
                     cand_stack.push(cp1);
                 }
             }
 
-            if (cp_cost + g_input.transfer_cost <= g_input.max_cost)
+            if (cp_cost + g_input.transfer_cost <= max_cost)
             {
                 cand_ptr cp2(new Candidate(*cp));
                 cand_ptr cp3(new Candidate(*cp));
 
-                cp2->set_transfer_edge(g_input.gene_tree->getNode(s_move)->getLeftChild()->getNumber());
-                cp3->set_transfer_edge(g_input.gene_tree->getNode(s_move)->getRightChild()->getNumber());
+                cp2->set_transfer_edge(g_input.gene_tree->left(s_move));
+                cp3->set_transfer_edge(g_input.gene_tree->right(s_move));
 
-                if (cp2->cost() <= g_input.max_cost)
+                if (cp2->cost() <= max_cost)
                 {
                     cand_stack.push(cp2);
                 }
-                if (cp3->cost() <= g_input.max_cost)
+                if (cp3->cost() <= max_cost)
                 {
                     cand_stack.push(cp3);
                 }
@@ -105,21 +272,20 @@ void Phyltr::fpt_algorithm()
         {
             // Insert elegant final candidates with cost in
             // the given range into the return-vector.
-            if (cp->cost() >= g_input.min_cost &&
-                    cp->cost() <= g_input.max_cost &&
+            if (cp->cost() >= min_cost &&
+                    cp->cost() <= max_cost &&
                     cp->is_elegant())
             {
-                Scenario sc(gene_tree_size);
-                for (vid_t u = 0; u < gene_tree_size; ++u)
+                found.push_back(Scenario(*cp, gene_tree_size));
+                found_bytes += scenario_bytes(found.back());
+                if (progress)
                 {
-                    sc.duplications[u] = cp->is_duplication(u);
-                    sc.transfer_edges[u] = cp->is_transfer_edge(u);
-                    sc.cp.copy(new Candidate(*cp));
+                    progress->addScenarios(1);
                 }
-                scenarios.push_back(sc);
             }
         }
     }
+    return true;
 }
 
 void
@@ -189,6 +355,25 @@ bool Phyltr::read_sigma(map< string, string > str_sigma)
     return true;
 }
 
+bool Phyltr::read_sigma(const StrStrMap &gs)
+{
+    Phyltr::g_input.sigma.resize(g_input.gene_tree->getNumberOfNodes());
+    try
+    {
+        create_gene_species_map(*g_input.species_tree,
+                                *g_input.gene_tree,
+                                gs,
+                                g_input.sigma);
+    }
+    catch (logic_error &e)
+    {
+        print_error(e.what());
+        return false;
+    }
+
+    return true;
+}
+
 
 Scenario Phyltr::getMaxCostScenario()
 {
@@ -247,39 +432,16 @@ Scenario Phyltr::getMinCostScenario()
 ostream &
 operator<<(ostream &out, const Scenario &sc)
 {
-    vector<unsigned> transfer_edges;
-
-    for (vid_t u = 0; u < Phyltr::g_input.gene_tree->getNumberOfNodes(); ++u)
-    {
-        if (sc.transfer_edges[u])
-        {
-            transfer_edges.push_back(u);
-        }
-    }
-    
-    sort(transfer_edges.begin(), transfer_edges.end());
-    vector<unsigned> duplications;
-
-    for (vid_t u = 0; u < Phyltr::g_input.gene_tree->getNumberOfNodes(); ++u)
-    {
-        if (sc.duplications[u])
-        {
-            duplications.push_back(u);
-        }
-    }
-    
-    sort(duplications.begin(), duplications.end());
-
     out << "Transfer edges Numbers:\t";
-    copy(transfer_edges.begin(), transfer_edges.end(),
+    copy(sc.transfer_edges.begin(), sc.transfer_edges.end(),
          ostream_iterator<unsigned>(out, " "));
     out << "\nDuplications Numbers:\t";
-    copy(duplications.begin(), duplications.end(),
+    copy(sc.duplications.begin(), sc.duplications.end(),
          ostream_iterator<unsigned>(out, " "));
     out << "\nNumber of losses: " << count_losses(*Phyltr::g_input.species_tree,
                                                   *Phyltr::g_input.gene_tree,
                                                   Phyltr::g_input.sigma,
-                                                  sc.transfer_edges);
+                                                  sc.getTransferEdges());
     out << "\n";
 
     return out;
@@ -290,35 +452,28 @@ operator<<(ostream &out, const Scenario &sc)
 bool
 operator<(const Scenario &sc1, const Scenario &sc2)
 {
-    double cost1, cost2;
-    cost1 =
-            sc1.transfer_edges.count() * Phyltr::g_input.transfer_cost +
-            sc1.duplications.count() * Phyltr::g_input.duplication_cost;
-    cost2 =
-            sc2.transfer_edges.count() * Phyltr::g_input.transfer_cost +
-            sc2.duplications.count() * Phyltr::g_input.duplication_cost;
-    if (cost1 < cost2)
+    if (sc1.cost < sc2.cost)
     {
         return true;
     }
-    if (cost1 > cost2)
+    if (sc1.cost > sc2.cost)
     {
         return false;
     }
 
-    if (sc1.transfer_edges.count() < sc2.transfer_edges.count())
+    if (sc1.transfer_edges.size() < sc2.transfer_edges.size())
     {
         return true;
     }
-    if (sc1.transfer_edges.count() > sc2.transfer_edges.count())
+    if (sc1.transfer_edges.size() > sc2.transfer_edges.size())
     {
         return false;
     }
 
     unsigned losses1 = count_losses(*Phyltr::g_input.species_tree, *Phyltr::g_input.gene_tree,
-                               Phyltr::g_input.sigma, sc1.transfer_edges);
+                               Phyltr::g_input.sigma, sc1.getTransferEdges());
     unsigned losses2 = count_losses(*Phyltr::g_input.species_tree, *Phyltr::g_input.gene_tree,
-                               Phyltr::g_input.sigma, sc2.transfer_edges);
+                               Phyltr::g_input.sigma, sc2.getTransferEdges());
     if (losses1 < losses2)
     {
         return true;
@@ -328,57 +483,21 @@ operator<(const Scenario &sc1, const Scenario &sc2)
         return false;
     }
 
-    dynamic_bitset<> transfer_edges1(sc1.transfer_edges.size());
-    dynamic_bitset<> transfer_edges2(sc1.transfer_edges.size());
-    for (unsigned i = 0; i < sc1.transfer_edges.size(); ++i)
-    {
-        if (sc1.transfer_edges[i])
-        {
-            transfer_edges1.set(i);
-        }
-    }
-    for (unsigned i = 0; i < sc2.transfer_edges.size(); ++i)
-    {
-        if (sc2.transfer_edges[i])
-        {
-            transfer_edges2.set(i);
-        }
-    }
-    if (transfer_edges1 < transfer_edges2)
+    // the bitset order is decided by the highest vertex id that
+    // differs, which is the lexicographic order of the reversed lists
+    if (lexicographical_compare(sc1.transfer_edges.rbegin(), sc1.transfer_edges.rend(),
+                                sc2.transfer_edges.rbegin(), sc2.transfer_edges.rend()))
     {
         return true;
     }
-    if (transfer_edges1 > transfer_edges2)
+    if (lexicographical_compare(sc2.transfer_edges.rbegin(), sc2.transfer_edges.rend(),
+                                sc1.transfer_edges.rbegin(), sc1.transfer_edges.rend()))
     {
         return false;
     }
 
-    dynamic_bitset<> duplications1(sc1.duplications.size());
-    dynamic_bitset<> duplications2(sc1.duplications.size());
-    for (unsigned i = 0; i < sc1.duplications.size(); ++i)
-    {
-        if (sc1.duplications[i])
-        {
-            duplications1.set(i);
-        }
-    }
-    for (unsigned i = 0; i < sc2.duplications.size(); ++i)
-    {
-        if (sc2.duplications[i])
-        {
-            duplications2.set(i);
-        }
-    }
-    if (duplications1 < duplications2)
-    {
-        return true;
-    }
-    if (duplications1 > duplications2)
-    {
-        return false;
-    }
-
-    return false;
+    return lexicographical_compare(sc1.duplications.rbegin(), sc1.duplications.rend(),
+                                   sc2.duplications.rbegin(), sc2.duplications.rend());
 }
 
 ostream &
@@ -403,9 +522,95 @@ operator<<(ostream &out, const Candidate &c)
 }
 
 Scenario::Scenario(unsigned size) :
-    duplications(size),
-    transfer_edges(size)
+    cost(0.0),
+    nodes(size)
+{
+}
+
+Scenario::Scenario(const Candidate &c, unsigned size) :
+    cost(c.cost()),
+    nodes(size)
+{
+    for (vid_t u = 0; u < size; ++u)
+    {
+        if (c.is_duplication(u))
+        {
+            duplications.push_back(u);
+        }
+        if (c.is_transfer_edge(u))
+        {
+            transfer_edges.push_back(u);
+        }
+    }
+}
+
+void Scenario::set_duplication(vid_t u)
 {
+    vector<vid_t>::iterator it = lower_bound(duplications.begin(), duplications.end(), u);
+    if (it == duplications.end() || *it != u)
+    {
+        duplications.insert(it, u);
+        cost += Phyltr::g_input.duplication_cost;
+    }
+}
+
+void Scenario::set_transfer_edge(vid_t u)
+{
+    vector<vid_t>::iterator it = lower_bound(transfer_edges.begin(), transfer_edges.end(), u);
+    if (it == transfer_edges.end() || *it != u)
+    {
+        transfer_edges.insert(it, u);
+        cost += Phyltr::g_input.transfer_cost;
+    }
+}
+
+bool Scenario::is_duplication(vid_t u) const
+{
+    return binary_search(duplications.begin(), duplications.end(), u);
+}
+
+bool Scenario::is_transfer_edge(vid_t u) const
+{
+    return binary_search(transfer_edges.begin(), transfer_edges.end(), u);
+}
+
+void Scenario::merge(const Scenario &sc1, const Scenario &sc2)
+{
+    duplications.clear();
+    transfer_edges.clear();
+    set_union(sc1.duplications.begin(), sc1.duplications.end(),
+              sc2.duplications.begin(), sc2.duplications.end(),
+              back_inserter(duplications));
+    set_union(sc1.transfer_edges.begin(), sc1.transfer_edges.end(),
+              sc2.transfer_edges.begin(), sc2.transfer_edges.end(),
+              back_inserter(transfer_edges));
+    cost = duplications.size() * Phyltr::g_input.duplication_cost +
+            transfer_edges.size() * Phyltr::g_input.transfer_cost;
+}
+
+dynamic_bitset<> Scenario::getDuplications() const
+{
+    dynamic_bitset<> bits(nodes);
+    BOOST_FOREACH (vid_t u, duplications)
+    {
+        bits.set(u);
+    }
+    return bits;
+}
+
+dynamic_bitset<> Scenario::getTransferEdges() const
+{
+    dynamic_bitset<> bits(nodes);
+    BOOST_FOREACH (vid_t u, transfer_edges)
+    {
+        bits.set(u);
+    }
+    return bits;
+}
+
+Candidate Scenario::reconstruct() const
+{
+    return Candidate(getDuplications(), getTransferEdges());
 }
 
 Candidate& Candidate::operator=(const Candidate &cp)
@@ -447,47 +652,113 @@ Candidate::Candidate() :
 
     compute_lambda(S, G, Phyltr::g_input.sigma, transfer_edges_, lambda_);
 
+    compute_forest_();
+
+    // Find forced duplications, i.e., internal gene tree vertices
+    // that are mapped to leaves of S.
+
     for (vid_t u = 0; u < G.getNumberOfNodes(); ++u)
     {
-        if(G.getNode(u) == G.getRootNode())
-        {
-            P_[u] = NONE;
-        }
-        else
+        if (!G.is_leaf(u) && S.is_leaf(lambda_[u]))
         {
-            P_[u] = G.getNode(u)->getParent()->getNumber();
+            duplications_.set(u);
+            cost_ += Phyltr::g_input.duplication_cost;
         }
+    }
 
-        if(G.getNode(u)->isLeaf())
-        {
-            left_[u] = NONE;
-            right_[u] = NONE;
-        }
-        else
+    // Find all s-moves.
+    for (vid_t u = 0; u < G.getNumberOfNodes(); ++u)
+    {
+        if (is_s_move_(u))
         {
-            left_[u] = G.getNode(u)->getLeftChild()->getNumber();
-            right_[u] = G.getNode(u)->getRightChild()->getNumber();
+            s_moves_.push_back(u);
         }
     }
+}
 
-    // Find forced duplications, i.e., internal gene tree vertices
-    // that are mapped to leaves of S.
+Candidate::Candidate(const dynamic_bitset<> &duplications,
+                     const dynamic_bitset<> &transfer_edges) :
+    duplications_(duplications),
+    transfer_edges_(transfer_edges),
+    cost_(duplications.count() * Phyltr::g_input.duplication_cost +
+          transfer_edges.count() * Phyltr::g_input.transfer_cost),
+    lambda_(Phyltr::g_input.gene_tree->getNumberOfNodes()),
+    P_(Phyltr::g_input.gene_tree->getNumberOfNodes()),
+    left_(Phyltr::g_input.gene_tree->getNumberOfNodes()),
+    right_(Phyltr::g_input.gene_tree->getNumberOfNodes())
+{
+    const TreeExtended &G = *Phyltr::g_input.gene_tree;
+    const TreeExtended &S = *Phyltr::g_input.species_tree;
+
+    compute_lambda(S, G, Phyltr::g_input.sigma, transfer_edges_, lambda_);
+    compute_forest_();
 
     for (vid_t u = 0; u < G.getNumberOfNodes(); ++u)
     {
-        if (!G.getNode(u)->isLeaf() && S.getNode(lambda_[u])->isLeaf())
+        if (is_s_move_(u))
         {
-            duplications_.set(u);
-            cost_ += Phyltr::g_input.duplication_cost;
+            s_moves_.push_back(u);
         }
     }
+}
 
-    // Find all s-moves.
+void
+Candidate::compute_forest_()
+{
+    const TreeExtended &G = *Phyltr::g_input.gene_tree;
+
+    // A vertex is a transfer vertex if one of its outgoing edges is a
+    // transfer edge, these are contracted away from the forest.
     for (vid_t u = 0; u < G.getNumberOfNodes(); ++u)
     {
-        if (is_s_move_(u))
+        // P_[u] is the first non transfer vertex above u unless a
+        // transfer edge is crossed on the way up
+        P_[u] = NONE;
+        for (vid_t a = u; a != G.root(); a = G.parent(a))
         {
-            s_moves_.push_back(u);
+            if (transfer_edges_[a])
+            {
+                break;
+            }
+            vid_t p = G.parent(a);
+            if (!transfer_edges_[G.left(p)] &&
+                    !transfer_edges_[G.right(p)])
+            {
+                P_[u] = p;
+                break;
+            }
+        }
+
+        if (G.is_leaf(u) ||
+                transfer_edges_[G.left(u)] ||
+                transfer_edges_[G.right(u)])
+        {
+            left_[u] = NONE;
+            right_[u] = NONE;
+            continue;
+        }
+
+        // the children in the forest skip the transfer vertices
+        vid_t children[2] = { G.left(u), G.right(u) };
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            vid_t c = children[i];
+            while (!G.is_leaf(c))
+            {
+                if (transfer_edges_[G.left(c)])
+                {
+                    c = G.right(c);
+                }
+                else if (transfer_edges_[G.right(c)])
+                {
+                    c = G.left(c);
+                }
+                else
+                {
+                    break;
+                }
+            }
+            (i == 0 ? left_[u] : right_[u]) = c;
         }
     }
 }
@@ -509,14 +780,14 @@ Candidate::set_transfer_edge(vid_t u)
     const TreeExtended &G = *Phyltr::g_input.gene_tree;
     const TreeExtended &S = *Phyltr::g_input.species_tree;
 
-    if (u == G.getRootNode()->getNumber()) //0
+    if (u == G.root()) //0
     {
         throw bad_transfer_exception();
     }
 
-    vid_t parent_u = G.getNode(u)->getParent()->getNumber();
-    vid_t sibling_u = G.getNode(parent_u)->getLeftChild()->getNumber() == u ?
-                G.getNode(parent_u)->getRightChild()->getNumber() : G.getNode(parent_u)->getLeftChild()->getNumber();
+    vid_t parent_u = G.parent(u);
+    vid_t sibling_u = G.left(parent_u) == u ?
+                G.right(parent_u) : G.left(parent_u);
 
     // parent_u must be an anchor
     if (lambda_[parent_u] == lambda_[u] ||
@@ -530,14 +801,14 @@ Candidate::set_transfer_edge(vid_t u)
     cost_ += Phyltr::g_input.transfer_cost;
 
     // update P_, left_, and right_
-    vid_t v = u == G.getNode(parent_u)->getLeftChild()->getNumber() ? left_[parent_u] : right_[parent_u];
-    vid_t w = u == G.getNode(parent_u)->getLeftChild()->getNumber() ? right_[parent_u] : left_[parent_u];
+    vid_t v = u == G.left(parent_u) ? left_[parent_u] : right_[parent_u];
+    vid_t w = u == G.left(parent_u) ? right_[parent_u] : left_[parent_u];
 
-    for (vid_t a = v; a != parent_u; a = G.getNode(a)->getParent()->getNumber())
+    for (vid_t a = v; a != parent_u; a = G.parent(a))
     {
         P_[a] = NONE;
     }
-    for (vid_t a = w; a != parent_u; a = G.getNode(a)->getParent()->getNumber())
+    for (vid_t a = w; a != parent_u; a = G.parent(a))
     {
         P_[a] = P_[parent_u];
     }
@@ -561,25 +832,25 @@ Candidate::set_transfer_edge(vid_t u)
     lambda_[parent_u] = lambda_[sibling_u];
     vid_t last_updated_vertex = parent_u;
 
-    for (vid_t a = G.getNode(parent_u)->getParent()->getNumber();
-         G.getNode(a) != G.getRootNode();
-         a = G.getNode(a)->getParent()->getNumber()) //check root?
+    // the root is updated as well, a stale root placement hides the
+    // s-moves below it
+    for (vid_t a = parent_u; a != G.root(); )
     {
+        a = G.parent(a);
+
         // Compute the new placement of a
         vid_t old_lambda = lambda_[a];
 
-        Node *v1 = S.getNode(lambda_[G.getNode(a)->getLeftChild()->getNumber()]);
-        Node *v2 = S.getNode(lambda_[G.getNode(a)->getRightChild()->getNumber()]);
-        vid_t new_lambda = S.lca(v1,v2)->getNumber();
+        vid_t new_lambda = S.lca(lambda_[G.left(a)], lambda_[G.right(a)]);
 
-        if (is_transfer_edge(G.getNode(a)->getLeftChild()->getNumber()))
+        if (is_transfer_edge(G.left(a)))
         {
-            new_lambda = lambda_[G.getNode(a)->getRightChild()->getNumber()];
+            new_lambda = lambda_[G.right(a)];
         }
-        else if (is_transfer_edge(G.getNode(a)->getRightChild()->getNumber()))
+        else if (is_transfer_edge(G.right(a)))
         {
             //new_lambda = lambda_[G.left(a)];
-            new_lambda = lambda_[G.getNode(a)->getLeftChild()->getNumber()];
+            new_lambda = lambda_[G.left(a)];
         }
         
         lambda_[a] = new_lambda;
@@ -595,7 +866,7 @@ Candidate::set_transfer_edge(vid_t u)
         if (left_[a] != NONE && !duplications_[a])
         {
             // Is 'a' a forced duplication?
-            if (S.getNode(new_lambda)->isLeaf() ||
+            if (S.is_leaf(new_lambda) ||
                     (lambda_[left_[a]] == new_lambda &&
                      duplications_[left_[a]]) ||
                     (lambda_[right_[a]] == new_lambda &&
@@ -683,10 +954,10 @@ Candidate::is_elegant() const
          dd = duplications_.find_next(dd))
     {
         vid_t d = dd;
-        vid_t v = G.getNode(d)->getLeftChild()->getNumber();
-        vid_t w = G.getNode(d)->getRightChild()->getNumber();
-        if (!S.descendant(S.getNode(lambda_[v]),S.getNode(lambda_[w])) &&
-                !S.descendant(S.getNode(lambda_[w]),S.getNode(lambda_[v])))
+        vid_t v = G.left(d);
+        vid_t w = G.right(d);
+        if (!S.descendant(lambda_[v], lambda_[w]) &&
+                !S.descendant(lambda_[w], lambda_[v]))
         {
             return false;
         }
@@ -702,12 +973,12 @@ Candidate::is_elegant() const
         vid_t v = vv;
         // Let (u, v) be the transfer edge we are considering, let
         // pu = p(u), and x = lca{lambda_[u], lambda_[v]}
-        vid_t u = G.getNode(v)->getParent()->getNumber();
-        vid_t pu = G.getNode(u)->getParent()->getNumber();
-        vid_t x = S.lca(S.getNode(lambda_[u]),S.getNode(lambda_[v]))->getNumber();
+        vid_t u = G.parent(v);
+        vid_t pu = G.parent(u);
+        vid_t x = S.lca(lambda_[u], lambda_[v]);
 
         // The root of G is always an unnecessary transfer vertex.
-        if (u == G.getRootNode()->getNumber())
+        if (u == G.root())
         {
             return false;
         }
@@ -716,9 +987,9 @@ Candidate::is_elegant() const
         // highest[p(u)] = lambda_[p(u)], then the transfer is
         // unnecessary.
         if (!is_duplication(pu) &&
-                !is_transfer_edge(G.getNode(pu)->getLeftChild()->getNumber()) &&
-                !is_transfer_edge(G.getNode(pu)->getRightChild()->getNumber()) &&
-                S.descendant(S.getNode(x),S.getNode(lambda_[pu])) &&
+                !is_transfer_edge(G.left(pu)) &&
+                !is_transfer_edge(G.right(pu)) &&
+                S.descendant(x, lambda_[pu]) &&
                 x != lambda_[pu])
         {
             return false;
@@ -728,9 +999,9 @@ Candidate::is_elegant() const
         // be a descendant of highest[p(u)] for the transfer to be
         // unnecessary.
         if ((is_duplication(pu) ||
-             is_transfer_edge(G.getNode(pu)->getLeftChild()->getNumber()) ||
-             is_transfer_edge(G.getNode(pu)->getRightChild()->getNumber())) &&
-                S.descendant(S.getNode(x),S.getNode(highest[pu])))
+             is_transfer_edge(G.left(pu)) ||
+             is_transfer_edge(G.right(pu))) &&
+                S.descendant(x, highest[pu]))
         {
             return false;
         }
@@ -782,27 +1053,15 @@ Candidate::right(vid_t u) const
     return right_[u];
 }
 
-void Candidate::copy(Candidate *cp)
-{
-
-    this->duplications_ = cp->duplications_;
-    this->transfer_edges_ = cp->transfer_edges_;
-    this->cost_ = cp->cost_;
-    this->lambda_ =  cp->lambda_;
-    this->P_ = cp->P_;
-    this->left_ = cp->left_;
-    this->right_ = cp->right_;
-}
-
 bool
 Candidate::is_s_move_(vid_t u) const
 {
     return
-            !Phyltr::g_input.gene_tree->getNode(u)->isLeaf() &&
+            !Phyltr::g_input.gene_tree->is_leaf(u) &&
             !is_duplication(u) &&
             P_[u] != NONE &&
-            lambda_[Phyltr::g_input.gene_tree->getNode(u)->getLeftChild()->getNumber()] != lambda_[u] &&
-            lambda_[Phyltr::g_input.gene_tree->getNode(u)->getRightChild()->getNumber()] != lambda_[u] &&
+            lambda_[Phyltr::g_input.gene_tree->left(u)] != lambda_[u] &&
+            lambda_[Phyltr::g_input.gene_tree->right(u)] != lambda_[u] &&
             lambda_[P_[u]] == lambda_[u] &&
             !is_duplication(P_[u]);
 }
@@ -824,58 +1083,55 @@ Candidate::compute_highest_mapping_(vector<vid_t> &highest) const
     {
         vid_t operator()(vid_t x, vid_t y)
         {
-            vid_t left = Phyltr::g_input.species_tree->getNode(x)->getLeftChild()->getNumber();
-            vid_t right = Phyltr::g_input.species_tree->getNode(x)->getRightChild()->getNumber();
-            return  Phyltr::g_input.species_tree->descendant(Phyltr::g_input.species_tree->getNode(y),
-                                                             Phyltr::g_input.species_tree->getNode(left)) ? left : right;
+            vid_t left = Phyltr::g_input.species_tree->left(x);
+            vid_t right = Phyltr::g_input.species_tree->right(x);
+            return  Phyltr::g_input.species_tree->descendant(y, left) ? left : right;
         }
     } C;
 
     // First, take care of the root of G.
 
-    if (!is_duplication(G.getRootNode()->getNumber()) &&
-            !is_transfer_edge(G.getRootNode()->getLeftChild()->getNumber()) &&
-            !is_transfer_edge(G.getRootNode()->getRightChild()->getNumber())) // if root is a speciation
+    if (!is_duplication(G.root()) &&
+            !is_transfer_edge(G.left(G.root())) &&
+            !is_transfer_edge(G.right(G.root()))) // if root is a speciation
     {
-        highest[G.getRootNode()->getNumber()] = lambda_[G.getRootNode()->getNumber()];
+        highest[G.root()] = lambda_[G.root()];
     }
-    else if (is_duplication(G.getRootNode()->getNumber()))
+    else if (is_duplication(G.root()))
     {
 
-        highest[G.getRootNode()->getNumber()] = S.getRootNode()->getNumber();
+        highest[G.root()] = S.root();
     }
     else // If the root is a transfer vertex.
     {
         // Let v be the transfered child of the root.
-        vid_t v = is_transfer_edge(G.getRootNode()->getLeftChild()->getNumber()) ?
-                    G.getRootNode()->getLeftChild()->getNumber() : G.getRootNode()->getRightChild()->getNumber();
-        highest[G.getRootNode()->getNumber()] = C((S.lca(S.getNode(lambda_[G.getRootNode()->getNumber()]),
-                                                   S.getNode(lambda_[v])))->getNumber(), lambda_[G.getRootNode()->getNumber()]);
+        vid_t v = is_transfer_edge(G.left(G.root())) ?
+                    G.left(G.root()) : G.right(G.root());
+        highest[G.root()] = C(S.lca(lambda_[G.root()], lambda_[v]), lambda_[G.root()]);
     }
 
     // Next, take care of the rest of the vertices from the root and down.g
-    for (Node *u = G.preorder_next(G.getRootNode());
-         u != 0; u = G.preorder_next(u)) //check it iterates well
+    BOOST_FOREACH (vid_t u, G.preorder())
     {
-        if (u == G.getRootNode())
+        if (u == G.root())
         {
             continue;
         }
 
-        vid_t pu = u->getParent()->getNumber();
+        vid_t pu = G.parent(u);
         vid_t x = lambda_[pu];
-        vid_t y = lambda_[u->getNumber()];
+        vid_t y = lambda_[u];
 
-        if (u->isLeaf())
+        if (G.is_leaf(u))
         {
-            highest[u->getNumber()] = sigma[u->getNumber()];
+            highest[u] = sigma[u];
         }
         else if (
-                 !is_duplication(u->getNumber()) &&
-                 !is_transfer_edge(u->getLeftChild()->getNumber()) &&
-                 !is_transfer_edge(u->getRightChild()->getNumber()))
+                 !is_duplication(u) &&
+                 !is_transfer_edge(G.left(u)) &&
+                 !is_transfer_edge(G.right(u)))
         {
-            highest[u->getNumber()] = lambda_[u->getNumber()];
+            highest[u] = lambda_[u];
         }
         else // If u is a duplication or a transfer vertex.
         {
@@ -887,32 +1143,32 @@ Candidate::compute_highest_mapping_(vector<vid_t> &highest) const
             // u is the transfered vertex, then z = C(lca(x, y), y)
             vid_t z = highest[pu];
             if (!is_duplication(pu) &&
-                    !is_transfer_edge(G.getNode(pu)->getLeftChild()->getNumber()) &&
-                    !is_transfer_edge(G.getNode(pu)->getRightChild()->getNumber())) // If pu is speciation.
+                    !is_transfer_edge(G.left(pu)) &&
+                    !is_transfer_edge(G.right(pu))) // If pu is speciation.
             {
                 z = C(x, y);
             }
-            else if (is_transfer_edge(u->getNumber()))
+            else if (is_transfer_edge(u))
             {
-                z = C((S.lca(S.getNode(x),S.getNode(y)))->getNumber(), y);
+                z = C(S.lca(x, y), y);
             }
             // Let z_prime be the highest possible mapping of
             // u when considering its children only. z_prime
             // is the root of x unless u is a transfer. In
             // that case, if v is the transferred child,
-            vid_t z_prime = S.getRootNode()->getNumber();
-            if (is_transfer_edge(u->getLeftChild()->getNumber()) ||
-                    is_transfer_edge(u->getRightChild()->getNumber()))
+            vid_t z_prime = S.root();
+            if (is_transfer_edge(G.left(u)) ||
+                    is_transfer_edge(G.right(u)))
             {
                 // Let v be the transferred child of u.
-                vid_t v = is_transfer_edge(u->getLeftChild()->getNumber()) ? u->getLeftChild()->getNumber() : u->getRightChild()->getNumber();
-                z_prime = C((S.lca(S.getNode(y), S.getNode(lambda_[v])))->getNumber(), y);
+                vid_t v = is_transfer_edge(G.left(u)) ? G.left(u) : G.right(u);
+                z_prime = C(S.lca(y, lambda_[v]), y);
             }
             // Since z and z_prime are both ancestors of
             // lambda_[u], we know that they are
             // comparable. The one that is minimal in S is
             // then the highest possible mapping of u.
-            highest[u->getNumber()] = S.descendant(S.getNode(z),S.getNode(z_prime)) ? z : z_prime;
+            highest[u] = S.descendant(z, z_prime) ? z : z_prime;
         }
     }
 }
@@ -924,35 +1180,47 @@ void compute_lambda(const TreeExtended &S,
                     std::vector<unsigned> &lambda)
 {
 
-    lambda.resize(G.getNumberOfNodes());
+    // lambda(u) is the lca of the species of the leaves that are reached from
+    // u without crossing a transfer edge, which is the lca of the two of them
+    // that come first and last in the preorder of S. The first and last are
+    // found in one pass over G and then all the lca queries are answered
+    // in one batch.
+    const std::vector<unsigned> &species_preorder = S.preorder();
+    std::vector<std::pair<unsigned, unsigned> > range(G.getNumberOfNodes());
     
-    for (Node *u = G.postorder_begin();
-         u != 0;
-         u = G.postorder_next(u))
+    BOOST_FOREACH (unsigned uid, G.postorder())
     {
-        /* Take care of gene tree leaves and continue. */
-        if (u->isLeaf())
+        if (G.is_leaf(uid))
         {
-            lambda[u->getNumber()] = sigma[u->getNumber()];
+            const unsigned entry = S.dfs_entry(sigma[uid]);
+            range[uid] = std::make_pair(entry, entry);
             continue;
         }
         
-        Node *v = u->getLeftChild();
-        Node *w = u->getRightChild();
+        const unsigned v = G.left(uid);
+        const unsigned w = G.right(uid);
         
-        if (transfer_edges[v->getNumber()])
+        if (transfer_edges[v])
         {
-            lambda[u->getNumber()] = lambda[w->getNumber()];
+            range[uid] = range[w];
         }
-        else if (transfer_edges[w->getNumber()])
+        else if (transfer_edges[w])
         {
-            lambda[u->getNumber()] = lambda[v->getNumber()];
+            range[uid] = range[v];
         }
         else
         {
-            lambda[u->getNumber()] = (S.lca(S.getNode(lambda[w->getNumber()]),S.getNode(lambda[v->getNumber()])))->getNumber();
+            range[uid] = std::make_pair(min(range[v].first, range[w].first),
+                                        max(range[v].second, range[w].second));
         }
     }
+
+    for (unsigned u = 0; u < range.size(); ++u)
+    {
+        range[u].first = species_preorder[range[u].first];
+        range[u].second = species_preorder[range[u].second];
+    }
+    S.lca(range, lambda);
 }
 
 unsigned count_losses(const TreeExtended &S,
@@ -973,32 +1241,28 @@ unsigned count_losses(const TreeExtended &S,
     unsigned losses = 0;
     for (unsigned u = 0; u < G.getNumberOfNodes(); ++u)
     {
-        if(G.getNode(u) == G.getRootNode())
+        if(u == G.root())
         {
             break;
         }
         
-        Node *p = G.getNode(u)->getParent();
+        const unsigned p = G.parent(u);
 
-        if (transfer_edges[u] || lambda[p->getNumber()] == lambda[u])
+        if (transfer_edges[u] || lambda[p] == lambda[u])
         {
             continue;
         }
 
-        Node *x = S.getNode(lambda[u])->getParent();
+        const unsigned u_sibling = G.left(p) == u ? G.right(p) : G.left(p);
 
-        Node *u_sibling = p->getLeftChild()->getNumber() == u ? p->getRightChild() : p->getLeftChild();
-
-        if (lambda[u_sibling->getNumber()] == lambda[p->getNumber()]) // we know that lampda(u) != lambda(p)!
+        if (lambda[u_sibling] == lambda[p]) // we know that lampda(u) != lambda(p)!
         {
             losses += 1;
         }
 
-        while (x->getNumber() != lambda[p->getNumber()])
-        {
-            losses += 1;
-            x = x->getParent();
-        }
+        // one loss for each species vertex strictly between lambda(p)
+        // and lambda(u)
+        losses += S.depth(lambda[u]) - S.depth(lambda[p]) - 1;
     }
     
     return losses;
@@ -1010,88 +1274,101 @@ create_gene_species_map(const TreeExtended &species_tree,const TreeExtended &gen
 {
 
     using namespace std;
-    vector<string> map_file_content;
-    
-    ifstream map_file(map_filename.c_str());
-    
-    copy(istream_iterator<string>(map_file), istream_iterator<string>(),
-         back_inserter(map_file_content));
 
-    /* Make sure there are even number of strings in map file. */
-    if (map_file_content.empty() || map_file_content.size() % 2 != 0)
+    /* Create a map from gene name to species name, the names are read in
+     * pairs straight from the mapped file and a later line overrides an
+     * earlier one. */
+    StrStrMap gs;
+    unsigned words = 0;
+    try
     {
-        throw logic_error("error reading map file.");
+        InputFile map_file(map_filename);
+        const char *position = map_file.begin();
+        const char *gene_label;
+        const char *species_label;
+        size_t gene_length;
+        size_t species_length;
+        while (InputFile::nextWord(position, map_file.end(), gene_label, gene_length))
+        {
+            ++words;
+            if (!InputFile::nextWord(position, map_file.end(), species_label, species_length))
+            {
+                break;
+            }
+            ++words;
+            gs.change(string(gene_label, gene_length), string(species_label, species_length));
+        }
     }
-
-    /* Create a map from gene name to species name. */
-    map<string, string> str_sigma;
-    for (unsigned i = 0; i < map_file_content.size(); i += 2)
+    catch (AnError &)
     {
-        str_sigma[map_file_content[i]] = map_file_content[i+1];
+        words = 0;
     }
-    
-    /* Create the final map called sigma mapping vid_t to vid_t */
-    for (unsigned v = 0; v < gene_tree.getNumberOfNodes(); ++v) //check it iterates well
-    {
 
-        if (!gene_tree.getNode(v)->isLeaf())
-        {
-            continue;
-        }
-        string gene_label = gene_tree.getNode(v)->getName();
-        string species_label = str_sigma[gene_label];
-        if (species_label == "")
-        {
-            string message =
-                    "gene label '" + gene_label + "' "
-                    "is missing in map file.";
-            throw logic_error(message);
-        }
-        if (species_tree.findNode(species_label) == 0)
-        {
-            string message =
-                    "species label '" + species_label + "' "
-                    "which occurs in map file "
-                    "does not exist in species tree.";
-            throw logic_error(message);
-        }
-        sigma[v] = species_tree.findNode(species_label)->getNumber();
+    /* Make sure there are even number of strings in map file. */
+    if (words == 0 || words % 2 != 0)
+    {
+        throw logic_error("error reading map file.");
     }
+
+    create_gene_species_map(species_tree, gene_tree, gs, sigma);
 }
 
 void
 create_gene_species_map(const TreeExtended &species_tree,const TreeExtended &gene_tree, 
                         map<string, string> &str_sigma,std::vector<unsigned> &sigma)
 {
+    StrStrMap gs;
+    for (map<string, string>::const_iterator it = str_sigma.begin(); it != str_sigma.end(); ++it)
+    {
+        gs.insert(it->first, it->second);
+    }
+    create_gene_species_map(species_tree, gene_tree, gs, sigma);
+}
+
+void
+create_gene_species_map(const TreeExtended &species_tree,const TreeExtended &gene_tree, 
+                        const StrStrMap &gs,std::vector<unsigned> &sigma)
+{
 
     using namespace std;
+
+    /* Each species of the map is looked up in the species tree only once,
+     * the gene leaves then go through the species ids. */
+    const NameTable &species = gs.getSpecies();
+    vector<unsigned> species_vertex(species.size(), TreeExtended::NO_NODE);
     
     /* Create the final map called sigma mapping vid_t to vid_t */
     for (unsigned v = 0; v < gene_tree.getNumberOfNodes(); ++v) //check it iterates well
     {
 
-        if (!gene_tree.getNode(v)->isLeaf())
+        if (!gene_tree.is_leaf(v))
         {
             continue;
         }
-        string gene_label = gene_tree.getNode(v)->getName();
-        string species_label = str_sigma[gene_label];
-        if (species_label == "")
+        const string &gene_label = gene_tree.getNode(v)->getName();
+        const unsigned species_id = gs.findId(gene_label);
+        if (species_id == NameTable::NO_NAME || species.getLength(species_id) == 0)
         {
             string message =
                     "gene label '" + gene_label + "' "
                     "is missing in map file.";
             throw logic_error(message);
         }
-        if (species_tree.findNode(species_label) == 0)
+        if (species_vertex[species_id] == TreeExtended::NO_NODE)
         {
-            string message =
-                    "species label '" + species_label + "' "
-                    "which occurs in map file "
-                    "does not exist in species tree.";
-            throw logic_error(message);
+            const string species_label = species.getName(species_id);
+            Node *x = species_tree.findNode(species_label);
+            if (x == 0)
+            {
+                string message =
+                        "species label '" + species_label + "' "
+                        "which occurs in map file "
+                        "does not exist in species tree.";
+                throw logic_error(message);
+            }
+            species_vertex[species_id] = x->getNumber();
         }
-        sigma[v] = species_tree.findNode(species_label)->getNumber();
+        sigma[v] = species_vertex[species_id];
     }
 }
 
@@ -1111,36 +1388,46 @@ Phyltr::dp_algorithm()
         g_backtrack_matrix.resize(boost::extents[G.getNumberOfNodes()][S.getNumberOfNodes()]);
     }
 
-    // Initialize below and outside to infinity.
+    // Initialize below and outside to infinity. resize() keeps the cells
+    // of an earlier run, so the backtrack matrix is cleared as well.
     for (vid_t u = 0; u < G.getNumberOfNodes(); ++u)
     {
         for (vid_t x = 0; x < S.getNumberOfNodes(); ++x)
         {
             g_below[u][x] = COST_INF;
             g_outside[u][x] = COST_INF;
+            if (do_backtrack)
+            {
+                g_backtrack_matrix[u][x] = BacktrackElement();
+            }
         }
     }
 
+    if (progress)
+    {
+        progress->startStage("dp", G.getNumberOfNodes() * S.getNumberOfNodes());
+        progress->setMemory(memory_in_use());
+    }
+
     // The algorithm itself is described in a published paper.
-    for (Node *u = G.postorder_begin();
-         u != 0;
-         u = G.postorder_next(u))
+    BOOST_FOREACH (vid_t u, G.postorder())
     {
         // First compute g_below[u][*].
-        for (Node *x = S.postorder_begin();
-             x != 0;
-             x = S.postorder_next(x))
+        BOOST_FOREACH (vid_t x, S.postorder())
         {
-            compute_below(u->getNumber(), x->getNumber());
+            compute_below(u, x);
         }
         // Compute g_outside[u][*]
-        for (Node *x = S.preorder_begin();
-             x != 0;
-             x = S.preorder_next(x))
+        BOOST_FOREACH (vid_t x, S.preorder())
         {
-            compute_outside(u->getNumber(), x->getNumber());
+            compute_outside(u, x);
         }
 
+        if (progress)
+        {
+            progress->addCells(S.getNumberOfNodes());
+            progress->poll(S.getNumberOfNodes());
+        }
     }
 }
 
@@ -1154,11 +1441,11 @@ Phyltr::compute_below(vid_t u, vid_t x)
     const cost_type dcost = Phyltr::g_input.duplication_cost;
     const bool do_backtrack = true;
 
-    if (G.getNode(u)->isLeaf())
+    if (G.is_leaf(u))
     {
-        if (S.descendant(S.getNode(sigma[u]), S.getNode(x)))
+        if (S.descendant(sigma[u], x))
         {
-            g_below[u][x] = G.getRootNode()->getNumber();
+            g_below[u][x] = G.root();
         }
     }
     else
@@ -1166,23 +1453,23 @@ Phyltr::compute_below(vid_t u, vid_t x)
         vector<cost_type> costs(BacktrackElement::N_EVENTS, COST_INF);
 
         costs[BacktrackElement::D] =
-                dcost + g_below[G.getNode(u)->getLeftChild()->getNumber()][x] + g_below[G.getNode(u)->getRightChild()->getNumber()][x];
+                dcost + g_below[G.left(u)][x] + g_below[G.right(u)][x];
         costs[BacktrackElement::T_LEFT] =
-                tcost + g_outside[G.getNode(u)->getLeftChild()->getNumber()][x] + g_below[G.getNode(u)->getRightChild()->getNumber()][x];
+                tcost + g_outside[G.left(u)][x] + g_below[G.right(u)][x];
         costs[BacktrackElement::T_RIGHT] =
-                tcost + g_outside[G.getNode(u)->getRightChild()->getNumber()][x] + g_below[G.getNode(u)->getLeftChild()->getNumber()][x];
+                tcost + g_outside[G.right(u)][x] + g_below[G.left(u)][x];
 
-        if (!S.getNode(x)->isLeaf())
+        if (!S.is_leaf(x))
         {
             costs[BacktrackElement::S] =
-                    g_below[G.getNode(u)->getLeftChild()->getNumber()][S.getNode(x)->getLeftChild()->getNumber()] +
-                    g_below[G.getNode(u)->getRightChild()->getNumber()][S.getNode(x)->getRightChild()->getNumber()];
+                    g_below[G.left(u)][S.left(x)] +
+                    g_below[G.right(u)][S.right(x)];
             costs[BacktrackElement::S_REV] =
-                    g_below[G.getNode(u)->getLeftChild()->getNumber()][S.getNode(x)->getRightChild()->getNumber()] +
-                    g_below[G.getNode(u)->getRightChild()->getNumber()][S.getNode(x)->getLeftChild()->getNumber()];
+                    g_below[G.left(u)][S.right(x)] +
+                    g_below[G.right(u)][S.left(x)];
 
-            costs[BacktrackElement::BELOW_LEFT] = g_below[u][S.getNode(x)->getLeftChild()->getNumber()];
-            costs[BacktrackElement::BELOW_RIGHT] = g_below[u][S.getNode(x)->getRightChild()->getNumber()];
+            costs[BacktrackElement::BELOW_LEFT] = g_below[u][S.left(x)];
+            costs[BacktrackElement::BELOW_RIGHT] = g_below[u][S.right(x)];
         }
 
         cost_type min_cost = *min_element(costs.begin(), costs.end());
@@ -1211,14 +1498,14 @@ Phyltr::compute_outside(vid_t u, vid_t x)
     const bool do_backtrack = true;
 
     // Cannot place u outside the root of S.
-    if (x == S.getRootNode()->getNumber())
+    if (x == S.root())
     {
         return;
     }
-    vid_t x_parent = S.getNode(x)->getParent()->getNumber();
+    vid_t x_parent = S.parent(x);
     vid_t x_sibling =
-            S.getNode(x_parent)->getLeftChild()->getNumber() == x ? S.getNode(x_parent)->getRightChild()->getNumber() :
-                                                                    S.getNode(x_parent)->getLeftChild()->getNumber();
+            S.left(x_parent) == x ? S.right(x_parent) :
+                                                                    S.left(x_parent);
 
     cost_type min_cost = min(g_below[u][x_sibling], g_outside[u][x_parent]);
     g_outside[u][x] = min_cost;
@@ -1254,76 +1541,132 @@ Phyltr::backtrack()
     const TreeExtended &G = *Phyltr::g_input.gene_tree;
     const std::vector<vid_t> &sigma = Phyltr::g_input.sigma;
     multi_array<BacktrackElement, 2> &matrix = Phyltr::g_backtrack_matrix;
+    const unsigned long row = S.getNumberOfNodes();
+
+    // Every pass below visits all the cells once.
+    if (progress)
+    {
+        progress->startStage("backtrack", 4 * G.getNumberOfNodes() * row);
+        progress->setScenarios(0);
+    }
+
+    // Clear what an earlier, possibly cancelled, backtrack left behind.
+    for (vid_t u = 0; u < G.getNumberOfNodes(); ++u)
+    {
+        for (vid_t x = 0; x < S.getNumberOfNodes(); ++x)
+        {
+            matrix[u][x].min_transfers = 0;
+            matrix[u][x].scenarios_below_needed = false;
+            matrix[u][x].scenarios_at_needed = false;
+            matrix[u][x].below_placements.clear();
+            vector<Scenario>().swap(matrix[u][x].scenarios_at);
+        }
+    }
 
     // Backtrack the placements for each u and x.
-    for (Node *u = G.postorder_begin(); u != 0; u = G.postorder_next(u))
+    BOOST_FOREACH (vid_t u, G.postorder())
     {
-        for (Node *x = S.postorder_begin(); x != 0; x = S.postorder_next(x))
+        BOOST_FOREACH (vid_t x, S.postorder())
+        {
+            Phyltr::backtrack_below_placements(u, x);
+        }
+        if (progress)
         {
-            Phyltr::backtrack_below_placements(u->getNumber(), x->getNumber());
+            progress->addCells(row);
+            progress->poll(row);
         }
     }
 
     // Mark the sets of scenarios that we need to compute.
-    matrix[G.getRootNode()->getNumber()][S.getRootNode()->getNumber()].scenarios_below_needed = true; //ROOT??
+    matrix[G.root()][S.root()].scenarios_below_needed = true; //ROOT??
     
-    for (Node *u = G.preorder_begin(); u != 0; u = G.preorder_next(u))
+    BOOST_FOREACH (vid_t u, G.preorder())
     {
         for (vid_t x = 0; x < S.getNumberOfNodes(); ++x)
         {
-            if (matrix[u->getNumber()][x].scenarios_below_needed)
+            if (matrix[u][x].scenarios_below_needed)
             {
-                BOOST_FOREACH (vid_t y, matrix[u->getNumber()][x].below_placements)
+                BOOST_FOREACH (vid_t y, matrix[u][x].below_placements)
                 {
-                    matrix[u->getNumber()][y].scenarios_at_needed = true;
+                    matrix[u][y].scenarios_at_needed = true;
                 }
             }
         }
 
-        if (u->isLeaf())
+        if (progress)
+        {
+            progress->addCells(row);
+            progress->poll(row);
+        }
+
+        if (G.is_leaf(u))
         {
             continue;
         }
         
         for (vid_t x = 0; x < S.getNumberOfNodes(); ++x)
         {
-            if (matrix[u->getNumber()][x].scenarios_at_needed)
+            if (matrix[u][x].scenarios_at_needed)
             {
-                Phyltr::backtrack_mark_needed_scenarios_below(u->getNumber(), x);
+                Phyltr::backtrack_mark_needed_scenarios_below(u, x);
             }
         }
     }
 
     // Compute the minimum number of transfer events for each u and x.
-    for (Node *u = G.postorder_begin(); u != 0; u = G.postorder_next(u))
+    BOOST_FOREACH (vid_t u, G.postorder())
     {
-        for (Node *x = S.postorder_begin(); x != 0; x = S.postorder_next(x))
+        BOOST_FOREACH (vid_t x, S.postorder())
+        {
+            Phyltr::backtrack_min_transfers(u, x);
+        }
+        if (progress)
         {
-            Phyltr::backtrack_min_transfers(u->getNumber(), x->getNumber());
+            progress->addCells(row);
+            progress->poll(row);
         }
     }
 
+    // Bytes held by the partial scenarios that are still in the matrix.
+    size_t live_bytes = 0;
+
     // Backtrack the needed scenarios.
-    for (Node *u = G.postorder_begin(); u != 0
-         && u->getNumber() < G.getNumberOfNodes(); u = G.postorder_next(u))  // CHECK CHECK
+    BOOST_FOREACH (vid_t u, G.postorder())
     {
         for (vid_t x = 0; x < S.getNumberOfNodes(); ++x)
         {
-            if (matrix[u->getNumber()][x].scenarios_at_needed)
+            if (matrix[u][x].scenarios_at_needed)
             {
-                Phyltr::backtrack_scenarios_at(u->getNumber(), x);
+                Phyltr::backtrack_scenarios_at(u, x);
+                if (progress)
+                {
+                    live_bytes += scenario_bytes(matrix[u][x].scenarios_at);
+                }
             }
         }
 
         // Remove the unneeded sets of scenarios to conserve memory.
-        if (!u->isLeaf())
+        if (!G.is_leaf(u))
         {
             for (vid_t x = 0; x < S.getNumberOfNodes(); ++x)
             {
-                vector<Scenario>().swap(matrix[u->getLeftChild()->getNumber()][x].scenarios_at);
-                vector<Scenario>().swap(matrix[u->getRightChild()->getNumber()][x].scenarios_at);
+                if (progress)
+                {
+                    live_bytes -= min(live_bytes,
+                                      scenario_bytes(matrix[G.left(u)][x].scenarios_at) +
+                                      scenario_bytes(matrix[G.right(u)][x].scenarios_at));
+                }
+                vector<Scenario>().swap(matrix[G.left(u)][x].scenarios_at);
+                vector<Scenario>().swap(matrix[G.right(u)][x].scenarios_at);
             }
         }
+
+        if (progress)
+        {
+            progress->setMemory(memory_in_use() + live_bytes);
+            progress->addCells(row);
+            progress->poll(row);
+        }
     }
 
     // Find the minimum number of losses of placing root of G below
@@ -1331,34 +1674,47 @@ Phyltr::backtrack()
     unsigned max_losses = numeric_limits<unsigned>::max();
     if (Phyltr::g_input.print_only_minimal_loss_scenarios)
     {
-        BOOST_FOREACH(vid_t x, matrix[G.getRootNode()->getNumber()][S.getRootNode()->getNumber()].below_placements)
+        BOOST_FOREACH(vid_t x, matrix[G.root()][S.root()].below_placements)
         {
-            BOOST_FOREACH(Scenario &sc, matrix[G.getRootNode()->getNumber()][x].scenarios_at)
+            BOOST_FOREACH(Scenario &sc, matrix[G.root()][x].scenarios_at)
             {
-                max_losses = min(max_losses,count_losses(S, G, sigma, sc.transfer_edges));
+                max_losses = min(max_losses,count_losses(S, G, sigma, sc.getTransferEdges()));
             }
         }
     }
 
     // Find the final sets of scenarios.
-    BOOST_FOREACH(vid_t x, matrix[G.getRootNode()->getNumber()][S.getRootNode()->getNumber()].below_placements)
+    BOOST_FOREACH(vid_t x, matrix[G.root()][S.root()].below_placements)
     {
         // Take only scenarios with minimal transfers if the flag is set.
         if (Phyltr::g_input.print_only_minimal_transfer_scenarios &&
-                !matrix[G.getRootNode()->getNumber()][x].scenarios_at.empty() &&
-                matrix[G.getRootNode()->getNumber()][x].scenarios_at[0].transfer_edges.count() >
-                matrix[G.getRootNode()->getNumber()][S.getRootNode()->getNumber()].min_transfers)
+                !matrix[G.root()][x].scenarios_at.empty() &&
+                matrix[G.root()][x].scenarios_at[0].transfer_edges.size() >
+                matrix[G.root()][S.root()].min_transfers)
         {
-            vector<Scenario>().swap(matrix[G.getRootNode()->getNumber()][x].scenarios_at);
+            vector<Scenario>().swap(matrix[G.root()][x].scenarios_at);
             continue;
         }
         // Take only scenarios with minimal losses if the flag is set.
-        BOOST_FOREACH(Scenario &sc, matrix[G.getRootNode()->getNumber()][x].scenarios_at)
+        BOOST_FOREACH(Scenario &sc, matrix[G.root()][x].scenarios_at)
         {
-            if (count_losses(S, G, sigma, sc.transfer_edges) <= max_losses)
+            if (count_losses(S, G, sigma, sc.getTransferEdges()) <= max_losses)
+            {
                 Phyltr::scenarios.push_back(sc);
+            }
         }
-        vector<Scenario>().swap(matrix[G.getRootNode()->getNumber()][x].scenarios_at);
+        vector<Scenario>().swap(matrix[G.root()][x].scenarios_at);
+    }
+
+    scenario_memory = scenario_bytes(Phyltr::scenarios);
+    if (unique_scenarios)
+    {
+        unique_scenarios->insert(Phyltr::scenarios);
+    }
+    if (progress)
+    {
+        progress->setScenarios(Phyltr::scenarios.size());
+        progress->setMemory(memory_in_use());
     }
 
     return;
@@ -1378,18 +1734,18 @@ Phyltr::backtrack_below_placements(vid_t u, vid_t x)
     {
         return;
     }
-    if (G.getNode(u)->isLeaf())
+    if (G.is_leaf(u))
     {
         elem.below_placements.push_back(g_input.sigma[u]);
     }
-    else if (S.getNode(x)->isLeaf())
+    else if (S.is_leaf(x))
     {
         elem.below_placements.push_back(x);
     }
     else
     {
-        BacktrackElement &left_elem = g_backtrack_matrix[G.getNode(u)->getLeftChild()->getNumber()][x];
-        BacktrackElement &right_elem = g_backtrack_matrix[G.getNode(u)->getRightChild()->getNumber()][x];
+        BacktrackElement &left_elem = g_backtrack_matrix[G.left(u)][x];
+        BacktrackElement &right_elem = g_backtrack_matrix[G.right(u)][x];
         const bitset<BacktrackElement::N_EVENTS> &e = elem.below_events;
 
         // First, determine if u is placed _at_ x.
@@ -1406,14 +1762,14 @@ Phyltr::backtrack_below_placements(vid_t u, vid_t x)
         if (elem.below_events[BacktrackElement::BELOW_LEFT])
         {
             vector<vid_t> &left_placements =
-                    g_backtrack_matrix[u][S.getNode(x)->getLeftChild()->getNumber()].below_placements;
+                    g_backtrack_matrix[u][S.left(x)].below_placements;
             copy(left_placements.begin(), left_placements.end(),
                  back_inserter(elem.below_placements));
         }
         if (elem.below_events[BacktrackElement::BELOW_RIGHT])
         {
             vector<vid_t> &right_placements =
-                    g_backtrack_matrix[u][S.getNode(x)->getRightChild()->getNumber()].below_placements;
+                    g_backtrack_matrix[u][S.right(x)].below_placements;
             copy(right_placements.begin(), right_placements.end(),
                  back_inserter(elem.below_placements));
         }
@@ -1432,49 +1788,49 @@ Phyltr::backtrack_mark_needed_scenarios_below(vid_t u, vid_t x)
     const bitset<BacktrackElement::N_EVENTS> &e = matrix[u][x].below_events;
     if (e[BacktrackElement::S])
     {
-        matrix[G.getNode(u)->getLeftChild()->getNumber()][S.getNode(x)->getLeftChild()->getNumber()].scenarios_below_needed = true;
-        matrix[G.getNode(u)->getRightChild()->getNumber()][S.getNode(x)->getRightChild()->getNumber()].scenarios_below_needed = true;
+        matrix[G.left(u)][S.left(x)].scenarios_below_needed = true;
+        matrix[G.right(u)][S.right(x)].scenarios_below_needed = true;
     }
     if (e[BacktrackElement::S_REV])
     {
-        matrix[G.getNode(u)->getLeftChild()->getNumber()][S.getNode(x)->getRightChild()->getNumber()].scenarios_below_needed = true;
-        matrix[G.getNode(u)->getRightChild()->getNumber()][S.getNode(x)->getLeftChild()->getNumber()].scenarios_below_needed = true;
+        matrix[G.left(u)][S.right(x)].scenarios_below_needed = true;
+        matrix[G.right(u)][S.left(x)].scenarios_below_needed = true;
     }
     if (e[BacktrackElement::D])
     {
         // This is the only time we need to set a scenarios_at_needed.
-        if (matrix[G.getNode(u)->getRightChild()->getNumber()][x].below_placements[0] == x)
+        if (matrix[G.right(u)][x].below_placements[0] == x)
         {
-            matrix[G.getNode(u)->getRightChild()->getNumber()][x].scenarios_at_needed = true;
-            matrix[G.getNode(u)->getLeftChild()->getNumber()][x].scenarios_below_needed = true;
+            matrix[G.right(u)][x].scenarios_at_needed = true;
+            matrix[G.left(u)][x].scenarios_below_needed = true;
         }
 
-        if (matrix[G.getNode(u)->getLeftChild()->getNumber()][x].below_placements[0] == x)
+        if (matrix[G.left(u)][x].below_placements[0] == x)
         {
-            matrix[G.getNode(u)->getLeftChild()->getNumber()][x].scenarios_at_needed = true;
-            matrix[G.getNode(u)->getRightChild()->getNumber()][x].scenarios_below_needed = true;
+            matrix[G.left(u)][x].scenarios_at_needed = true;
+            matrix[G.right(u)][x].scenarios_below_needed = true;
         }
     }
     if (e[BacktrackElement::T_LEFT])
     {
-        matrix[G.getNode(u)->getRightChild()->getNumber()][x].scenarios_below_needed = true;
+        matrix[G.right(u)][x].scenarios_below_needed = true;
 
         vector<vid_t> outside_placements;
-        backtrack_outside_placements(G.getNode(u)->getLeftChild()->getNumber(), x, outside_placements);
+        backtrack_outside_placements(G.left(u), x, outside_placements);
         BOOST_FOREACH (vid_t y, outside_placements)
         {
-            matrix[G.getNode(u)->getLeftChild()->getNumber()][y].scenarios_below_needed = true;
+            matrix[G.left(u)][y].scenarios_below_needed = true;
         }
     }
     if (e[BacktrackElement::T_RIGHT])
     {
-        matrix[G.getNode(u)->getLeftChild()->getNumber()][x].scenarios_below_needed = true;
+        matrix[G.left(u)][x].scenarios_below_needed = true;
 
         vector<vid_t> outside_placements;
-        backtrack_outside_placements(G.getNode(u)->getRightChild()->getNumber(), x, outside_placements);
+        backtrack_outside_placements(G.right(u), x, outside_placements);
         BOOST_FOREACH (vid_t y, outside_placements)
         {
-            matrix[G.getNode(u)->getRightChild()->getNumber()][y].scenarios_below_needed = true;
+            matrix[G.right(u)][y].scenarios_below_needed = true;
         }
     }
 }
@@ -1486,7 +1842,7 @@ Phyltr::backtrack_scenarios_at(vid_t u, vid_t x)
     const TreeExtended &S = *Phyltr::g_input.species_tree;
     multi_array<BacktrackElement, 2> &matrix = Phyltr::g_backtrack_matrix;
 
-    if (G.getNode(u)->isLeaf())
+    if (G.is_leaf(u))
     {
         // it must be the case that sigma(u) = x, otherwise the
         // algorithm is corrupt.
@@ -1498,24 +1854,24 @@ Phyltr::backtrack_scenarios_at(vid_t u, vid_t x)
 
     if (events[BacktrackElement::S])
     {
-        BOOST_FOREACH (vid_t y1, matrix[G.getNode(u)->getLeftChild()->getNumber()][S.getNode(x)->getLeftChild()->getNumber()].below_placements)
+        BOOST_FOREACH (vid_t y1, matrix[G.left(u)][S.left(x)].below_placements)
         {
-            BOOST_FOREACH (vid_t y2, matrix[G.getNode(u)->getRightChild()->getNumber()][S.getNode(x)->getRightChild()->getNumber()].below_placements)
+            BOOST_FOREACH (vid_t y2, matrix[G.right(u)][S.right(x)].below_placements)
             {
-                combine_scenarios(matrix[G.getNode(u)->getLeftChild()->getNumber()][y1].scenarios_at,
-                        matrix[G.getNode(u)->getRightChild()->getNumber()][y2].scenarios_at,
+                combine_scenarios(matrix[G.left(u)][y1].scenarios_at,
+                        matrix[G.right(u)][y2].scenarios_at,
                         u, x, BacktrackElement::S);
             }
         }
     }
     if (events[BacktrackElement::S_REV])
     {
-        BOOST_FOREACH (vid_t y1, matrix[G.getNode(u)->getLeftChild()->getNumber()][S.getNode(x)->getRightChild()->getNumber()].below_placements)
+        BOOST_FOREACH (vid_t y1, matrix[G.left(u)][S.right(x)].below_placements)
         {
-            BOOST_FOREACH (vid_t y2, matrix[G.getNode(u)->getRightChild()->getNumber()][S.getNode(x)->getLeftChild()->getNumber()].below_placements)
+            BOOST_FOREACH (vid_t y2, matrix[G.right(u)][S.left(x)].below_placements)
             {
-                combine_scenarios(matrix[G.getNode(u)->getLeftChild()->getNumber()][y1].scenarios_at,
-                        matrix[G.getNode(u)->getRightChild()->getNumber()][y2].scenarios_at,
+                combine_scenarios(matrix[G.left(u)][y1].scenarios_at,
+                        matrix[G.right(u)][y2].scenarios_at,
                         u, x, BacktrackElement::S_REV);
             }
         }
@@ -1526,37 +1882,37 @@ Phyltr::backtrack_scenarios_at(vid_t u, vid_t x)
         // get duplicate scenarios. The only way that u is mapped
         // _at_ x is if at least one of the children of u is also
         // placed _at_ x.
-        if (matrix[G.getNode(u)->getLeftChild()->getNumber()][x].below_placements[0] == x &&
-                matrix[G.getNode(u)->getRightChild()->getNumber()][x].below_placements[0] == x)
+        if (matrix[G.left(u)][x].below_placements[0] == x &&
+                matrix[G.right(u)][x].below_placements[0] == x)
         {
-            combine_scenarios(matrix[G.getNode(u)->getLeftChild()->getNumber()][x].scenarios_at,
-                    matrix[G.getNode(u)->getRightChild()->getNumber()][x].scenarios_at,
+            combine_scenarios(matrix[G.left(u)][x].scenarios_at,
+                    matrix[G.right(u)][x].scenarios_at,
                     u, x, BacktrackElement::D);
         }
 
-        if (matrix[G.getNode(u)->getLeftChild()->getNumber()][x].below_placements[0] == x)
+        if (matrix[G.left(u)][x].below_placements[0] == x)
         {
-            BOOST_FOREACH (vid_t y, matrix[G.getNode(u)->getRightChild()->getNumber()][x].below_placements)
+            BOOST_FOREACH (vid_t y, matrix[G.right(u)][x].below_placements)
             {
                 if (y == x)
                 {
                     continue;
                 }
-                combine_scenarios(matrix[G.getNode(u)->getRightChild()->getNumber()][y].scenarios_at,
-                        matrix[G.getNode(u)->getLeftChild()->getNumber()][x].scenarios_at,
+                combine_scenarios(matrix[G.right(u)][y].scenarios_at,
+                        matrix[G.left(u)][x].scenarios_at,
                         u, x, BacktrackElement::D);
             }
         }
-        if (matrix[G.getNode(u)->getRightChild()->getNumber()][x].below_placements[0] == x)
+        if (matrix[G.right(u)][x].below_placements[0] == x)
         {
-            BOOST_FOREACH (vid_t y, matrix[G.getNode(u)->getLeftChild()->getNumber()][x].below_placements)
+            BOOST_FOREACH (vid_t y, matrix[G.left(u)][x].below_placements)
             {
                 if (y == x)
                 {
                     continue;
                 }
-                combine_scenarios(matrix[G.getNode(u)->getLeftChild()->getNumber()][y].scenarios_at,
-                        matrix[G.getNode(u)->getRightChild()->getNumber()][x].scenarios_at,
+                combine_scenarios(matrix[G.left(u)][y].scenarios_at,
+                        matrix[G.right(u)][x].scenarios_at,
                         u, x, BacktrackElement::D);
             }
         }
@@ -1564,14 +1920,14 @@ Phyltr::backtrack_scenarios_at(vid_t u, vid_t x)
     if (events[BacktrackElement::T_LEFT])
     {
         vector<vid_t> outside_placements;
-        backtrack_outside_placements(G.getNode(u)->getLeftChild()->getNumber(), x, outside_placements);
+        backtrack_outside_placements(G.left(u), x, outside_placements);
 
         BOOST_FOREACH (vid_t y, outside_placements)
         {
-            BOOST_FOREACH (vid_t y1, matrix[G.getNode(u)->getLeftChild()->getNumber()][y].below_placements)
+            BOOST_FOREACH (vid_t y1, matrix[G.left(u)][y].below_placements)
             {
-                combine_scenarios(matrix[G.getNode(u)->getLeftChild()->getNumber()][y1].scenarios_at,
-                        matrix[G.getNode(u)->getRightChild()->getNumber()][x].scenarios_at,
+                combine_scenarios(matrix[G.left(u)][y1].scenarios_at,
+                        matrix[G.right(u)][x].scenarios_at,
                         u, x, BacktrackElement::T_LEFT);
             }
         }
@@ -1579,14 +1935,14 @@ Phyltr::backtrack_scenarios_at(vid_t u, vid_t x)
     if (events[BacktrackElement::T_RIGHT])
     {
         vector<vid_t> placements;
-        backtrack_outside_placements(G.getNode(u)->getRightChild()->getNumber(), x, placements);
+        backtrack_outside_placements(G.right(u), x, placements);
 
         BOOST_FOREACH (vid_t y, placements)
         {
-            BOOST_FOREACH (vid_t y1, matrix[G.getNode(u)->getRightChild()->getNumber()][y].below_placements)
+            BOOST_FOREACH (vid_t y1, matrix[G.right(u)][y].below_placements)
             {
-                combine_scenarios(matrix[G.getNode(u)->getRightChild()->getNumber()][y1].scenarios_at,
-                        matrix[G.getNode(u)->getLeftChild()->getNumber()][x].scenarios_at,
+                combine_scenarios(matrix[G.right(u)][y1].scenarios_at,
+                        matrix[G.left(u)][x].scenarios_at,
                         u, x, BacktrackElement::T_RIGHT);
             }
         }
@@ -1601,7 +1957,7 @@ Phyltr::backtrack_min_transfers(vid_t u, vid_t x)
     const bitset<BacktrackElement::N_EVENTS> &events = g_backtrack_matrix[u][x].below_events;
 
     // The base case when u is a leaf.
-    if (G.getNode(u)->isLeaf() && g_below[u][x] != COST_INF)
+    if (G.is_leaf(u) && g_below[u][x] != COST_INF)
     {
         g_backtrack_matrix[u][x].min_transfers = 0;
         return;
@@ -1611,55 +1967,55 @@ Phyltr::backtrack_min_transfers(vid_t u, vid_t x)
     if (events[BacktrackElement::D])
     {
         min_transfers = min(min_transfers,
-                            g_backtrack_matrix[G.getNode(u)->getLeftChild()->getNumber()][x].min_transfers +
-                g_backtrack_matrix[G.getNode(u)->getRightChild()->getNumber()][x].min_transfers);
+                            g_backtrack_matrix[G.left(u)][x].min_transfers +
+                g_backtrack_matrix[G.right(u)][x].min_transfers);
     }
     
     if (events[BacktrackElement::T_LEFT])
     {
         vector<vid_t> placements;
-        backtrack_outside_placements(G.getNode(u)->getLeftChild()->getNumber(), x, placements);
+        backtrack_outside_placements(G.left(u), x, placements);
         unsigned transfers = G.getNumberOfNodes() + 1;
         BOOST_FOREACH (vid_t y, placements)
         {
-            transfers = min(transfers, g_backtrack_matrix[G.getNode(u)->getLeftChild()->getNumber()][y].min_transfers);
+            transfers = min(transfers, g_backtrack_matrix[G.left(u)][y].min_transfers);
         }
-        transfers += 1 + g_backtrack_matrix[G.getNode(u)->getRightChild()->getNumber()][x].min_transfers;
+        transfers += 1 + g_backtrack_matrix[G.right(u)][x].min_transfers;
         min_transfers = min(min_transfers, transfers);
     }
     if (events[BacktrackElement::T_RIGHT])
     {
         vector<vid_t> placements;
-        backtrack_outside_placements(G.getNode(u)->getRightChild()->getNumber(), x, placements);
+        backtrack_outside_placements(G.right(u), x, placements);
         unsigned transfers = G.getNumberOfNodes() + 1;
         BOOST_FOREACH (vid_t y, placements)
         {
-            transfers = min(transfers, g_backtrack_matrix[G.getNode(u)->getRightChild()->getNumber()][y].min_transfers);
+            transfers = min(transfers, g_backtrack_matrix[G.right(u)][y].min_transfers);
         }
-        transfers += 1 + g_backtrack_matrix[G.getNode(u)->getLeftChild()->getNumber()][x].min_transfers;
+        transfers += 1 + g_backtrack_matrix[G.left(u)][x].min_transfers;
         min_transfers = min(min_transfers, transfers);
     }
     if (events[BacktrackElement::S])
     {
         min_transfers = min(min_transfers,
-                            g_backtrack_matrix[G.getNode(u)->getLeftChild()->getNumber()][S.getNode(x)->getLeftChild()->getNumber()].min_transfers +
-                g_backtrack_matrix[G.getNode(u)->getRightChild()->getNumber()][S.getNode(x)->getRightChild()->getNumber()].min_transfers);
+                            g_backtrack_matrix[G.left(u)][S.left(x)].min_transfers +
+                g_backtrack_matrix[G.right(u)][S.right(x)].min_transfers);
     }
     if (events[BacktrackElement::S_REV])
     {
         min_transfers = min(min_transfers,
-                            g_backtrack_matrix[G.getNode(u)->getLeftChild()->getNumber()][S.getNode(x)->getRightChild()->getNumber()].min_transfers +
-                g_backtrack_matrix[G.getNode(u)->getRightChild()->getNumber()][S.getNode(x)->getLeftChild()->getNumber()].min_transfers);
+                            g_backtrack_matrix[G.left(u)][S.right(x)].min_transfers +
+                g_backtrack_matrix[G.right(u)][S.left(x)].min_transfers);
     }
     if (events[BacktrackElement::BELOW_LEFT])
     {
         min_transfers = min(min_transfers,
-                            g_backtrack_matrix[u][S.getNode(x)->getLeftChild()->getNumber()].min_transfers);
+                            g_backtrack_matrix[u][S.left(x)].min_transfers);
     }
     if (events[BacktrackElement::BELOW_RIGHT])
     {
         min_transfers = min(min_transfers,
-                            g_backtrack_matrix[u][S.getNode(x)->getRightChild()->getNumber()].min_transfers);
+                            g_backtrack_matrix[u][S.right(x)].min_transfers);
     }
     g_backtrack_matrix[u][x].min_transfers = min_transfers;
 
@@ -1697,8 +2053,8 @@ Phyltr::combine_scenarios(const vector<Scenario> &vec1,
     if (Phyltr::g_input.print_only_minimal_transfer_scenarios)
     {
         unsigned transfers =  //root??
-                vec1[0].transfer_edges.count() +
-                vec2[0].transfer_edges.count();
+                vec1[0].transfer_edges.size() +
+                vec2[0].transfer_edges.size();
         if (e == BacktrackElement::T_LEFT || e == BacktrackElement::T_RIGHT)
         {
             transfers += 1;
@@ -1715,21 +2071,18 @@ Phyltr::combine_scenarios(const vector<Scenario> &vec1,
         BOOST_FOREACH (const Scenario &sc2, vec2)
         {
             Scenario new_sc(g_input.gene_tree->getNumberOfNodes());
-            new_sc.transfer_edges =
-                    sc1.transfer_edges | sc2.transfer_edges;
-            new_sc.duplications =
-                    sc1.duplications | sc2.duplications;
+            new_sc.merge(sc1, sc2);
             if (e == BacktrackElement::D)
             {
-                new_sc.duplications.set(u);
+                new_sc.set_duplication(u);
             }
             if (e == BacktrackElement::T_LEFT)
             {
-                new_sc.transfer_edges.set(G.getNode(u)->getLeftChild()->getNumber());
+                new_sc.set_transfer_edge(G.left(u));
             }
             if (e == BacktrackElement::T_RIGHT)
             {
-                new_sc.transfer_edges.set(G.getNode(u)->getRightChild()->getNumber());
+                new_sc.set_transfer_edge(G.right(u));
             }
             g_backtrack_matrix[u][x].scenarios_at.push_back(new_sc);
         }
@@ -46,14 +46,19 @@
 #include <set>
 #include <bitset>
 #include <stddef.h>
+#include <chrono>
+#include <functional>
 
 #include <boost/smart_ptr.hpp>
 #include <boost/dynamic_bitset.hpp>
 #include <boost/foreach.hpp>
+#include <boost/multi_array.hpp>
 
 #include <fstream>
 
 #include "../tree/Treeextended.h"
+#include "../reconcilation/StrStrMap.h"
+#include "Progress.h"
 
 using namespace std;
 using boost::shared_ptr;
@@ -62,6 +67,8 @@ using boost::multi_array;
 typedef unsigned vid_t;
 typedef float cost_type;
 
+class ScenarioSet;
+
 //*****************************************************************************
 // global variables
 //
@@ -135,6 +142,11 @@ public:
 
     Candidate();
     
+    // builds a final candidate directly from its events, the events are
+    // assumed to be consistent (as they are in any Scenario)
+    Candidate(const dynamic_bitset<> &duplications,
+              const dynamic_bitset<> &transfer_edges);
+    
     void compute_highest_mapping_(vector<vid_t> &) const;
     void set_transfer_edge(vid_t);
     void set_duplication(vid_t);
@@ -154,9 +166,9 @@ public:
     
     Candidate& operator=(const Candidate &cp);
     
-    void copy(Candidate *cp);
-    
 private:
+    void compute_forest_();
+    
     dynamic_bitset<> duplications_;
     dynamic_bitset<> transfer_edges_;
     double cost_;
@@ -182,6 +194,13 @@ private:
 // is represented by the vertex at its head, i.e., the vertex farthest
 // away from the root.
 //
+// The events are kept as sorted lists of gene tree vertex ids
+// together with the cost of the events, so a scenario only takes
+// O(#events) space. The lca-mapping and the gene tree forest are not
+// stored, reconstruct() rebuilds the corresponding Candidate when
+// they are needed. getDuplications() and getTransferEdges() expand
+// the lists into bitsets of size nodes.
+//
 // The operator< is used to sort the scenarios for printing. It sorts
 // first on the number of transfers, then on the number of losses, and
 // lastly according to lexicographic order.
@@ -189,12 +208,26 @@ private:
 
 class Scenario {
 public:
-    dynamic_bitset<> duplications;
-    dynamic_bitset<> transfer_edges;
-    Candidate cp;
+    vector<vid_t> duplications;
+    vector<vid_t> transfer_edges;
+    double cost;
+    unsigned nodes;
 
     Scenario(unsigned size);
+    Scenario(const Candidate &c, unsigned size);
 
+    void set_duplication(vid_t u);
+    void set_transfer_edge(vid_t u);
+    bool is_duplication(vid_t u) const;
+    bool is_transfer_edge(vid_t u) const;
+    
+    // union of the events of two scenarios of disjoint subtrees
+    void merge(const Scenario &sc1, const Scenario &sc2);
+    
+    dynamic_bitset<> getDuplications() const;
+    dynamic_bitset<> getTransferEdges() const;
+    
+    Candidate reconstruct() const;
 };
 
 
@@ -314,6 +347,38 @@ class Phyltr
 
 public:
 
+    explicit Phyltr();
+
+    //*****************************************************************************
+    // set_progress()
+    //
+    // Hands a Progress token to the algorithms. dp_algorithm() and
+    // backtrack() poll it once per gene tree row, fpt_algorithm() once per
+    // search node. When the token is cancelled they throw
+    // Progress::Cancelled, except fpt_anytime() which keeps the layers
+    // that were complete and returns. The token is not owned by Phyltr.
+    //*****************************************************************************
+    void set_progress(Progress *p);
+
+    //*****************************************************************************
+    // set_unique_scenarios()
+    //
+    // The scenarios of a finished run are also inserted into the set given,
+    // which keeps one copy of each distinct scenario across runs. Nothing
+    // is inserted by a cancelled run, fpt_anytime() inserts each layer
+    // once it is complete. The set is not owned by Phyltr.
+    //*****************************************************************************
+    void set_unique_scenarios(ScenarioSet *set);
+
+    //*****************************************************************************
+    // memory_in_use()
+    //
+    // Rough estimate of the bytes held by the DP matrices and the
+    // scenarios found so far. The bytes of the scenarios are counted as
+    // they are added, so the estimate takes constant time.
+    //*****************************************************************************
+    size_t memory_in_use() const;
+
     void print_error(const char *);
     //*****************************************************************************
     // read_sigma()
@@ -326,6 +391,7 @@ public:
     //*****************************************************************************
     bool read_sigma();
     bool read_sigma(map<string, string> str_sigma);
+    bool read_sigma(const StrStrMap &gs);
     //*****************************************************************************
     // fpt_algorithm()
     //
@@ -334,6 +400,33 @@ public:
     // passed to the function is filled with Scenario options.
     // //*****************************************************************************
     void fpt_algorithm();
+    //*****************************************************************************
+    // fpt_anytime()
+    //
+    // Iterative deepening version of fpt_algorithm(). The cost bound starts
+    // at the cost of the cheapest possible candidate and is raised by step
+    // (the cheapest event cost if step is not positive) until it reaches
+    // g_input.max_cost. If the events are free, there is a single layer
+    // up to g_input.max_cost. Every complete layer, i.e. the scenarios with cost
+    // in (previous bound, bound], is appended to scenarios and handed to
+    // on_layer together with its bound, and to the Progress token if there
+    // is one. The search stops after the layer that reaches max_scenarios
+    // scenarios, or when max_seconds have passed, in which case the
+    // unfinished layer is dropped. A budget of 0 means no limit.
+    //*****************************************************************************
+    typedef std::function<void (double, const vector<Scenario> &)> LayerCallback;
+    void fpt_anytime(double step, unsigned max_scenarios, double max_seconds,
+                     const LayerCallback &on_layer = LayerCallback());
+    //*****************************************************************************
+    // fpt_search()
+    //
+    // The depth first search behind fpt_algorithm() and fpt_anytime(). Elegant
+    // final candidates with cost in [min_cost, max_cost] are appended to
+    // found. Returns false if the deadline was reached before the search
+    // space was exhausted.
+    //*****************************************************************************
+    bool fpt_search(double min_cost, double max_cost, vector<Scenario> &found,
+                    const std::chrono::steady_clock::time_point *deadline = 0);
 
     /* print all the scenarios */
     void printScenarios();
@@ -372,7 +465,9 @@ public:
     // g_input.print_only_minimal_loss_scenarios affect the behaviour of
     // backtrack(). If both flags are set, the scenarios with minimal
     // transfers are found first, and among these, the ones with minimal
-    // number of losses are inserted into the return vector.
+    // number of losses are inserted into the return vector. Both
+    // dp_algorithm() and backtrack() can be run again on the same
+    // instance, also after a cancelled run.
     //*****************************************************************************
     void backtrack();
     //*****************************************************************************
@@ -446,6 +541,9 @@ public:
     multi_array<BacktrackElement, 2> g_backtrack_matrix;
     static ProgramInput g_input;
     static const unsigned NONE = -1;
+    Progress *progress;
+    ScenarioSet *unique_scenarios;
+    size_t scenario_memory;   // bytes held by the scenarios, see memory_in_use()
 
 };
 
@@ -478,8 +576,18 @@ create_gene_species_map(const TreeExtended &species_tree,
                         map<string, string> &str_sigma,
                         std::vector<unsigned> &sigma);
 
+void
+create_gene_species_map(const TreeExtended &species_tree,
+                        const TreeExtended &gene_tree,
+                        const StrStrMap &gs,
+                        std::vector<unsigned> &sigma);
+
 bool operator<(const Scenario &, const Scenario &);
 ostream &operator<<(ostream &, const Scenario &);
+
+/* bytes taken by the scenarios given */
+size_t scenario_bytes(const Scenario &sc);
+size_t scenario_bytes(const vector<Scenario> &scenarios);
 ostream &operator<<(ostream &, const Candidate &);
 
 
@@ -0,0 +1,196 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+#include "Progress.h"
+
+Progress::Cancelled::Cancelled()
+    :AnError("The computation was cancelled", 1)
+{
+
+}
+
+Progress::Progress()
+    :stage(""),
+      cancelled(false),
+      cells_done(0),
+      cells_total(0),
+      scenarios_found(0),
+      memory_in_use(0),
+      layers_done(0),
+      layer_bound(0.0),
+      layer_scenarios(0),
+      observer(),
+      interval(std::chrono::milliseconds(100)),
+      next_report(clock_type::now()),
+      deadline(clock_type::time_point::max()),
+      work(0)
+{
+
+}
+
+Progress::~Progress()
+{
+
+}
+
+void Progress::setObserver(const Observer &obs, unsigned interval_ms)
+{
+    observer = obs;
+    interval = std::chrono::milliseconds(interval_ms);
+    next_report = clock_type::now() + interval;
+}
+
+void Progress::setTimeLimit(double seconds)
+{
+    if (seconds > 0.0)
+    {
+        deadline = clock_type::now() + std::chrono::duration_cast<clock_type::duration>(
+                    std::chrono::duration<double>(seconds));
+    }
+    else
+    {
+        deadline = clock_type::time_point::max();
+    }
+}
+
+void Progress::cancel()
+{
+    cancelled = true;
+}
+
+bool Progress::isCancelled() const
+{
+    return cancelled;
+}
+
+void Progress::startStage(const char *s, unsigned long total_cells)
+{
+    stage = s;
+    cells_done = 0;
+    cells_total = total_cells;
+}
+
+void Progress::addCells(unsigned long cells)
+{
+    cells_done += cells;
+}
+
+void Progress::setScenarios(unsigned long scenarios)
+{
+    scenarios_found = scenarios;
+}
+
+void Progress::addScenarios(unsigned long scenarios)
+{
+    scenarios_found += scenarios;
+}
+
+void Progress::setMemory(size_t bytes)
+{
+    memory_in_use = bytes;
+}
+
+void Progress::completeLayer(double bound, unsigned long scenarios)
+{
+    layer_bound = bound;
+    layer_scenarios = scenarios;
+    layers_done++;
+    if (observer)
+    {
+        // a cancel from the observer is seen by the next poll()
+        next_report = clock_type::now() + interval;
+        observer(*this);
+    }
+}
+
+void Progress::poll(unsigned long weight)
+{
+    if (cancelled)
+    {
+        throw Cancelled();
+    }
+
+    // poll() can be called once per search node, so the clock is only
+    // looked at every now and then
+    work += weight;
+    if (work < 256)
+    {
+        return;
+    }
+    work = 0;
+
+    const clock_type::time_point now = clock_type::now();
+    if (now >= deadline)
+    {
+        cancelled = true;
+        throw Cancelled();
+    }
+    if (observer && now >= next_report)
+    {
+        next_report = now + interval;
+        observer(*this);
+        // the observer may have cancelled the computation
+        if (cancelled)
+        {
+            throw Cancelled();
+        }
+    }
+}
+
+const char* Progress::getStage() const
+{
+    return stage;
+}
+
+unsigned long Progress::getCellsDone() const
+{
+    return cells_done;
+}
+
+unsigned long Progress::getCellsTotal() const
+{
+    return cells_total;
+}
+
+unsigned long Progress::getScenariosFound() const
+{
+    return scenarios_found;
+}
+
+size_t Progress::getMemoryInUse() const
+{
+    return memory_in_use;
+}
+
+unsigned Progress::getLayersDone() const
+{
+    return layers_done;
+}
+
+double Progress::getLayerBound() const
+{
+    return layer_bound;
+}
+
+unsigned long Progress::getLayerScenarios() const
+{
+    return layer_scenarios;
+}
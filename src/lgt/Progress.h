@@ -0,0 +1,120 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+/* Progress is a token that is handed to the long running LGT computations
+ * (dp_algorithm, backtrack and fpt_algorithm). The algorithms update the
+ * counters and call poll() at row and search-node granularity, poll() hands
+ * the token to the observer every now and then and throws Progress::Cancelled
+ * once cancel() has been called or the time limit has passed. The anytime
+ * search also hands over each layer it completes, and the observer is then
+ * called right away so that the early results can be shown.
+ * cancel() and the getters can be called from any thread. */
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include "../utils/AnError.h"
+
+using namespace std;
+
+class Progress
+{
+
+public:
+
+    // thrown by poll() when the computation has to stop
+    class Cancelled : public AnError
+    {
+    public:
+        Cancelled();
+    };
+
+    typedef std::function<void (const Progress &)> Observer;
+
+    // constructor
+    explicit Progress();
+    // destructor
+    virtual ~Progress();
+
+    // the observer is called from poll() at most once every interval_ms
+    void setObserver(const Observer &observer, unsigned interval_ms = 100);
+
+    // stop the computation once seconds have passed from now, 0 means never
+    void setTimeLimit(double seconds);
+
+    // request the computation to stop, safe to call from any thread
+    void cancel();
+    bool isCancelled() const;
+
+    // used by the algorithms
+    void startStage(const char *stage, unsigned long total_cells);
+    void addCells(unsigned long cells);
+    void setScenarios(unsigned long scenarios);
+    void addScenarios(unsigned long scenarios);
+    void setMemory(size_t bytes);
+    // the layer of the anytime search with cost up to bound is complete,
+    // scenarios is the number found up to it
+    void completeLayer(double bound, unsigned long scenarios);
+    // weight is the amount of work done since the last call, the clock and
+    // the observer are only looked at once enough work has been done
+    void poll(unsigned long weight = 1);
+
+    // getters
+    const char* getStage() const;
+    unsigned long getCellsDone() const;
+    unsigned long getCellsTotal() const;
+    unsigned long getScenariosFound() const;
+    size_t getMemoryInUse() const;
+    // the layers completed so far, the bound of the last one and the
+    // scenarios found up to it
+    unsigned getLayersDone() const;
+    double getLayerBound() const;
+    unsigned long getLayerScenarios() const;
+
+private:
+
+    typedef std::chrono::steady_clock clock_type;
+
+    Progress(const Progress &);
+    Progress& operator=(const Progress &);
+
+    std::atomic<const char*> stage;
+    std::atomic<bool> cancelled;
+    std::atomic<unsigned long> cells_done;
+    std::atomic<unsigned long> cells_total;
+    std::atomic<unsigned long> scenarios_found;
+    std::atomic<size_t> memory_in_use;
+    std::atomic<unsigned> layers_done;
+    std::atomic<double> layer_bound;
+    std::atomic<unsigned long> layer_scenarios;
+    Observer observer;
+    clock_type::duration interval;
+    clock_type::time_point next_report;
+    clock_type::time_point deadline;
+    unsigned long work;
+};
+
+#endif // PROGRESS_H
@@ -0,0 +1,435 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+#include "ScenarioIO.h"
+#include "../tree/Node.h"
+#include "../utils/AnError.h"
+
+#include <cstring>
+#include <zlib.h>
+
+static const char SCENARIO_MAGIC[7] = {'P', 'T', 'V', 'S', 'C', 'N', 0};
+static const unsigned SCENARIO_VERSION = 1;
+static const size_t BLOCK_SIZE = 1 << 16;
+
+// little endian encoding helpers
+
+static void put_u32(string &buf, uint32_t v)
+{
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        buf.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+}
+
+static void put_u64(string &buf, uint64_t v)
+{
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        buf.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+}
+
+static void put_f64(string &buf, double d)
+{
+    uint64_t v;
+    memcpy(&v, &d, sizeof(v));
+    put_u64(buf, v);
+}
+
+static void put_varint(string &buf, uint32_t v)
+{
+    while (v >= 0x80)
+    {
+        buf.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    buf.push_back(static_cast<char>(v));
+}
+
+static void put_ids(string &buf, const vector<vid_t> &ids)
+{
+    put_varint(buf, ids.size());
+    vid_t previous = 0;
+    BOOST_FOREACH (vid_t id, ids)
+    {
+        put_varint(buf, id - previous);
+        previous = id;
+    }
+}
+
+static uint64_t get_u(const string &buf, size_t &pos, unsigned bytes)
+{
+    if (pos + bytes > buf.size())
+    {
+        throw AnError("Truncated LGT scenario file");
+    }
+    uint64_t v = 0;
+    for (unsigned i = 0; i < bytes; ++i)
+    {
+        v |= static_cast<uint64_t>(static_cast<unsigned char>(buf[pos + i])) << (8 * i);
+    }
+    pos += bytes;
+    return v;
+}
+
+static double get_f64(const string &buf, size_t &pos)
+{
+    uint64_t v = get_u(buf, pos, 8);
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+static uint32_t get_varint(const string &buf, size_t &pos)
+{
+    uint32_t v = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7)
+    {
+        if (pos >= buf.size())
+        {
+            throw AnError("Truncated LGT scenario file");
+        }
+        const unsigned char c = static_cast<unsigned char>(buf[pos++]);
+        v |= static_cast<uint32_t>(c & 0x7f) << shift;
+        if (!(c & 0x80))
+        {
+            return v;
+        }
+    }
+    throw AnError("Corrupted LGT scenario file");
+}
+
+static void get_ids(const string &buf, size_t &pos, unsigned nodes, vector<vid_t> &ids)
+{
+    const uint32_t n = get_varint(buf, pos);
+    if (n > nodes)
+    {
+        throw AnError("Corrupted LGT scenario file");
+    }
+    ids.resize(n);
+    vid_t previous = 0;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        // the ids are strictly increasing, only the first delta may be 0
+        const uint32_t delta = get_varint(buf, pos);
+        if (i > 0 && delta == 0)
+        {
+            throw AnError("Corrupted LGT scenario file, an event is repeated");
+        }
+        if (delta >= nodes - previous)
+        {
+            throw AnError("Node read in the LGT scenario file does not exist in the Gene Tree");
+        }
+        previous += delta;
+        ids[i] = previous;
+    }
+}
+
+uint64_t tree_hash(const TreeExtended &tree)
+{
+    // FNV-1a over the node numbers, children and leaf names
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t h = 14695981039346656037ULL;
+    string buf;
+    for (unsigned i = 0; i < tree.getNumberOfNodes(); ++i)
+    {
+        const Node *n = tree.getNode(i);
+        buf.clear();
+        put_u32(buf, n->isLeaf() ? Phyltr::NONE : n->getLeftChild()->getNumber());
+        put_u32(buf, n->isLeaf() ? Phyltr::NONE : n->getRightChild()->getNumber());
+        if (n->isLeaf())
+        {
+            buf += n->getName();
+        }
+        buf.push_back(0);
+        for (size_t j = 0; j < buf.size(); ++j)
+        {
+            h = (h ^ static_cast<unsigned char>(buf[j])) * prime;
+        }
+    }
+    return h;
+}
+
+ScenarioWriter::ScenarioWriter(const string &filename)
+    :block_records(0),
+      records(0),
+      closed(false)
+{
+    out.open(filename.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!out)
+    {
+        throw AnError("Could not open file " + filename);
+    }
+
+    const ProgramInput &input = Phyltr::g_input;
+    string head(SCENARIO_MAGIC, sizeof(SCENARIO_MAGIC));
+    head.push_back(static_cast<char>(SCENARIO_VERSION));
+    put_u64(head, tree_hash(*input.gene_tree));
+    put_u64(head, tree_hash(*input.species_tree));
+    put_u32(head, input.gene_tree->getNumberOfNodes());
+    put_u32(head, input.species_tree->getNumberOfNodes());
+    put_f64(head, input.duplication_cost);
+    put_f64(head, input.transfer_cost);
+    put_f64(head, input.min_cost);
+    put_f64(head, input.max_cost);
+    out.write(head.data(), head.size());
+    block.reserve(BLOCK_SIZE + 64);
+}
+
+ScenarioWriter::~ScenarioWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+        // destructors must not throw, call close() to see the errors
+    }
+}
+
+void ScenarioWriter::write(const Scenario &sc)
+{
+    write(sc, count_losses(*Phyltr::g_input.species_tree,
+                           *Phyltr::g_input.gene_tree,
+                           Phyltr::g_input.sigma,
+                           sc.getTransferEdges()));
+}
+
+void ScenarioWriter::write(const Scenario &sc, unsigned losses)
+{
+    if (closed)
+    {
+        throw AnError("Writing to a closed LGT scenario file");
+    }
+    put_f64(block, sc.cost);
+    put_u32(block, losses);
+    put_ids(block, sc.transfer_edges);
+    put_ids(block, sc.duplications);
+    ++block_records;
+    ++records;
+    if (block.size() >= BLOCK_SIZE)
+    {
+        flush();
+    }
+}
+
+void ScenarioWriter::flush()
+{
+    if (block_records == 0)
+    {
+        return;
+    }
+    uLongf compressed_size = compressBound(block.size());
+    vector<Bytef> compressed(compressed_size);
+    if (compress2(&compressed[0], &compressed_size,
+                  reinterpret_cast<const Bytef*>(block.data()), block.size(),
+                  Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        throw AnError("Could not compress the LGT scenarios");
+    }
+    string frame;
+    put_u32(frame, block_records);
+    put_u32(frame, block.size());
+    put_u32(frame, compressed_size);
+    out.write(frame.data(), frame.size());
+    out.write(reinterpret_cast<const char*>(&compressed[0]), compressed_size);
+    if (!out)
+    {
+        throw AnError("Could not write the LGT scenarios");
+    }
+    block.clear();
+    block_records = 0;
+}
+
+void ScenarioWriter::close()
+{
+    if (closed)
+    {
+        return;
+    }
+    closed = true;
+    flush();
+    string end;
+    put_u32(end, 0);
+    put_u32(end, 0);
+    put_u32(end, 0);
+    out.write(end.data(), end.size());
+    out.close();
+    if (out.fail())
+    {
+        throw AnError("Could not write the LGT scenarios");
+    }
+}
+
+unsigned long ScenarioWriter::size() const
+{
+    return records;
+}
+
+ScenarioReader::ScenarioReader(const string &name)
+    :filename(name),
+      file_size(0),
+      position(0),
+      block_records(0),
+      finished(false)
+{
+    in.open(filename.c_str(), ios::in | ios::binary);
+    if (!in)
+    {
+        throw AnError("Could not open file " + filename);
+    }
+
+    const size_t head_size = sizeof(SCENARIO_MAGIC) + 1 + 2 * 8 + 2 * 4 + 4 * 8;
+    string head(head_size, 0);
+    in.read(&head[0], head_size);
+    if (in.gcount() != static_cast<streamsize>(head_size) ||
+            head.compare(0, sizeof(SCENARIO_MAGIC), string(SCENARIO_MAGIC, sizeof(SCENARIO_MAGIC))) != 0)
+    {
+        throw AnError("Not a binary LGT scenario file ", filename);
+    }
+
+    size_t pos = sizeof(SCENARIO_MAGIC);
+    file_header.version = static_cast<unsigned char>(head[pos++]);
+    if (file_header.version != SCENARIO_VERSION)
+    {
+        throw AnError("Unsupported version of the LGT scenario file ", filename);
+    }
+    file_header.gene_tree_hash = get_u(head, pos, 8);
+    file_header.species_tree_hash = get_u(head, pos, 8);
+    file_header.gene_tree_size = static_cast<unsigned>(get_u(head, pos, 4));
+    file_header.species_tree_size = static_cast<unsigned>(get_u(head, pos, 4));
+    file_header.duplication_cost = get_f64(head, pos);
+    file_header.transfer_cost = get_f64(head, pos);
+    file_header.min_cost = get_f64(head, pos);
+    file_header.max_cost = get_f64(head, pos);
+
+    in.seekg(0, ios::end);
+    file_size = in.tellg();
+    in.seekg(head_size, ios::beg);
+}
+
+ScenarioReader::~ScenarioReader()
+{
+
+}
+
+bool ScenarioReader::isScenarioFile(const string &filename)
+{
+    ifstream file(filename.c_str(), ios::in | ios::binary);
+    char magic[sizeof(SCENARIO_MAGIC)];
+    file.read(magic, sizeof(magic));
+    return file.gcount() == static_cast<streamsize>(sizeof(magic)) &&
+            memcmp(magic, SCENARIO_MAGIC, sizeof(magic)) == 0;
+}
+
+const ScenarioFileHeader& ScenarioReader::header() const
+{
+    return file_header;
+}
+
+void ScenarioReader::checkTrees(const TreeExtended &gene_tree,
+                                const TreeExtended &species_tree) const
+{
+    if (file_header.gene_tree_size != gene_tree.getNumberOfNodes() ||
+            file_header.gene_tree_hash != tree_hash(gene_tree))
+    {
+        throw AnError("The LGT scenario file was not computed for this Gene Tree ", filename);
+    }
+    if (file_header.species_tree_size != species_tree.getNumberOfNodes() ||
+            file_header.species_tree_hash != tree_hash(species_tree))
+    {
+        throw AnError("The LGT scenario file was not computed for this Species Tree ", filename);
+    }
+}
+
+bool ScenarioReader::readBlock()
+{
+    string frame(12, 0);
+    in.read(&frame[0], frame.size());
+    if (in.gcount() != static_cast<streamsize>(frame.size()))
+    {
+        throw AnError("Truncated LGT scenario file ", filename);
+    }
+    size_t pos = 0;
+    block_records = static_cast<unsigned>(get_u(frame, pos, 4));
+    const uLongf raw_size = static_cast<uLongf>(get_u(frame, pos, 4));
+    const size_t compressed_size = static_cast<size_t>(get_u(frame, pos, 4));
+    if (block_records == 0)
+    {
+        finished = true;
+        return false;
+    }
+
+    // the writer flushes a block as soon as it reaches BLOCK_SIZE, so no
+    // valid block holds more than BLOCK_SIZE plus one record of raw data
+    const size_t nodes = file_header.gene_tree_size;
+    const size_t max_record = 8 + 4 + 2 * (5 + 5 * nodes);
+    const size_t min_record = 8 + 4 + 2;
+    const streamoff remaining = file_size - in.tellg();
+    if (raw_size == 0 || raw_size > BLOCK_SIZE + max_record ||
+            block_records > raw_size / min_record ||
+            compressed_size == 0 || compressed_size > compressBound(raw_size))
+    {
+        throw AnError("Corrupted LGT scenario file ", filename);
+    }
+    if (static_cast<streamoff>(compressed_size) > remaining)
+    {
+        throw AnError("Truncated LGT scenario file ", filename);
+    }
+
+    vector<Bytef> compressed(compressed_size);
+    in.read(reinterpret_cast<char*>(&compressed[0]), compressed_size);
+    if (in.gcount() != static_cast<streamsize>(compressed_size))
+    {
+        throw AnError("Truncated LGT scenario file ", filename);
+    }
+    block.resize(raw_size);
+    uLongf size = raw_size;
+    if (uncompress(reinterpret_cast<Bytef*>(&block[0]), &size,
+                   &compressed[0], compressed_size) != Z_OK || size != raw_size)
+    {
+        throw AnError("Corrupted LGT scenario file ", filename);
+    }
+    position = 0;
+    return true;
+}
+
+bool ScenarioReader::next(Scenario &sc, unsigned &losses)
+{
+    if (finished)
+    {
+        return false;
+    }
+    if (block_records == 0 && !readBlock())
+    {
+        return false;
+    }
+
+    sc.nodes = file_header.gene_tree_size;
+    sc.cost = get_f64(block, position);
+    losses = static_cast<unsigned>(get_u(block, position, 4));
+    get_ids(block, position, sc.nodes, sc.transfer_edges);
+    get_ids(block, position, sc.nodes, sc.duplications);
+    --block_records;
+    return true;
+}
@@ -0,0 +1,139 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+/* Binary streaming format for LGT scenarios. All the numbers are stored
+ * little endian.
+ *
+ *  header : "PTVSCN" 0 version(u8)
+ *           gene tree hash(u64) species tree hash(u64)
+ *           gene tree size(u32) species tree size(u32)
+ *           duplication cost, transfer cost, min cost, max cost (f64)
+ *  blocks : records(u32) raw size(u32) compressed size(u32) zlib data
+ *           a block with 0 records ends the stream
+ *  record : cost(f64) losses(u32)
+ *           transfers(varint) delta encoded transfer edge ids(varint)
+ *           duplications(varint) delta encoded duplication ids(varint)
+ *
+ * The ids are the gene tree node numbers, the tree hashes are computed with
+ * tree_hash() so that a reader can check that the scenarios belong to the
+ * trees it has loaded. */
+
+#ifndef SCENARIOIO_H
+#define SCENARIOIO_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+
+#include "Phyltr.h"
+
+using namespace std;
+
+/* hash of the topology, node numbers and leaf names of the tree */
+uint64_t tree_hash(const TreeExtended &tree);
+
+struct ScenarioFileHeader
+{
+    unsigned version;
+    uint64_t gene_tree_hash;
+    uint64_t species_tree_hash;
+    unsigned gene_tree_size;
+    unsigned species_tree_size;
+    double duplication_cost;
+    double transfer_cost;
+    double min_cost;
+    double max_cost;
+};
+
+class ScenarioWriter
+{
+
+public:
+
+    // opens the file and writes the header, the trees and costs are taken
+    // from Phyltr::g_input
+    explicit ScenarioWriter(const string &filename);
+    // flushes the last block and closes the file
+    virtual ~ScenarioWriter();
+
+    // appends a scenario, the losses are computed if not given
+    void write(const Scenario &sc);
+    void write(const Scenario &sc, unsigned losses);
+
+    // flushes the last block and writes the end of the stream
+    void close();
+
+    // number of scenarios written so far
+    unsigned long size() const;
+
+private:
+
+    ScenarioWriter(const ScenarioWriter &);
+    ScenarioWriter& operator=(const ScenarioWriter &);
+
+    void flush();
+
+    ofstream out;
+    string block;
+    unsigned block_records;
+    unsigned long records;
+    bool closed;
+};
+
+class ScenarioReader
+{
+
+public:
+
+    // opens the file and reads the header
+    explicit ScenarioReader(const string &filename);
+    virtual ~ScenarioReader();
+
+    // true if the file starts with the magic of the binary format
+    static bool isScenarioFile(const string &filename);
+
+    const ScenarioFileHeader& header() const;
+
+    // throws AnError if the file was not written for the trees given
+    void checkTrees(const TreeExtended &gene_tree, const TreeExtended &species_tree) const;
+
+    // reads the next scenario, returns false at the end of the stream
+    bool next(Scenario &sc, unsigned &losses);
+
+private:
+
+    ScenarioReader(const ScenarioReader &);
+    ScenarioReader& operator=(const ScenarioReader &);
+
+    bool readBlock();
+
+    ifstream in;
+    string filename;
+    streamoff file_size;
+    ScenarioFileHeader file_header;
+    string block;
+    size_t position;
+    unsigned block_records;
+    bool finished;
+};
+
+#endif // SCENARIOIO_H
@@ -0,0 +1,152 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+#include "ScenarioSet.h"
+#include "ScenarioIO.h"
+
+#include <boost/functional/hash.hpp>
+
+size_t hash_value(const Scenario &sc)
+{
+    // the lengths separate the two lists
+    size_t seed = sc.transfer_edges.size();
+    boost::hash_range(seed, sc.transfer_edges.begin(), sc.transfer_edges.end());
+    boost::hash_combine(seed, sc.duplications.size());
+    boost::hash_range(seed, sc.duplications.begin(), sc.duplications.end());
+    return seed;
+}
+
+bool same_events(const Scenario &sc1, const Scenario &sc2)
+{
+    return sc1.transfer_edges == sc2.transfer_edges &&
+            sc1.duplications == sc2.duplications;
+}
+
+size_t ScenarioSet::Hash::operator()(const Scenario &sc) const
+{
+    return hash_value(sc);
+}
+
+bool ScenarioSet::Equal::operator()(const Scenario &sc1, const Scenario &sc2) const
+{
+    return same_events(sc1, sc2);
+}
+
+ScenarioSet::ScenarioSet(unsigned n)
+    :has_trees(false),
+      gene_tree_hash(0),
+      species_tree_hash(0)
+{
+    shards.resize(n == 0 ? 1 : n);
+    for (unsigned i = 0; i < shards.size(); ++i)
+    {
+        shards[i].reset(new Shard());
+    }
+}
+
+ScenarioSet::~ScenarioSet()
+{
+
+}
+
+ScenarioSet::Shard& ScenarioSet::shardOf(size_t hash) const
+{
+    // the low bits are used by the buckets of the shard
+    return *shards[(hash >> 16) % shards.size()];
+}
+
+bool ScenarioSet::insert(const Scenario &sc)
+{
+    Shard &shard = shardOf(hash_value(sc));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.scenarios.insert(sc).second;
+}
+
+unsigned long ScenarioSet::insert(const vector<Scenario> &scenarios)
+{
+    unsigned long added = 0;
+    BOOST_FOREACH (const Scenario &sc, scenarios)
+    {
+        if (insert(sc))
+        {
+            ++added;
+        }
+    }
+    return added;
+}
+
+bool ScenarioSet::contains(const Scenario &sc) const
+{
+    Shard &shard = shardOf(hash_value(sc));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.scenarios.count(sc) > 0;
+}
+
+size_t ScenarioSet::size() const
+{
+    size_t total = 0;
+    for (unsigned i = 0; i < shards.size(); ++i)
+    {
+        std::lock_guard<std::mutex> lock(shards[i]->mutex);
+        total += shards[i]->scenarios.size();
+    }
+    return total;
+}
+
+bool ScenarioSet::empty() const
+{
+    return size() == 0;
+}
+
+bool ScenarioSet::setTrees(const TreeExtended &gene_tree, const TreeExtended &species_tree)
+{
+    const uint64_t gene_hash = tree_hash(gene_tree);
+    const uint64_t species_hash = tree_hash(species_tree);
+    if (has_trees && gene_hash == gene_tree_hash && species_hash == species_tree_hash)
+    {
+        return false;
+    }
+    clear();
+    has_trees = true;
+    gene_tree_hash = gene_hash;
+    species_tree_hash = species_hash;
+    return true;
+}
+
+void ScenarioSet::clear()
+{
+    for (unsigned i = 0; i < shards.size(); ++i)
+    {
+        std::lock_guard<std::mutex> lock(shards[i]->mutex);
+        shards[i]->scenarios.clear();
+    }
+}
+
+vector<Scenario> ScenarioSet::getScenarios() const
+{
+    vector<Scenario> result;
+    for (unsigned i = 0; i < shards.size(); ++i)
+    {
+        std::lock_guard<std::mutex> lock(shards[i]->mutex);
+        result.insert(result.end(), shards[i]->scenarios.begin(), shards[i]->scenarios.end());
+    }
+    return result;
+}
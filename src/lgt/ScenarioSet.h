@@ -0,0 +1,110 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+/* ScenarioSet keeps one copy of every distinct scenario that is inserted,
+ * two scenarios are the same when they have the same duplications and the
+ * same transfer edges (the cost is not compared, so the results of runs
+ * with different event costs can be merged). The event lists of a Scenario
+ * are sorted, which makes them a canonical form that can be hashed directly.
+ * The set is split in shards with a lock each so that several producers can
+ * insert at the same time. Phyltr inserts the scenarios of a run in one
+ * batch when the run (or an anytime layer) is finished, see
+ * Phyltr::set_unique_scenarios(). The set remembers the trees its scenarios belong
+ * to, see setTrees(). */
+
+#ifndef SCENARIOSET_H
+#define SCENARIOSET_H
+
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <unordered_set>
+#include <stdint.h>
+
+#include "Phyltr.h"
+
+using namespace std;
+
+/* hash of the events of the scenario */
+size_t hash_value(const Scenario &sc);
+
+/* true if both scenarios have the same events */
+bool same_events(const Scenario &sc1, const Scenario &sc2);
+
+class ScenarioSet
+{
+
+public:
+
+    // constructor, shards is the number of independently locked parts
+    explicit ScenarioSet(unsigned shards = 16);
+    // destructor
+    virtual ~ScenarioSet();
+
+    // inserts the scenario if it is not there yet, returns true if it was new
+    bool insert(const Scenario &sc);
+    // inserts all the scenarios given, returns how many were new
+    unsigned long insert(const vector<Scenario> &scenarios);
+
+    // binds the set to the trees of the scenarios that will be inserted,
+    // the set is emptied if they are not the trees of the scenarios it
+    // holds. Returns true if it was emptied. Not to be called while
+    // scenarios are being inserted.
+    bool setTrees(const TreeExtended &gene_tree, const TreeExtended &species_tree);
+
+    bool contains(const Scenario &sc) const;
+    size_t size() const;
+    bool empty() const;
+    void clear();
+
+    // copy of the unique scenarios, in no particular order
+    vector<Scenario> getScenarios() const;
+
+private:
+
+    struct Hash
+    {
+        size_t operator()(const Scenario &sc) const;
+    };
+
+    struct Equal
+    {
+        bool operator()(const Scenario &sc1, const Scenario &sc2) const;
+    };
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_set<Scenario, Hash, Equal> scenarios;
+    };
+
+    ScenarioSet(const ScenarioSet &);
+    ScenarioSet& operator=(const ScenarioSet &);
+
+    Shard& shardOf(size_t hash) const;
+
+    std::vector<std::unique_ptr<Shard> > shards;
+    bool has_trees;
+    uint64_t gene_tree_hash;
+    uint64_t species_tree_hash;
+};
+
+#endif // SCENARIOSET_H
@@ -0,0 +1,858 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+#include "NHXParser.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <sstream>
+#include <stdint.h>
+
+#include "../utils/AnError.h"
+
+namespace
+{
+    // the tags with a known type, the others can hold any value
+    struct KnownTag
+    {
+        const char *tag;
+        NHXAnnotation::Type type;
+    };
+
+    const KnownTag known_tags[] =
+    {
+        { "S",  NHXAnnotation::String },
+        { "AC", NHXAnnotation::IntegerList },
+        { "ID", NHXAnnotation::Integer },
+        { "NT", NHXAnnotation::Float },
+        { "BL", NHXAnnotation::Float },
+        { "ET", NHXAnnotation::Float },
+        { "NW", NHXAnnotation::Float },
+        { "EX", NHXAnnotation::Integer },
+        { "D",  NHXAnnotation::Integer },
+        { "TT", NHXAnnotation::Float },
+        { 0,    NHXAnnotation::String }
+    };
+
+    const char *markup_starts[] = { "[&&NHX", "[&&PRIME", "[&&BEEP", 0 };
+
+    const NHXString newick_weight_tag = { "NW", 2 };
+
+    // true if the '[' at p starts extended annotations and not a comment
+    bool isMarkup(const char *p, const char *end)
+    {
+        const size_t left = end - p;
+        for (unsigned i = 0; markup_starts[i] != 0; i++)
+        {
+            const size_t length = strlen(markup_starts[i]);
+            if (left >= length && strncmp(p, markup_starts[i], length) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // characters that end a name outside the markup
+    inline bool endsName(char c)
+    {
+        return isSpace(c) || c == '(' || c == ')' || c == '[' || c == ']'
+                || c == '\'' || c == ',' || c == ':' || c == ';';
+    }
+
+    // characters that end a tag or a value in the markup
+    inline bool endsToken(char c)
+    {
+        return isSpace(c) || c == '=' || c == '(' || c == ')' || c == '['
+                || c == ']' || c == '\'' || c == ',' || c == ':';
+    }
+
+    inline bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    // the end of the number that starts at p, p if there is none. The
+    // number is [+-]?(digits(.digits?)?|.digits)([eE][+-]?digits)?
+    const char* scanNumber(const char *p, const char *end, bool &integral)
+    {
+        const char *start = p;
+        if (p != end && (*p == '+' || *p == '-'))
+        {
+            ++p;
+        }
+        const char *digits = p;
+        while (p != end && isDigit(*p))
+        {
+            ++p;
+        }
+        bool has_digits = p != digits;
+        integral = true;
+        if (p != end && *p == '.')
+        {
+            const char *fraction = ++p;
+            while (p != end && isDigit(*p))
+            {
+                ++p;
+            }
+            has_digits = has_digits || p != fraction;
+            integral = false;
+        }
+        if (!has_digits)
+        {
+            return start;
+        }
+        if (p != end && (*p == 'e' || *p == 'E'))
+        {
+            const char *q = p + 1;
+            if (q != end && (*q == '+' || *q == '-'))
+            {
+                ++q;
+            }
+            if (q != end && isDigit(*q))
+            {
+                while (q != end && isDigit(*q))
+                {
+                    ++q;
+                }
+                p = q;
+                integral = false;
+            }
+        }
+        return p;
+    }
+
+    // A number of at most 19 significant digits that is below 2^53 and a
+    // power of ten up to 10^22 are both exact doubles, so one multiplication
+    // or division gives the correctly rounded value. The other numbers are
+    // left to strtod.
+    double toDouble(const char *begin, const char *end)
+    {
+        static const double powers[] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        const char *p = begin;
+        const bool negative = *p == '-';
+        if (*p == '-' || *p == '+')
+        {
+            ++p;
+        }
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool exact = true;
+        bool fraction = false;
+        for (; p != end && *p != 'e' && *p != 'E'; ++p)
+        {
+            if (*p == '.')
+            {
+                fraction = true;
+                continue;
+            }
+            if (mantissa == 0 && *p == '0')
+            {
+                exponent -= fraction ? 1 : 0;
+                continue;
+            }
+            if (++digits > 19)
+            {
+                exact = false;
+                break;
+            }
+            mantissa = mantissa * 10 + (*p - '0');
+            exponent -= fraction ? 1 : 0;
+        }
+        if (exact && p != end)
+        {
+            ++p;
+            const bool negative_exponent = *p == '-';
+            if (*p == '-' || *p == '+')
+            {
+                ++p;
+            }
+            int e = 0;
+            for (; p != end && e < 1000; ++p)
+            {
+                e = e * 10 + (*p - '0');
+            }
+            exponent += negative_exponent ? -e : e;
+        }
+        if (exact && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+        {
+            double value = static_cast<double>(mantissa);
+            value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+            return negative ? -value : value;
+        }
+        return strtod(std::string(begin, end).c_str(), 0);
+    }
+
+    // false if the value does not fit in an int
+    bool toInteger(const char *begin, const char *end, int &value)
+    {
+        const char *p = begin;
+        const bool negative = *p == '-';
+        if (*p == '-' || *p == '+')
+        {
+            ++p;
+        }
+        long long v = 0;
+        for (; p != end; ++p)
+        {
+            v = v * 10 + (*p - '0');
+            if (v > static_cast<long long>(INT_MAX) + 1)
+            {
+                return false;
+            }
+        }
+        v = negative ? -v : v;
+        if (v > INT_MAX || v < INT_MIN)
+        {
+            return false;
+        }
+        value = static_cast<int>(v);
+        return true;
+    }
+}
+
+bool NHXString::operator==(const char *s) const
+{
+    return strncmp(data, s, length) == 0 && s[length] == '\0';
+}
+
+NHXTree::NHXTree()
+    : nodes(),
+      annotations(),
+      integers()
+{
+
+}
+
+NHXTree::~NHXTree()
+{
+
+}
+
+unsigned NHXTree::size() const
+{
+    return static_cast<unsigned>(nodes.size());
+}
+
+bool NHXTree::empty() const
+{
+    return nodes.empty();
+}
+
+unsigned NHXTree::getRoot() const
+{
+    return nodes.empty() ? NO_NODE : size() - 1;
+}
+
+const NHXNode& NHXTree::operator[](unsigned v) const
+{
+    assert(v < nodes.size());
+    return nodes[v];
+}
+
+bool NHXTree::isLeaf(unsigned v) const
+{
+    return nodes[v].left == NO_NODE && nodes[v].right == NO_NODE;
+}
+
+bool NHXTree::isRoot(unsigned v) const
+{
+    return nodes[v].parent == NO_NODE;
+}
+
+const NHXAnnotation* NHXTree::findAnnotation(unsigned v, const char *tag) const
+{
+    const NHXNode &n = nodes[v];
+    for (unsigned i = n.first_annotation + n.annotations; i > n.first_annotation; i--)
+    {
+        if (annotations[i - 1].tag == tag)
+        {
+            return &annotations[i - 1];
+        }
+    }
+    return 0;
+}
+
+const NHXString* NHXTree::speciesName(unsigned v) const
+{
+    const NHXAnnotation *a = findAnnotation(v, "S");
+    return a != 0 ? &a->text : 0;
+}
+
+const int* NHXTree::getIntegers(const NHXAnnotation &a) const
+{
+    assert(a.type == NHXAnnotation::IntegerList);
+    return a.size == 0 ? 0 : &integers[a.first];
+}
+
+void NHXTree::clear()
+{
+    nodes.clear();
+    annotations.clear();
+    integers.clear();
+}
+
+void NHXTree::beginTree(unsigned size)
+{
+    clear();
+    nodes.reserve(size);
+}
+
+unsigned NHXTree::addLeaf(const NHXString &name)
+{
+    NHXNode n;
+    n.parent = NO_NODE;
+    n.left = NO_NODE;
+    n.right = NO_NODE;
+    n.name = name;
+    n.first_annotation = 0;
+    n.annotations = 0;
+    nodes.push_back(n);
+    return size() - 1;
+}
+
+unsigned NHXTree::addInner(unsigned left, unsigned right)
+{
+    const NHXString none = { "", 0 };
+    const unsigned v = addLeaf(none);
+    nodes[v].left = left;
+    nodes[v].right = right;
+    nodes[left].parent = v;
+    nodes[right].parent = v;
+    return v;
+}
+
+void NHXTree::setName(unsigned v, const NHXString &name)
+{
+    nodes[v].name = name;
+}
+
+void NHXTree::addAnnotation(unsigned v, const NHXAnnotation &a, const int *values)
+{
+    NHXNode &n = nodes[v];
+    // the annotations of a node are given one after the other
+    assert(n.annotations == 0 || n.first_annotation + n.annotations == annotations.size());
+    if (n.annotations++ == 0)
+    {
+        n.first_annotation = static_cast<unsigned>(annotations.size());
+    }
+    annotations.push_back(a);
+    if (a.type == NHXAnnotation::IntegerList)
+    {
+        annotations.back().first = static_cast<unsigned>(integers.size());
+        integers.insert(integers.end(), values, values + a.size);
+    }
+}
+
+void NHXTree::endTree(unsigned root)
+{
+    assert(root == getRoot());
+    (void)root;
+}
+
+NHXSink::~NHXSink()
+{
+
+}
+
+NHXParser::NHXParser(const char *begin, const char *end, const std::string &source,
+                     unsigned line)
+    : position(begin),
+      end(end),
+      source(source),
+      line(line),
+      stack(),
+      integers(),
+      sink(0)
+{
+
+}
+
+NHXParser::~NHXParser()
+{
+
+}
+
+unsigned NHXParser::getLine() const
+{
+    return line;
+}
+
+const char* NHXParser::getPosition() const
+{
+    return position;
+}
+
+// The count is only taken when a '(' follows it on the same line, "1 a;"
+// and "1\n(a, b);" are read as two trees as before.
+bool NHXParser::readCount(double &count)
+{
+    while (skipSpace() && *position == ';')
+    {
+        ++position;
+    }
+    if (position == end)
+    {
+        return false;
+    }
+    bool integral;
+    const char *number_end = scanNumber(position, end, integral);
+    if (number_end == position || number_end == end
+            || (*number_end != ' ' && *number_end != '\t'))
+    {
+        return false;
+    }
+    const char *p = number_end;
+    while (p != end && (*p == ' ' || *p == '\t'))
+    {
+        ++p;
+    }
+    if (p == end || *p != '(')
+    {
+        return false;
+    }
+    count = toDouble(position, number_end);
+    position = p;
+    return true;
+}
+
+bool NHXParser::next(NHXSink &tree_sink)
+{
+    sink = &tree_sink;
+    stack.clear();
+    while (skipSpace() && *position == ';')
+    {
+        ++position;
+    }
+    if (position == end)
+    {
+        return false;
+    }
+    sink->beginTree(countNodes());
+
+    for (;;)
+    {
+        // a subtree starts here
+        if (!skipSpace())
+        {
+            error("The input ends inside of a tree");
+        }
+        if (*position == '(')
+        {
+            ++position;
+            Group group = { 0, 0 };
+            stack.push_back(group);
+            continue;
+        }
+        const NHXString name = readName();
+        if (name.empty())
+        {
+            error(std::string("Expected a subtree but found '") + *position + "'");
+        }
+        unsigned v = sink->addLeaf(name);
+        readSuffix(v);
+
+        // close the groups that end after it
+        for (;;)
+        {
+            if (stack.empty())
+            {
+                if (skipSpace() && *position == ';')
+                {
+                    ++position;
+                }
+                sink->endTree(v);
+                return true;
+            }
+            addChild(v);
+            if (!skipSpace())
+            {
+                error("The input ends inside of a tree, unbalanced parenthesis");
+            }
+            if (*position == ',')
+            {
+                ++position;
+                break;
+            }
+            if (*position != ')')
+            {
+                error(std::string("Expected ',' or ')' but found '") + *position + "'");
+            }
+            ++position;
+            v = stack.back().node;
+            stack.pop_back();
+            if (skipSpace())
+            {
+                const NHXString label = readName();
+                if (!label.empty())
+                {
+                    sink->setName(v, label);
+                }
+            }
+            readSuffix(v);
+        }
+    }
+}
+
+bool NHXParser::skipSpace()
+{
+    while (position != end)
+    {
+        if (isSpace(*position))
+        {
+            line += *position == '\n' ? 1 : 0;
+            ++position;
+            continue;
+        }
+        if (*position != '[' || isMarkup(position, end))
+        {
+            return true;
+        }
+        // a comment
+        const unsigned start = line;
+        while (position != end && *position != ']')
+        {
+            line += *position == '\n' ? 1 : 0;
+            ++position;
+        }
+        if (position == end)
+        {
+            std::ostringstream oss;
+            oss << "The comment started at line " << start << " is not closed";
+            error(oss.str());
+        }
+        ++position;
+    }
+    return false;
+}
+
+// Each ',' of the tree joins two subtrees, so a tree with n commas has
+// 2n + 1 nodes. The names, comments and annotations are skipped as the
+// parser reads them. In a broken tree the parser stops at the error before
+// the count can go wrong, so the sink never sees more nodes than counted.
+unsigned NHXParser::countNodes() const
+{
+    const char *p = position;
+    if (*p != '(')
+    {
+        return 1;
+    }
+    unsigned depth = 0;
+    unsigned commas = 0;
+    for (; p != end; ++p)
+    {
+        if (*p == '(')
+        {
+            depth++;
+        }
+        else if (*p == ')')
+        {
+            if (--depth == 0)
+            {
+                break;
+            }
+        }
+        else if (*p == ',')
+        {
+            commas++;
+        }
+        else if (*p == '\'')
+        {
+            p = static_cast<const char*>(memchr(p + 1, '\'', end - p - 1));
+            if (p == 0)
+            {
+                break;
+            }
+        }
+        else if (*p == '[')
+        {
+            // the values in the annotations can be quoted
+            const bool markup = isMarkup(p, end);
+            while (++p != end && *p != ']')
+            {
+                if (markup && *p == '\'')
+                {
+                    p = static_cast<const char*>(memchr(p + 1, '\'', end - p - 1));
+                    if (p == 0)
+                    {
+                        return 2 * commas + 1;
+                    }
+                }
+            }
+            if (p == end)
+            {
+                break;
+            }
+        }
+    }
+    return 2 * commas + 1;
+}
+
+NHXString NHXParser::readName()
+{
+    NHXString name = { position, 0 };
+    if (position != end && *position == '\'')
+    {
+        const char *start = ++position;
+        while (position != end && *position != '\'')
+        {
+            line += *position == '\n' ? 1 : 0;
+            ++position;
+        }
+        if (position == end)
+        {
+            error("A quoted name is not closed");
+        }
+        name.data = start;
+        name.length = static_cast<unsigned>(position - start);
+        ++position;
+        return name;
+    }
+    while (position != end && !endsName(*position))
+    {
+        ++position;
+    }
+    name.length = static_cast<unsigned>(position - name.data);
+    return name;
+}
+
+void NHXParser::readSuffix(unsigned v)
+{
+    bool weight = false;
+    while (skipSpace())
+    {
+        if (*position == ':' && !weight)
+        {
+            ++position;
+            skipSpace();
+            NHXAnnotation a = NHXAnnotation();
+            bool integral;
+            if (!readNumber(a.text, integral))
+            {
+                error("Expected a branch length");
+            }
+            a.tag = newick_weight_tag;
+            a.type = NHXAnnotation::Float;
+            a.number = toDouble(a.text.data, a.text.data + a.text.length);
+            sink->addAnnotation(v, a, 0);
+            weight = true;
+        }
+        else if (*position == '[')
+        {
+            readMarkup(v);
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+void NHXParser::readMarkup(unsigned v)
+{
+    while (*position != '&')
+    {
+        ++position;
+    }
+    while (position != end && !endsToken(*position))
+    {
+        ++position;
+    }
+
+    for (;;)
+    {
+        while (position != end && (isSpace(*position) || *position == ',' || *position == ':'))
+        {
+            line += *position == '\n' ? 1 : 0;
+            ++position;
+        }
+        if (position == end)
+        {
+            error("The extended annotations are not closed");
+        }
+        if (*position == ']')
+        {
+            ++position;
+            return;
+        }
+
+        NHXAnnotation a = NHXAnnotation();
+        a.tag.data = position;
+        while (position != end && !endsToken(*position))
+        {
+            ++position;
+        }
+        a.tag.length = static_cast<unsigned>(position - a.tag.data);
+        while (position != end && (*position == ' ' || *position == '\t'))
+        {
+            ++position;
+        }
+        if (a.tag.empty() || position == end || *position != '=')
+        {
+            error("Syntax error in extended annotations");
+        }
+        ++position;
+        while (position != end && (*position == ' ' || *position == '\t'))
+        {
+            ++position;
+        }
+        readValue(a);
+        sink->addAnnotation(v, a, integers.empty() ? 0 : &integers[0]);
+    }
+}
+
+void NHXParser::readValue(NHXAnnotation &a)
+{
+    integers.clear();
+    if (position != end && *position == '(')
+    {
+        a.text.data = position++;
+        a.type = NHXAnnotation::IntegerList;
+        for (;;)
+        {
+            while (position != end && (isSpace(*position) || *position == ','))
+            {
+                line += *position == '\n' ? 1 : 0;
+                ++position;
+            }
+            if (position == end || *position == ')')
+            {
+                break;
+            }
+            const char *start = position;
+            while (position != end && !endsToken(*position))
+            {
+                ++position;
+            }
+            bool integral;
+            int value;
+            if (position == start || scanNumber(start, position, integral) != position
+                    || !integral || !toInteger(start, position, value))
+            {
+                error("Wrong value type, expected a list of integers for " + a.tag.str());
+            }
+            integers.push_back(value);
+        }
+        if (position == end)
+        {
+            error("A list of integers is not closed");
+        }
+        ++position;
+        a.text.length = static_cast<unsigned>(position - a.text.data);
+        a.size = static_cast<unsigned>(integers.size());
+    }
+    else if (position != end && *position == '\'')
+    {
+        a.text = readName();
+        a.type = NHXAnnotation::String;
+    }
+    else
+    {
+        a.text.data = position;
+        while (position != end && !endsToken(*position))
+        {
+            ++position;
+        }
+        a.text.length = static_cast<unsigned>(position - a.text.data);
+        if (a.text.empty())
+        {
+            error("Wrong value type for " + a.tag.str());
+        }
+        const char *text_end = a.text.data + a.text.length;
+        bool integral;
+        if (scanNumber(a.text.data, text_end, integral) != text_end)
+        {
+            a.type = NHXAnnotation::String;
+        }
+        else if (integral && toInteger(a.text.data, text_end, a.integer))
+        {
+            a.type = NHXAnnotation::Integer;
+            a.number = a.integer;
+        }
+        else
+        {
+            a.type = NHXAnnotation::Float;
+            a.number = toDouble(a.text.data, text_end);
+        }
+    }
+
+    // check the type of the known tags
+    for (unsigned i = 0; known_tags[i].tag != 0; i++)
+    {
+        if (a.tag == known_tags[i].tag)
+        {
+            const NHXAnnotation::Type expected = known_tags[i].type;
+            if (expected == NHXAnnotation::String && a.type != NHXAnnotation::IntegerList)
+            {
+                a.type = NHXAnnotation::String;
+            }
+            else if (expected == NHXAnnotation::Float && a.type == NHXAnnotation::Integer)
+            {
+                a.type = NHXAnnotation::Float;
+            }
+            if (a.type != expected)
+            {
+                error("Wrong type for tag " + a.tag.str());
+            }
+            break;
+        }
+    }
+}
+
+bool NHXParser::readNumber(NHXString &text, bool &integral)
+{
+    const char *stop = scanNumber(position, end, integral);
+    text.data = position;
+    text.length = static_cast<unsigned>(stop - position);
+    position = stop;
+    return text.length != 0;
+}
+
+void NHXParser::addChild(unsigned v)
+{
+    Group &group = stack.back();
+    if (group.children++ == 0)
+    {
+        group.node = v;
+        return;
+    }
+    group.node = sink->addInner(group.node, v);
+}
+
+void NHXParser::error(const std::string &message) const
+{
+    std::ostringstream oss;
+    oss << source << ":line " << line << ": " << message;
+    throw AnError(oss.str(), 1);
+}
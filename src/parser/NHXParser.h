@@ -0,0 +1,231 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+/* A reentrant parser for trees in Newick format with NHX/PRIME markup.
+ *
+ * All the state of the parser is kept in the NHXParser object, so several
+ * parsers can run at the same time on different threads. The input is not
+ * copied: the names and the strings given to the sink point into the input
+ * buffer, which has to outlive them. The numbers are read as doubles. The
+ * nesting of the tree is kept in an explicit stack, so deep trees do not
+ * exhaust the call stack.
+ *
+ * The parser does not build a tree itself, it reports the nodes, the edges
+ * and the annotations to an NHXSink as it reads them. TreeBuilder creates a
+ * TreeExtended from them and NHXTree keeps them as they are.
+ *
+ * The syntax is the one the flex/bison parser accepted:
+ *
+ *   tree       : subtree ';'?
+ *   subtree    : (name | '(' subtree (',' subtree)* ')' name?) suffix
+ *   suffix     : (':' number)? markup*
+ *   markup     : '[&&NHX' annotation* ']' | '[&&PRIME' ... | '[&&BEEP' ...
+ *   annotation : tag '=' (string | number | '(' integer* ')') (',' | ':')?
+ *
+ * Any other [...] is a comment. The nodes with more than two children are
+ * resolved as ((a, b), c). The newick weight is reported as the annotation
+ * NW. The name and the annotations of (a)x are given to a. A file can hold
+ * several trees, they are returned in the order given. In the files of
+ * sampled trees a line may start with the number of times its tree was
+ * seen, readCount() takes that number off before the tree is read. */
+
+#ifndef NHXPARSER_H
+#define NHXPARSER_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A piece of the input buffer
+struct NHXString
+{
+    const char *data;
+    unsigned length;
+
+    std::string str() const { return std::string(data, length); }
+    bool empty() const { return length == 0; }
+    // compares with a 0 terminated string
+    bool operator==(const char *s) const;
+};
+
+struct NHXAnnotation
+{
+    enum Type
+    {
+        String,
+        Integer,
+        Float,
+        IntegerList
+    };
+
+    NHXString tag;
+    Type type;
+    NHXString text;    // the value as given, without the quotes
+    int integer;       // for Integer
+    double number;     // for Integer and Float
+    unsigned first;    // for IntegerList in NHXTree, the first value in getIntegers()
+    unsigned size;     // for IntegerList, number of values
+};
+
+struct NHXNode
+{
+    unsigned parent;   // NHXTree::NO_NODE if there is none
+    unsigned left;
+    unsigned right;
+    NHXString name;    // empty if the node has no name
+    unsigned first_annotation;
+    unsigned annotations;
+};
+
+// Receives a tree from NHXParser while it is read. The nodes are reported
+// in postorder, the name and the annotations of a node come right after it
+// and before the next node is reported.
+class NHXSink
+{
+
+public:
+
+    // destructor
+    virtual ~NHXSink();
+
+    // a tree with the number of nodes given starts
+    virtual void beginTree(unsigned nodes) = 0;
+    // a leaf, returns the handle used for it in the other calls
+    virtual unsigned addLeaf(const NHXString &name) = 0;
+    // the parent of the subtrees left and right
+    virtual unsigned addInner(unsigned left, unsigned right) = 0;
+    // the label of an inner node
+    virtual void setName(unsigned v, const NHXString &name) = 0;
+    // an annotation of v, values holds the integers of an IntegerList
+    virtual void addAnnotation(unsigned v, const NHXAnnotation &a, const int *values) = 0;
+    // the tree is complete
+    virtual void endTree(unsigned root) = 0;
+};
+
+// The nodes of a parsed tree in postorder, the root is the last one
+class NHXTree : public NHXSink
+{
+
+public:
+
+    static const unsigned NO_NODE = static_cast<unsigned>(-1);
+
+    // constructor
+    explicit NHXTree();
+    // destructor
+    virtual ~NHXTree();
+
+    // number of nodes
+    unsigned size() const;
+    bool empty() const;
+    unsigned getRoot() const;
+    const NHXNode& operator[](unsigned v) const;
+    bool isLeaf(unsigned v) const;
+    bool isRoot(unsigned v) const;
+
+    // the last annotation of v with the tag given, 0 if there is none
+    const NHXAnnotation* findAnnotation(unsigned v, const char *tag) const;
+    // the string of the annotation S of v, 0 if there is none
+    const NHXString* speciesName(unsigned v) const;
+    // the values of the integer lists
+    const int* getIntegers(const NHXAnnotation &a) const;
+
+    // keeps the memory for the next tree
+    void clear();
+
+    // NHXSink
+    virtual void beginTree(unsigned nodes);
+    virtual unsigned addLeaf(const NHXString &name);
+    virtual unsigned addInner(unsigned left, unsigned right);
+    virtual void setName(unsigned v, const NHXString &name);
+    virtual void addAnnotation(unsigned v, const NHXAnnotation &a, const int *values);
+    virtual void endTree(unsigned root);
+
+private:
+
+    std::vector<NHXNode> nodes;
+    std::vector<NHXAnnotation> annotations;
+    std::vector<int> integers;
+};
+
+class NHXParser
+{
+
+public:
+
+    // parses [begin, end), source names the input in the error messages
+    // and line is the line of the input begin is at
+    explicit NHXParser(const char *begin, const char *end,
+                       const std::string &source = "<input string>",
+                       unsigned line = 1);
+    // destructor
+    virtual ~NHXParser();
+
+    // parses the next tree into sink, returns false at the end of the input.
+    // Throws AnError if the tree is not well formed, the sink may then have
+    // seen a part of the tree.
+    bool next(NHXSink &sink);
+
+    // reads the number in front of the next tree, as in "   2 ((a, b), c);".
+    // Returns false and leaves the input as it is if the tree has none
+    bool readCount(double &count);
+
+    // the line of the input the parser is at
+    unsigned getLine() const;
+    // the first character not read yet
+    const char* getPosition() const;
+
+private:
+
+    // an open '(' and the subtree of its children read so far
+    struct Group
+    {
+        unsigned node;
+        unsigned children;
+    };
+
+    // skips white space, comments and ';', returns false at the end
+    bool skipSpace();
+    // the number of nodes of the tree that starts at position
+    unsigned countNodes() const;
+    NHXString readName();
+    // the branch length and the annotations of v
+    void readSuffix(unsigned v);
+    void readMarkup(unsigned v);
+    void readValue(NHXAnnotation &a);
+    // a number as the flex parser read them, returns false if there is none
+    bool readNumber(NHXString &text, bool &integral);
+    // adds v to the open group on top of the stack
+    void addChild(unsigned v);
+    void error(const std::string &message) const;
+
+    const char *position;
+    const char *end;
+    std::string source;
+    unsigned line;
+    std::vector<Group> stack;
+    std::vector<int> integers;    // the values of the list being read
+    NHXSink *sink;                // the sink of the tree being read
+};
+
+#endif // NHXPARSER_H
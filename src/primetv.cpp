@@ -109,6 +109,7 @@ main (int ac, char *av[])
         std::string genetree;
         std::string mapfile;
         std::string precomputed_scenario_file;
+        std::string export_scenario_file;
         std::string colorconfig;
         bool show_lgt_scenarios = false;
         bool load_precomputed_lgt_scenario = false;
@@ -138,6 +139,11 @@ main (int ac, char *av[])
                  "Indicates that the Guest tree is not reconciled. By default,"
                  "it is assumed that the Guest Tree is already reconciled in PRIME format."
                  "This option requires a third input file which maps guest tree leaves to host tree leaves")
+                ("gene-sample", po::bool_switch(&parameters->genesample)->default_value(false),
+                 "Indicates that the Guest tree file is a sample of trees (e.g. a posterior sample, a tree "
+                 "may be preceded by its count). Each topology of the sample is reconciled once and weighted "
+                 "by its count, the most frequent one is drawn. "
+                 "This option requires the option -r(reconciled)")
                 ("config,C", po::value<string>(&config_file)->default_value(default_config_file),
                  "Name of a file of a configuration.");
 
@@ -202,6 +208,12 @@ main (int ac, char *av[])
                 ("event-costs,P", po::value<std::vector<float> >()->multitoken(),
                  "<float>: [<min>] [<max>] [<dupli. cost>] [<trans. cost>] Parameters that give (1) minimum reconciliation cost,"
                  "(2) maximum reconciliation, (3) duplication cost, and (4) LGT cost.")
+                ("lgt-anytime", po::bool_switch(&parameters->lateralanytime)->default_value(false),
+                 "Compute the LGT scenarios raising the cost bound step by step and report "
+                 "each complete layer of scenarios as soon as it is found.")
+                ("lgt-budget", po::value<std::vector<float> >()->multitoken(),
+                 "<float> [<unsigned>] Stop the anytime LGT search (option --lgt-anytime) after "
+                 "<float> seconds or after the layer that reaches <unsigned> scenarios, 0 means no limit.")
                 ("show-event-count", po::bool_switch(&parameters->show_event_count),
                  "Show the number of duplications and transfers used in the computed reconciliation.")
                 ("vertical,V", po::bool_switch(&parameters->horiz)->default_value(false),
@@ -214,7 +226,11 @@ main (int ac, char *av[])
                  "Draw a file for each pre-computed LGT scenario.")
                 ("precomputed-lgt-scenario,X", po::value<string>(&precomputed_scenario_file),
                  "<string> name of the file containing the scenario as: \nTransfer edges Numbers: (9,2,0.12)\n"
-                 "Where 9 is origin, 2 destiny and 0.12 time.");
+                 "Where 9 is origin, 2 destiny and 0.12 time. A binary file written with --export-scenarios "
+                 "can be given as well, its cheapest scenario is used.")
+                ("export-scenarios", po::value<string>(&export_scenario_file),
+                 "<string> write all the computed LGT scenarios to a compressed binary file "
+                 "(only valid if option -l is activated).");
 
 
         // Hidden options, will be allowed both on command line and
@@ -383,6 +399,17 @@ main (int ac, char *av[])
             //TODO do a better check of wheter to use DP or not
         }
 
+        if (vm.count("lgt-budget"))
+        {
+            const vector<float> &budget = vm["lgt-budget"].as< vector<float> >();
+            parameters->lateraltimebudget = std::max(budget.at(0), 0.0f);
+            if (budget.size() > 1)
+            {
+                parameters->lateralmaxscenarios = static_cast<unsigned>(std::max(budget.at(1), 0.0f));
+            }
+            parameters->lateralanytime = true;
+        }
+
         if (vm.count("fontscale") > 1)
         {
             if(parameters->fontscale >= 20 || parameters->fontscale < 1)
@@ -476,6 +503,36 @@ main (int ac, char *av[])
             return EXIT_FAILURE;
         }
 
+        if (vm.count("export-scenarios") && !(bool)(parameters->lattransfer))
+        {
+            std::cerr << "The option --export-scenarios has to be used together with "
+                         "the option -l(lgt).." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if ((bool)(parameters->genesample) && !(bool)(parameters->isreconciled))
+        {
+            std::cerr << "The option --gene-sample has to be used together with "
+                         "the option -r(reconciled).." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if ((bool)(parameters->lateralanytime) && !(bool)(parameters->lattransfer))
+        {
+            std::cerr << "The option --lgt-anytime has to be used together with "
+                         "the option -l(lgt).." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if ((bool)(parameters->lateralanytime) && parameters->lateralmincost == 1.0
+                && parameters->lateralmaxcost == 1.0)
+        {
+            std::cerr << "The option --lgt-anytime needs a cost range given with "
+                         "the option -P(event-costs), the default costs use the "
+                         "dynamic programming algorithm.." << std::endl;
+            return EXIT_FAILURE;
+        }
+
         //********************************************************************************************//
 
         mainops = new Mainops(); //object that cointains all the main operations
@@ -527,6 +584,11 @@ main (int ac, char *av[])
                 mainops->printLGT();
             }
 
+            if(!export_scenario_file.empty())
+            {
+                mainops->exportLGT(export_scenario_file);
+            }
+
             std::cout << "The tree/s were generated succesfully" << std::endl;
 
         }
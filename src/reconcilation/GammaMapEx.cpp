@@ -102,61 +102,73 @@ GammaMapEx& GammaMapEx::operator=(const GammaMapEx& gm)
     return *this;
 }
 
+// The subtree of gn is checked in postorder with an explicit stack, the
+// host node of each guest node is kept for its parent
 Node* GammaMapEx::checkGamma(Node *gn)
 {
-    Node* sn = getLowestGammaPath(*gn);
-
-    if(gn->isLeaf())
+    std::vector<Node*> lowest(Gtree->getNumberOfNodes(), 0);
+    std::vector<std::pair<Node*, bool> > stack(1, std::make_pair(gn, false));
+    while (!stack.empty())
     {
-        // Lowest antichain of a leaf in G should always be a leaf in S
-        if(sn == 0)
-        {
-            ostringstream oss;
-            oss << "Reconciliation error:\nGuest tree leaf '"
-                << gn->getNumber()
-                << "' with label '"
-                << gn->getName()
-                << "' is not mapped to a species node.";
-            throw AnError(oss.str(), 1);
-        }
-        if (!sn->isLeaf())
+        Node *u = stack.back().first;
+        const bool children_done = stack.back().second;
+        stack.pop_back();
+
+        if (!u->isLeaf() && !children_done)
         {
-            ostringstream oss;
-            oss << "Reconciliation error:\nGuest tree leaf '"
-                << gn->getNumber()
-                << "' with label '"
-                << gn->getName()
-                << "' is not mapped to a species tree leaf.\n"
-                << "The current mapping is to '"
-                << sn
-                << "', curiously!\n";
-            throw AnError(oss.str(), 1);
+            stack.push_back(std::make_pair(u, true));
+            stack.push_back(std::make_pair(u->getRightChild(), false));
+            stack.push_back(std::make_pair(u->getLeftChild(), false));
+            continue;
         }
-    }
-    else
-    {
-        // pass recursion on
-        Node* gl = gn->getLeftChild();
-        Node* gr = gn->getRightChild();
-        Node* sl = checkGamma(gl);
-        Node* sr = checkGamma(gr);
 
-        if(sl == sr) // i.e., gn is a duplication
+        Node* sn = getLowestGammaPath(*u);
+
+        if(u->isLeaf())
         {
-            Node *temp = checkGammaForDuplication(gn, sn, sl, sr);
-            sn = temp;
+            // Lowest antichain of a leaf in G should always be a leaf in S
+            if(sn == 0)
+            {
+                ostringstream oss;
+                oss << "Reconciliation error:\nGuest tree leaf '"
+                    << u->getNumber()
+                    << "' with label '"
+                    << u->getName()
+                    << "' is not mapped to a species node.";
+                throw AnError(oss.str(), 1);
+            }
+            if (!sn->isLeaf())
+            {
+                ostringstream oss;
+                oss << "Reconciliation error:\nGuest tree leaf '"
+                    << u->getNumber()
+                    << "' with label '"
+                    << u->getName()
+                    << "' is not mapped to a species tree leaf.\n"
+                    << "The current mapping is to '"
+                    << sn
+                    << "', curiously!\n";
+                throw AnError(oss.str(), 1);
+            }
         }
-
         else
         {
-            Node *temp = checkGammaForSpeciation(gn, sn, sl, sr);
-            sn = temp;
+            Node* sl = lowest[u->getLeftChild()->getNumber()];
+            Node* sr = lowest[u->getRightChild()->getNumber()];
+
+            if(sl == sr) // i.e., u is a duplication
+            {
+                sn = checkGammaForDuplication(u, sn, sl, sr);
+            }
+            else
+            {
+                sn = checkGammaForSpeciation(u, sn, sl, sr);
+            }
         }
-    }
 
-    Node *temp = checkGammaMembership(gn, sn);
-    sn = temp;
-    return sn;
+        lowest[u->getNumber()] = checkGammaMembership(u, sn);
+    }
+    return lowest[gn->getNumber()];
 }
 
 // To determine whether a node is lateral transfer or not, we just need to
@@ -201,29 +213,43 @@ GammaMapEx::computeGammaBound(Node *v)
     }
 }
 
+// The children of a node are done before the node itself, in the same order
+// as a left to right postorder traversal
 void
 GammaMapEx::computeGammaBoundBelow(Node *v)
 {
     assert(v != 0);
 
-    if (v->isLeaf())
+    std::vector<std::pair<Node*, bool> > stack(1, std::make_pair(v, false));
+    while (!stack.empty())
     {
-        addToSet(lambdaex[v], *v);
-    }
-    else
-    {
-        Node *left = v->getLeftChild();
-        Node *right = v->getRightChild();
+        Node *u = stack.back().first;
+        const bool children_done = stack.back().second;
+        stack.pop_back();
+
+        if (u->isLeaf())
+        {
+            addToSet(lambdaex[u], *u);
+            continue;
+        }
 
-        computeGammaBoundBelow(left);
-        computeGammaBoundBelow(right);
+        Node *left = u->getLeftChild();
+        Node *right = u->getRightChild();
 
-        Node *x = lambdaex[v];
+        if (!children_done)
+        {
+            stack.push_back(std::make_pair(u, true));
+            stack.push_back(std::make_pair(right, false));
+            stack.push_back(std::make_pair(left, false));
+            continue;
+        }
+
+        Node *x = lambdaex[u];
         Node *xl = lambdaex[left];
         Node *xr = lambdaex[right];
         if (x != xl && x != xr)
         {
-            addToSet(x, *v);
+            addToSet(x, *u);
             assignGammaBound(left, x->getDominatingChild(xl));
             assignGammaBound(right,  x->getDominatingChild(xr));
         }
@@ -548,16 +574,24 @@ GammaMapEx::twistAndTurn(TreeExtended *G, TreeExtended *S)
     twistAndTurn(G->getRootNode(), S->getRootNode());
 }
 
+// The pairs of gene and species nodes left to visit are kept on an explicit
+// stack, the rotations of a node do not affect the other subtrees
 void
 GammaMapEx::twistAndTurn(Node *v, Node *x)
 {
-
-    if (v->isLeaf() || x->isLeaf())
-    {
-        // Done
-    }
-    else
+    std::vector<std::pair<Node*, Node*> > stack(1, std::make_pair(v, x));
+    while (!stack.empty())
     {
+        v = stack.back().first;
+        x = stack.back().second;
+        stack.pop_back();
+
+        if (v->isLeaf() || x->isLeaf())
+        {
+            // Done
+            continue;
+        }
+
         Node *vl = v->getLeftChild();
         Node *vr = v->getRightChild();
 
@@ -595,8 +629,8 @@ GammaMapEx::twistAndTurn(Node *v, Node *x)
                 //v->rotateCordinates();
             }
         }
-        twistAndTurn(vl, vll);
-        twistAndTurn(vr, vrl);
+        stack.push_back(std::make_pair(vr, vrl));
+        stack.push_back(std::make_pair(vl, vll));
     }
 }
 
@@ -29,18 +29,18 @@
 #include "options_cmake.h"
 
 LambdaMapEx::LambdaMapEx(unsigned Nnodes)
-    : NodeVector(Nnodes),
+    : NodeMap<Node*>(Nnodes),
       description()
 {
 }
 
 LambdaMapEx::LambdaMapEx(const TreeExtended& G,const TreeExtended& S, const StrStrMap &gs)
-    : NodeVector(G.getNumberOfNodes()),
+    : NodeMap<Node*>(G.getNumberOfNodes()),
       description()
 {
     try
     {
-        recursiveLambda(G.getRootNode(),S,gs);
+        computeLambda(G, S, &gs);
     }
     catch (AnError& err)
     {
@@ -53,14 +53,14 @@ LambdaMapEx::LambdaMapEx(const TreeExtended& G,const TreeExtended& S, const StrS
 }
 
 LambdaMapEx::LambdaMapEx(const LambdaMapEx& l)
-    : NodeVector(l),
+    : NodeMap<Node*>(l),
       description(l.description)
 {
 
 }
 
 LambdaMapEx::LambdaMapEx()
-    : NodeVector(0),
+    : NodeMap<Node*>(),
       description()
 {
 
@@ -71,7 +71,7 @@ LambdaMapEx::operator=(const LambdaMapEx &l)
 {
     if (&l != this)
     {
-        NodeVector::operator=(l);
+        NodeMap<Node*>::operator=(l);
         description = l.description;
     }
     return *this;
@@ -84,15 +84,7 @@ LambdaMapEx::~LambdaMapEx()
 
 void LambdaMapEx::update(const TreeExtended& G, const TreeExtended& S, StrStrMap* gs)
 {
-    if(gs)
-    {
-        recursiveLambda(G.getRootNode(), S, *gs);
-    }
-    else
-    {
-        recursiveLambda(G.getRootNode(), S);
-    }
-    return;
+    computeLambda(G, S, gs);
 }
 
 void LambdaMapEx::update(const TreeExtended& G, const TreeExtended& S,
@@ -102,33 +94,54 @@ void LambdaMapEx::update(const TreeExtended& G, const TreeExtended& S,
 
     clearValues();
 
-    for (Node *u = G.postorder_begin();
-         u != 0;
-         u = G.postorder_next(u))
+    // The placement of u is the lca of the first and the last species in
+    // the preorder of S among the leaves reached from u without crossing a
+    // transfer edge, see compute_lambda(). The lca queries are answered in
+    // one batch.
+    const std::vector<unsigned> &order = G.postorder();
+    const std::vector<unsigned> &species_preorder = S.preorder();
+    std::vector<std::pair<unsigned, unsigned> > range(G.getNumberOfNodes());
+    for (unsigned i = 0; i < order.size(); ++i)
     {
+        const unsigned uid = order[i];
+
         // Take care of gene tree leaves and continue.
-        if (u->isLeaf())
+        if (G.is_leaf(uid))
         {
-            pv[u->getNumber()] = S.getNode(sigma[u->getNumber()]);
+            const unsigned entry = S.dfs_entry(sigma[uid]);
+            range[uid] = std::make_pair(entry, entry);
             continue;
         }
 
-        Node *v = u->getLeftChild();
-        Node *w = u->getRightChild();
+        const unsigned v = G.left(uid);
+        const unsigned w = G.right(uid);
 
-        if ((bool)transfer_edges[v->getNumber()])
+        if ((bool)transfer_edges[v])
         {
-            pv[u->getNumber()] = pv[w->getNumber()];
+            range[uid] = range[w];
         }
-        else if ((bool)transfer_edges[w->getNumber()])
+        else if ((bool)transfer_edges[w])
         {
-            pv[u->getNumber()] = pv[v->getNumber()];
+            range[uid] = range[v];
         }
         else
         {
-            pv[u->getNumber()] = S.lca(pv[w->getNumber()],pv[v->getNumber()]);
+            range[uid] = std::make_pair(std::min(range[v].first, range[w].first),
+                                        std::max(range[v].second, range[w].second));
         }
     }
+
+    for (unsigned u = 0; u < range.size(); ++u)
+    {
+        range[u].first = species_preorder[range[u].first];
+        range[u].second = species_preorder[range[u].second];
+    }
+    std::vector<unsigned> lambda;
+    S.lca(range, lambda);
+    for (unsigned u = 0; u < lambda.size(); ++u)
+    {
+        pv[u] = S.getNode(lambda[u]);
+    }
 }
 
 void LambdaMapEx::update(const TreeExtended &G, const TreeExtended &S,
@@ -161,37 +174,28 @@ LambdaMapEx::print() const
 }
 
 
-Node* LambdaMapEx::recursiveLambda(Node *g,const TreeExtended& S, const StrStrMap& gs)
-{
-    if(g->isLeaf())
-    {
-        return compLeafLambda(g, S, gs);
-    }
-    else
-    {
-
-        Node *ls = recursiveLambda(g->getLeftChild(), S, gs);
-        Node *rs = recursiveLambda(g->getRightChild(), S, gs);
-        Node *s = S.mostRecentCommonAncestor(ls,rs);
-        pv[g->getNumber()] = s;
-        return s;
-    }
-}
-
-Node* LambdaMapEx::recursiveLambda(Node *g,const TreeExtended& S)
+// The gene tree is visited in postorder so the children of a node are
+// mapped before the node itself. Without gs the leaves keep their mapping.
+void LambdaMapEx::computeLambda(const TreeExtended &G, const TreeExtended &S,
+                                const StrStrMap *gs)
 {
-    if(g->isLeaf())
-    {
-        return pv[g->getNumber()];
-    }
-    else
+    const std::vector<unsigned> &order = G.postorder();
+    for (unsigned i = 0; i < order.size(); ++i)
     {
-        Node *ls = recursiveLambda(g->getLeftChild(), S);
-        Node *rs = recursiveLambda(g->getRightChild(), S);
-        Node *s = S.mostRecentCommonAncestor(ls,rs);
-        pv[g->getNumber()] = s;
-        return s;
-
+        Node *g = G.getNode(order[i]);
+        if (g->isLeaf())
+        {
+            if (gs)
+            {
+                compLeafLambda(g, S, *gs);
+            }
+        }
+        else
+        {
+            Node *ls = pv[g->getLeftChild()->getNumber()];
+            Node *rs = pv[g->getRightChild()->getNumber()];
+            pv[g->getNumber()] = S.getNode(S.lca(ls->getNumber(), rs->getNumber()));
+        }
     }
 }
 
@@ -41,7 +41,7 @@
 #include "../tree/Treeextended.h"
 #include "../utils/AnError.h"
 #include "../Parameters.h"
-#include "../reconcilation/BeepVector.h"
+#include "../tree/NodeMap.h"
 #include "../reconcilation/StrStrMap.h"
 
 #include "string.h"
@@ -52,7 +52,7 @@
 using namespace std;
 using boost::dynamic_bitset;
 
-class LambdaMapEx : public NodeVector
+class LambdaMapEx : public NodeMap<Node*>
 {
 
 public:
@@ -92,9 +92,9 @@ public:
 
 private:
 
-    //recursive function to calculate the gamma as described
-    Node* recursiveLambda(Node *g,const TreeExtended &S, const StrStrMap& gs);
-    Node* recursiveLambda(Node *g,const TreeExtended &S);
+    //calculates the lambda of the internal nodes of G from its leaves, the
+    //leaves are mapped first with gs if it is given
+    void computeLambda(const TreeExtended &G, const TreeExtended &S, const StrStrMap *gs);
     
     // return the speies node assigned to that gene node on the map
     Node* compLeafLambda(Node *g, const TreeExtended &S, const StrStrMap &gs);
@@ -23,6 +23,7 @@
 #include  "StrStrMap.h"
 #include <string.h>
 #include <set>
+#include <algorithm>
 #include <map>
 #include <iostream>
 #include "../utils/AnError.h"
@@ -31,8 +32,28 @@
 
 using namespace std;
 
+namespace
+{
+    // orders the ids of a NameTable as their names would be ordered as strings
+    struct NameOrder
+    {
+        explicit NameOrder(const NameTable &n) : names(n) {}
+        bool operator()(unsigned a, unsigned b) const
+        {
+            const size_t length_a = names.getLength(a);
+            const size_t length_b = names.getLength(b);
+            const int c = memcmp(names.getData(a), names.getData(b), min(length_a, length_b));
+            return c < 0 || (c == 0 && length_a < length_b);
+        }
+        const NameTable &names;
+    };
+}
+
 StrStrMap::StrStrMap() 
-    : avbildning()
+    : genes(),
+      species(),
+      avbildning(),
+      ordered()
 {
 }
 
@@ -41,7 +62,10 @@ StrStrMap::~StrStrMap()
 }
 
 StrStrMap::StrStrMap(const StrStrMap& sm)
-    : avbildning(sm.avbildning)
+    : genes(sm.genes),
+      species(sm.species),
+      avbildning(sm.avbildning),
+      ordered(sm.ordered)
 {    
 }
 
@@ -50,27 +74,37 @@ StrStrMap::operator=(const StrStrMap &sm)
 {
     if(&sm != this)
     {
+        genes = sm.genes;
+        species = sm.species;
         avbildning = sm.avbildning;
+        ordered = sm.ordered;
     }
     return *this;
 }
 
+// An existing relation is kept
 void
 StrStrMap::insert(const string &x, const string &y)
 {
-    avbildning.insert(pair<string,string>(x, y));
+    if(genes.intern(x) == avbildning.size())
+    {
+        avbildning.push_back(species.intern(y));
+        ordered.clear();
+    }
 }
 
 void
 StrStrMap::change(const string &x, const string &y)
 {
-    if(avbildning.find(x) != avbildning.end())
+    const unsigned id = genes.intern(x);
+    if(id == avbildning.size())
     {
-        avbildning[x] = y;
+        avbildning.push_back(species.intern(y));
+        ordered.clear();
     }
     else
     {
-        avbildning.insert(pair<string,string>(x, y));
+        avbildning[id] = species.intern(y);
     }
 }
 
@@ -78,41 +112,69 @@ StrStrMap::change(const string &x, const string &y)
 std::string
 StrStrMap::find(const string &s) const
 {
-    map<string, string>::const_iterator iter;
-    iter = avbildning.find(s);
-    if (iter == avbildning.end())
+    const unsigned id = findId(s);
+    if (id == NameTable::NO_NAME)
     {
         return "";
     }
     else
     {
-        return iter->second;
+        return species.getName(id);
+    }
+}
+
+unsigned
+StrStrMap::findId(const string &s) const
+{
+    const unsigned id = genes.find(s);
+    return id == NameTable::NO_NAME ? id : avbildning[id];
+}
+
+const NameTable&
+StrStrMap::getSpecies() const
+{
+    return species;
+}
+
+std::map<std::string, std::string>
+StrStrMap::getMapping() const
+{
+    std::map<std::string, std::string> mapping;
+    for(unsigned i = 0; i < avbildning.size(); i++)
+    {
+        mapping.insert(pair<string,string>(genes.getName(i), species.getName(avbildning[i])));
     }
+    return mapping;
 }
 
+// The items are ordered by name
 std::string
 StrStrMap::getNthItem(unsigned idx) const
 {
-    for (map<string,string>::const_iterator i = avbildning.begin();
-         i != avbildning.end(); i++)
+    if (idx >= avbildning.size())
     {
-        if (idx == 0)
-        {
-            return i->first;
-        }
-        else
+        return("");
+    }
+    if (ordered.size() != avbildning.size())
+    {
+        ordered.resize(avbildning.size());
+        for (unsigned i = 0; i < ordered.size(); i++)
         {
-            idx--;
+            ordered[i] = i;
         }
+        sort(ordered.begin(), ordered.end(), NameOrder(genes));
     }
-    return("");
+    return genes.getName(ordered[idx]);
 }
 
 // reset map
 void
 StrStrMap::clearMap()
 {
+    genes.clear();
+    species.clear();
     avbildning.clear();
+    ordered.clear();
 }
 
 // Diagnostics. Find how many relations are stored
@@ -126,11 +188,12 @@ unsigned
 StrStrMap::reverseSize() const
 {
     set<string> reverse;
-    for(map<string,string>::const_iterator i = avbildning.begin(); i != avbildning.end(); i++)
+    for(unsigned i = 0; i < avbildning.size(); i++)
     {
-        if(reverse.find(i->second) != reverse.end())
+        const string name = species.getName(avbildning[i]);
+        if(reverse.find(name) != reverse.end())
         {
-            reverse.insert(i->second);
+            reverse.insert(name);
         }
     }
     return reverse.size();
@@ -139,8 +202,9 @@ StrStrMap::reverseSize() const
 std::ostream& 
 operator<<(std::ostream &o, const StrStrMap &m)
 {
+    const map<string,string> mapping = m.getMapping();
     string res;
-    for (map<string,string>::const_iterator i = m.avbildning.begin(); i != m.avbildning.end();i++)
+    for (map<string,string>::const_iterator i = mapping.begin(); i != mapping.end();i++)
     {
         res.append(i->first + "\t" + i->second + "\n");
     }
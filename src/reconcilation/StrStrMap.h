@@ -24,8 +24,11 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include <stdexcept>
 
+#include "../utils/NameTable.h"
+
 using namespace std;
 
 class StrStrMap 
@@ -47,7 +50,15 @@ public:
     // The empty string is returned when not in map.
     virtual std::string find(const std::string &u) const ;
 
+    // Retrieval by id. The genes and the species are interned, findId()
+    // returns the id of the species u maps to (NameTable::NO_NAME when not
+    // in map), the same species always gets the same id.
+    unsigned findId(const std::string &u) const;
+    const NameTable& getSpecies() const;
+
     // Random access to a "left" item, use that to retrieve "right" item.
+    // The items are ordered by name, the order is sorted once and kept
+    // until a gene is added.
     std::string getNthItem(unsigned idx) const;
 
     // reset map
@@ -58,16 +69,16 @@ public:
     unsigned reverseSize() const;
 
     //! returns the mapping
-    std::map<std::string, std::string> getMapping() const
-    {
-        return avbildning;
-    }
+    std::map<std::string, std::string> getMapping() const;
 
     friend std::ostream& operator<<(std::ostream &o, const StrStrMap &);
 
 private:
 
-    std::map<std::string, std::string> avbildning;	// Stores the mapping
+    NameTable genes;
+    NameTable species;
+    std::vector<unsigned> avbildning;	// Stores the mapping, gene id to species id
+    mutable std::vector<unsigned> ordered; // gene ids sorted by name, see getNthItem()
 
 };
 
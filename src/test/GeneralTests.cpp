@@ -24,6 +24,21 @@
 #include "../Parameters.h"
 #include "../Mainops.h"
 #include "../utils/AnError.h"
+#include "../tree/TreeIO.h"
+#include "../tree/TreeStream.h"
+#include "../tree/TreeBuilder.h"
+#include "../tree/Treeextended.h"
+#include "../tree/Bipartitions.h"
+#include "../tree/CladeHash.h"
+#include "../tree/FrozenTree.h"
+#include "../reconcilation/GammaMapEx.h"
+#include "../reconcilation/LambdaMapEx.h"
+#include "../reconcilation/StrStrMap.h"
+#include "../lgt/Phyltr.h"
+#include "../lgt/ScenarioIO.h"
+#include "../lgt/ScenarioSet.h"
+#include "../lgt/Progress.h"
+#include "../utils/InputFile.h"
 
 #include <QTemporaryFile>
 #include <QFile>
@@ -31,6 +46,17 @@
 #include <QDebug>
 
 #include "unistd.h"
+#include <sys/stat.h>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <vector>
 
 // these must not go out of scope
 static Parameters *parameters = 0;
@@ -145,6 +171,1370 @@ void GeneralTests::initTestCase()
     QVERIFY2(run() == true,"Default parameters and reducing crossing lines");
 }
 
+// Gene trees far deeper than the call stack allows when walked recursively,
+// built in memory
+static TreeExtended* deepGeneTree(unsigned leaves, bool caterpillar)
+{
+    TreeExtended *tree = new TreeExtended();
+    tree->reserveNodes(2 * leaves - 1);
+    std::vector<Node*> level;
+    for (unsigned i = 0; i < leaves; i++)
+    {
+        std::ostringstream name;
+        name << "g" << i;
+        level.push_back(tree->addNode(0, 0, name.str()));
+    }
+    if (caterpillar)
+    {
+        Node *root = level[0];
+        for (unsigned i = 1; i < leaves; i++)
+        {
+            root = tree->addNode(root, level[i], "");
+        }
+        level.assign(1, root);
+    }
+    while (level.size() > 1)
+    {
+        std::vector<Node*> next;
+        for (unsigned i = 0; i + 1 < level.size(); i += 2)
+        {
+            next.push_back(tree->addNode(level[i], level[i + 1], ""));
+        }
+        if (level.size() % 2 == 1)
+        {
+            next.push_back(level.back());
+        }
+        level.swap(next);
+    }
+    tree->setRootNode(level[0]);
+    return tree;
+}
+
+// a tree of the given number of leaves joined in a pseudo random order, so
+// that it has deep and shallow parts
+static TreeExtended* randomTree(unsigned leaves, unsigned seed)
+{
+    TreeExtended *tree = new TreeExtended();
+    std::vector<Node*> pool;
+    for (unsigned i = 0; i < leaves; i++)
+    {
+        std::ostringstream name;
+        name << "r" << i;
+        pool.push_back(tree->addNode(0, 0, name.str()));
+    }
+    while (pool.size() > 1)
+    {
+        seed = seed * 1103515245u + 12345u;
+        const unsigned size = pool.size();
+        const unsigned i = (seed >> 8) % size;
+        // joining with the last node makes caterpillar like runs
+        unsigned j = (seed >> 4) % 3 == 0 ? i + 1 : size - 1;
+        if (j == i || j == size)
+        {
+            j = i == 0 ? 1 : i - 1;
+        }
+        Node *joined = tree->addNode(pool[i], pool[j], "");
+        pool[std::min(i, j)] = joined;
+        pool.erase(pool.begin() + std::max(i, j));
+    }
+    tree->setRootNode(pool[0]);
+    return tree;
+}
+
+// the lca by walking up from the deeper node, independent of the tables
+static Node* naiveLca(Node *u, Node *v)
+{
+    std::set<Node*> above;
+    for (Node *n = u; n != 0; n = n->getParent())
+    {
+        above.insert(n);
+    }
+    Node *n = v;
+    while (above.count(n) == 0)
+    {
+        n = n->getParent();
+    }
+    return n;
+}
+
+// rotates the children of every step-th internal node
+static void rotateNodes(TreeExtended &tree, unsigned step)
+{
+    for (unsigned i = 0; i < tree.getNumberOfNodes(); i += step)
+    {
+        if (!tree.getNode(i)->isLeaf())
+        {
+            tree.getNode(i)->rotate();
+        }
+    }
+}
+
+// follows the branches of the fpt search that lead to the events of sc: each
+// s-move is resolved the way the final scenario resolves it, so the
+// candidate is built by the incremental updates the search uses
+static Candidate searchPath(const Scenario &sc)
+{
+    const TreeExtended &G = *Phyltr::g_input.gene_tree;
+    Candidate c;
+    for (unsigned steps = 0; steps < 2 * G.getNumberOfNodes(); steps++)
+    {
+        const vid_t s_move = c.get_s_move();
+        if (s_move == Phyltr::NONE)
+        {
+            break;
+        }
+        if (sc.is_transfer_edge(G.left(s_move)) && !c.is_transfer_edge(G.left(s_move)))
+        {
+            c.set_transfer_edge(G.left(s_move));
+        }
+        else if (sc.is_transfer_edge(G.right(s_move)) && !c.is_transfer_edge(G.right(s_move)))
+        {
+            c.set_transfer_edge(G.right(s_move));
+        }
+        else
+        {
+            c.set_duplication(c.parent(s_move));
+        }
+    }
+    return c;
+}
+
+void GeneralTests::testDeepTrees()
+{
+    const unsigned leaves = 1000000;
+    TreeExtended species;
+    Node *s0 = species.addNode(0, 0, "s0");
+    Node *s1 = species.addNode(0, 0, "s1");
+    Node *s2 = species.addNode(0, 0, "s2");
+    species.setRootNode(species.addNode(species.addNode(s0, s1, ""), s2, ""));
+
+    StrStrMap gs;
+    for (unsigned i = 0; i < leaves; i++)
+    {
+        std::ostringstream gene, host;
+        gene << "g" << i;
+        host << "s" << i % 3;
+        gs.insert(gene.str(), host.str());
+    }
+
+    for (int caterpillar = 0; caterpillar < 2; caterpillar++)
+    {
+        TreeExtended *gene = deepGeneTree(leaves, caterpillar == 1);
+        Node *root = gene->getRootNode();
+        QCOMPARE(root->getNumberOfLeaves(), leaves);
+        QVERIFY(gene->IDnumbersAreSane(*root));
+        QVERIFY(gene->findMaximumDistanceToLeaf(root) >= 0);
+
+        LambdaMapEx lambda(*gene, species, gs);
+        QVERIFY(lambda[root] == species.getRootNode());
+        GammaMapEx gamma = GammaMapEx::MostParsimonious(*gene, species, lambda);
+        gamma.twistAndTurn(gene, &species);
+
+        TreeIO io;
+        QVERIFY(!io.writeGuestTree(*gene, &gamma).empty());
+
+        root->deleteSubtree();
+        QVERIFY(root->isLeaf());
+        delete gene;
+    }
+}
+
+void GeneralTests::testTraversals()
+{
+    TreeExtended *tree = randomTree(300, 9);
+    const unsigned n = tree->getNumberOfNodes();
+    for (int rotated = 0; rotated < 2; rotated++)
+    {
+        // the traversals by following the Node pointers
+        std::vector<unsigned> preorder;
+        std::vector<unsigned> postorder;
+        std::vector<std::pair<Node*, bool> > stack(1, std::make_pair(tree->getRootNode(), false));
+        while (!stack.empty())
+        {
+            Node *v = stack.back().first;
+            const bool children_done = stack.back().second;
+            stack.pop_back();
+            if (children_done || v->isLeaf())
+            {
+                if (v->isLeaf())
+                {
+                    preorder.push_back(v->getNumber());
+                }
+                postorder.push_back(v->getNumber());
+                continue;
+            }
+            preorder.push_back(v->getNumber());
+            stack.push_back(std::make_pair(v, true));
+            stack.push_back(std::make_pair(v->getRightChild(), false));
+            stack.push_back(std::make_pair(v->getLeftChild(), false));
+        }
+        QVERIFY(tree->preorder() == preorder);
+        QVERIFY(tree->postorder() == postorder);
+
+        unsigned i = 0;
+        for (Node *v = tree->preorder_begin(); v != 0; v = tree->preorder_next(v))
+        {
+            QCOMPARE(v->getNumber(), preorder[i++]);
+        }
+        QCOMPARE(i, n);
+        i = 0;
+        for (Node *v = tree->postorder_begin(); v != 0; v = tree->postorder_next(v))
+        {
+            QCOMPARE(v->getNumber(), postorder[i++]);
+        }
+        QCOMPARE(i, n);
+
+        for (unsigned v = 0; v < n; v++)
+        {
+            Node *node = tree->getNode(v);
+            QCOMPARE(tree->parent(v), node->getParent() ? node->getParent()->getNumber()
+                                                        : TreeExtended::NO_NODE);
+            QCOMPARE(tree->left(v), node->isLeaf() ? TreeExtended::NO_NODE
+                                                   : node->getLeftChild()->getNumber());
+        }
+        rotateNodes(*tree, 2);
+    }
+    delete tree;
+}
+
+void GeneralTests::testLeafSpans()
+{
+    // a caterpillar under construction, without a root, so the subtrees are
+    // added to the leaf order on demand, each one after the ones below it
+    const unsigned leaves = 200;
+    TreeExtended tree;
+    std::vector<Node*> inner;
+    Node *below = tree.addNode(0, 0, "l0");
+    for (unsigned i = 1; i < leaves; i++)
+    {
+        std::ostringstream name;
+        name << "l" << i;
+        below = tree.addNode(below, tree.addNode(0, 0, name.str()), "");
+        inner.push_back(below);
+    }
+
+    std::vector<NodeSpan> spans;
+    for (unsigned i = 0; i < inner.size(); i++)
+    {
+        spans.push_back(tree.getLeaves(*inner[i]));
+    }
+    // the spans handed out first are still valid after the later ones
+    for (unsigned i = 0; i < spans.size(); i++)
+    {
+        QCOMPARE(spans[i].size(), i + 2);
+        for (unsigned j = 0; j < spans[i].size(); j++)
+        {
+            std::ostringstream name;
+            name << "l" << j;
+            QCOMPARE(spans[i][j]->getName(), name.str());
+        }
+    }
+
+    // with the root set the whole tree is one order again
+    tree.setRootNode(below);
+    const NodeSpan all = tree.getLeaves(*below);
+    QCOMPARE(all.size(), leaves);
+    QVERIFY(tree.getLeaves(*inner[0]).begin() == all.begin());
+}
+
+void GeneralTests::testLCA()
+{
+    TreeExtended *trees[] = { randomTree(700, 1), randomTree(300, 7), deepGeneTree(200, true) };
+    for (unsigned t = 0; t < 3; t++)
+    {
+        TreeExtended &tree = *trees[t];
+        const unsigned n = tree.getNumberOfNodes();
+        for (int rotated = 0; rotated < 2; rotated++)
+        {
+            for (unsigned u = 0; u < n; u++)
+            {
+                for (unsigned k = 0; k < 8; k++)
+                {
+                    const unsigned v = (u * 37 + k * 101 + k * k) % n;
+                    Node *expected = naiveLca(tree.getNode(u), tree.getNode(v));
+                    QCOMPARE(tree.lca(u, v), expected->getNumber());
+                    QVERIFY(tree.lca(tree.getNode(v), tree.getNode(u)) == expected);
+                }
+            }
+            QCOMPARE(tree.lca(tree.root(), 0u), tree.root());
+            rotateNodes(tree, 3);
+        }
+        delete trees[t];
+    }
+}
+
+void GeneralTests::testBatchLCA()
+{
+    TreeExtended *tree = randomTree(500, 3);
+    const unsigned n = tree->getNumberOfNodes();
+    std::vector<std::pair<unsigned, unsigned> > queries;
+    std::vector<unsigned> answers;
+    tree->lca(queries, answers);
+    QVERIFY(answers.empty());
+
+    for (unsigned u = 0; u < n; u++)
+    {
+        queries.push_back(std::make_pair(u, u));
+        queries.push_back(std::make_pair(u, (u * 53 + 11) % n));
+        queries.push_back(std::make_pair((u * 29 + 5) % n, u));
+    }
+    for (int rotated = 0; rotated < 2; rotated++)
+    {
+        tree->lca(queries, answers);
+        QCOMPARE(answers.size(), queries.size());
+        for (unsigned i = 0; i < queries.size(); i++)
+        {
+            Node *expected = naiveLca(tree->getNode(queries[i].first), tree->getNode(queries[i].second));
+            QCOMPARE(answers[i], expected->getNumber());
+        }
+        rotateNodes(*tree, 2);
+    }
+    delete tree;
+}
+
+void GeneralTests::testDescendant()
+{
+    TreeExtended *tree = randomTree(200, 5);
+    const unsigned n = tree->getNumberOfNodes();
+    for (int rotated = 0; rotated < 2; rotated++)
+    {
+        const std::vector<unsigned> &preorder = tree->preorder();
+        QCOMPARE(unsigned(preorder.size()), n);
+        for (unsigned v = 0; v < n; v++)
+        {
+            // the members of the subtree of v, found by walking up from every node
+            std::vector<bool> below(n, false);
+            unsigned members = 0;
+            for (unsigned u = 0; u < n; u++)
+            {
+                Node *w = tree->getNode(u);
+                while (w != 0 && w->getNumber() != v)
+                {
+                    w = w->getParent();
+                }
+                below[u] = w != 0;
+                members += below[u] ? 1 : 0;
+                QCOMPARE(tree->descendant(u, v), below[u]);
+                QCOMPARE(tree->descendant(tree->getNode(u), tree->getNode(v)), below[u]);
+            }
+
+            // the interval of v holds exactly its subtree, v first
+            const unsigned entry = tree->dfs_entry(v);
+            const unsigned exit = tree->dfs_exit(v);
+            QVERIFY(entry <= exit && exit < n);
+            QCOMPARE(preorder[entry], v);
+            QCOMPARE(exit - entry + 1, members);
+            for (unsigned i = entry; i <= exit; i++)
+            {
+                QVERIFY(below[preorder[i]]);
+            }
+        }
+        rotateNodes(*tree, 2);
+    }
+    delete tree;
+}
+
+void GeneralTests::testFreeze()
+{
+    TreeExtended *tree = randomTree(50, 11);
+    Node *root = tree->getRootNode();
+    Node *left = root->getLeftChild();
+    Node *right = root->getRightChild();
+    const unsigned long version = tree->getTopologyVersion();
+
+    const FrozenTree view = tree->freeze();
+    QVERIFY(tree->isFrozen());
+    QCOMPARE(view.root(), root->getNumber());
+    QCOMPARE(view.lca(left->getNumber(), right->getNumber()), root->getNumber());
+
+    // the topology stays as it was after a refused change
+    QVERIFY_EXCEPTION_THROWN(root->setChildren(right, left), AnError);
+    QVERIFY_EXCEPTION_THROWN(root->rotate(), AnError);
+    QVERIFY(root->getLeftChild() == left && root->getRightChild() == right);
+    QCOMPARE(tree->getTopologyVersion(), version);
+    QCOMPARE(view.left(root->getNumber()), left->getNumber());
+
+    tree->thaw();
+    QVERIFY(!tree->isFrozen());
+    QVERIFY_EXCEPTION_THROWN(static_cast<void>(FrozenTree(*tree)), AnError);
+    root->setChildren(right, left);
+    QVERIFY(tree->getTopologyVersion() != version);
+    QCOMPARE(tree->left(root->getNumber()), right->getNumber());
+    delete tree;
+}
+
+void GeneralTests::testCloneTree()
+{
+    TreeExtended *gene = deepGeneTree(1000, false);
+    TreeExtended *copy = gene->clone();
+    TreeIO io;
+    const std::string original = io.writeBeepTree(*gene);
+    QCOMPARE(io.writeBeepTree(*copy), original);
+    QCOMPARE(copy->getNumberOfLeaves(), gene->getNumberOfLeaves());
+    for (unsigned i = 0; i < copy->getNumberOfNodes(); i++)
+    {
+        Node *n = copy->getNode(i);
+        QVERIFY(n != gene->getNode(i));
+        QVERIFY(n->getTree() == copy);
+        QCOMPARE(n->getName(), gene->getNode(i)->getName());
+    }
+
+    // reordering the copy leaves the original as it was
+    for (Node *n = copy->postorder_begin(); n != 0; n = copy->postorder_next(n))
+    {
+        if (!n->isLeaf())
+        {
+            n->rotate();
+        }
+    }
+    const Node *root = gene->getRootNode();
+    QCOMPARE(copy->getRootNode()->getLeftChild()->getNumber(), root->getRightChild()->getNumber());
+    QVERIFY(root->getLeftChild()->getTree() == gene);
+    QCOMPARE(io.writeBeepTree(*gene), original);
+    delete copy;
+    delete gene;
+
+    // a tree with room reserved but no nodes
+    TreeExtended reserved;
+    reserved.reserveNodes(10);
+    TreeExtended empty_copy(reserved);
+    QCOMPARE(empty_copy.getNumberOfNodes(), 0u);
+    QVERIFY(empty_copy.getRootNode() == 0);
+}
+
+void GeneralTests::testNodeArena()
+{
+    TreeIO io;
+    TreeExtended *source = randomTree(100, 3);
+    const std::string original = io.writeBeepTree(*source);
+    const unsigned n = source->getNumberOfNodes();
+
+    // a clone holds its nodes in one block and does not share them
+    TreeExtended *tree = source->clone();
+    std::set<const Node*> storage;
+    const Node *lowest = tree->getNode(0);
+    const Node *highest = tree->getNode(0);
+    for (unsigned i = 0; i < n; i++)
+    {
+        const Node *v = tree->getNode(i);
+        storage.insert(v);
+        lowest = std::min(lowest, v, std::less<const Node*>());
+        highest = std::max(highest, v, std::less<const Node*>());
+    }
+    QCOMPARE(static_cast<unsigned>(highest - lowest), n - 1);
+    source->clear();
+    QCOMPARE(source->getNumberOfNodes(), 0u);
+    QCOMPARE(io.writeBeepTree(*tree), original);
+
+    // the block of a cleared tree is reused by the next copy
+    *source = *tree;
+    tree->clear();
+    QVERIFY(tree->getRootNode() == 0);
+    *tree = *source;
+    QCOMPARE(io.writeBeepTree(*tree), original);
+    for (unsigned i = 0; i < n; i++)
+    {
+        QVERIFY(storage.count(tree->getNode(i)) == 1);
+        QVERIFY(tree->getNode(i)->getTree() == tree);
+    }
+
+    // and by the nodes added after clear()
+    tree->clear();
+    Node *a = tree->addNode(0, 0, "a");
+    Node *b = tree->addNode(0, 0, "b");
+    Node *root = tree->addNode(a, b, "");
+    tree->setRootNode(root);
+    QCOMPARE(tree->getNumberOfNodes(), 3u);
+    QVERIFY(storage.count(a) == 1 && storage.count(b) == 1 && storage.count(root) == 1);
+    QVERIFY(tree->findLeaf("b") == b);
+
+    // a copy that does not fit gets a new block
+    TreeExtended *larger = randomTree(300, 5);
+    *tree = *larger;
+    QCOMPARE(io.writeBeepTree(*tree), io.writeBeepTree(*larger));
+    QCOMPARE(tree->getNumberOfNodes(), larger->getNumberOfNodes());
+    QVERIFY(storage.count(tree->getRootNode()) == 0);
+
+    tree->clear();
+    TreeExtended *empty_clone = tree->clone();
+    QCOMPARE(empty_clone->getNumberOfNodes(), 0u);
+    QVERIFY(empty_clone->getRootNode() == 0);
+
+    delete empty_clone;
+    delete larger;
+    delete tree;
+    delete source;
+}
+
+void GeneralTests::testNodeMapCopy()
+{
+    TreeExtended *tree = randomTree(100, 13);
+    const unsigned n = tree->getNumberOfNodes();
+    NodeMap<double> times(n);
+    NodeMap<double> lengths(n);
+    NodeMap<double> rates(n, 1.0);
+    for (unsigned i = 0; i < n; i++)
+    {
+        times[i] = 0.25 * i;
+        lengths[i] = i + 1.0;
+        rates[i] += 0.01 * i;
+    }
+    tree->setTimes(times);
+    tree->setLengths(lengths);
+    tree->setRates(rates);
+
+    TreeExtended copy(*tree);
+    TreeExtended *clone = tree->clone();
+    const TreeExtended *copies[] = { &copy, clone };
+    for (unsigned c = 0; c < 2; c++)
+    {
+        const TreeExtended &t = *copies[c];
+        QVERIFY(t.getTimes() == times);
+        QVERIFY(t.getLengths() == lengths);
+        QVERIFY(t.getRates() == rates);
+        QVERIFY(t.hasLengths());
+        for (unsigned i = 0; i < n; i++)
+        {
+            // the values are found through the nodes of the copy
+            const Node *v = t.getNode(i);
+            QCOMPARE(t.getTime(*v), times[i]);
+            QCOMPARE(t.getLengths()[v], lengths[i]);
+            QCOMPARE(v->getLength(), lengths[i]);
+            QCOMPARE(t.getRate(*v), rates[i]);
+        }
+    }
+
+    // the copies have their own values
+    NodeMap<double> other(lengths);
+    other[0u] = -1.0;
+    copy.setLengths(other);
+    QCOMPARE(tree->getLength(*tree->getNode(0)), 1.0);
+    QCOMPARE(clone->getLength(*clone->getNode(0)), 1.0);
+    QCOMPARE(copy.getLength(*copy.getNode(0)), -1.0);
+    delete clone;
+    delete tree;
+}
+
+void GeneralTests::testBipartitions()
+{
+    TreeIO io = TreeIO::fromString("((a:1,b:1):1,(c:1,(d:1,e:1):1):1);\n"
+                                   "((a:1,c:1):1,(b:1,(d:1,e:1):1):1);\n"
+                                   "(((e:1,d:1):1,c:1):1,(b:1,a:1):1);");
+    std::vector<TreeExtended*> trees = io.readAllNewickTrees();
+    QCOMPARE(trees.size(), size_t(3));
+    QCOMPARE(trees.front()->getRootNode()->getLeftChild()->getLeftChild()->getName(), std::string("a"));
+
+    NameTable leaves;
+    Bipartitions first(*trees[0], leaves);
+    Bipartitions second(*trees[1], leaves);
+    Bipartitions third(*trees[2], leaves);
+    // unrooted, the two edges below the root give the same split
+    QCOMPARE(first.size(), 2u);
+    QCOMPARE(Bipartitions::robinsonFoulds(first, third), 0u);
+    QCOMPARE(Bipartitions::robinsonFoulds(first, second), 2u);
+    QVERIFY(first.contains(second[0], second.getWords()) != first.contains(second[1], second.getWords()));
+
+    BipartitionFrequencies frequencies(leaves, true);
+    for (unsigned i = 0; i < trees.size(); i++)
+    {
+        frequencies.add(*trees[i]);
+    }
+    QCOMPARE(frequencies.getTotalWeight(), 3ul);
+    const std::vector<BipartitionFrequencies::Entry> table = frequencies.getTable();
+    QCOMPARE(table.front().count, 3ul);
+    const std::vector<std::string> names = frequencies.getLeafNames(table.front().bits);
+    QCOMPARE(names.size(), size_t(2));
+    QCOMPARE(names[0] + names[1], std::string("de"));
+
+    for (unsigned i = 0; i < trees.size(); i++)
+    {
+        delete trees[i];
+    }
+}
+
+void GeneralTests::testNHXParser()
+{
+    const std::string input = "((a:0.1,b:0.30000000000000004)95:1e-3,'c d'[&&NHX:S=human:AC=(1 2)]);\n"
+                              "[a comment] (x[&&PRIME ID=0 ET=2],y[&&PRIME ID=1 ET=2])[&&PRIME ID=2 NAME=second];";
+    NHXParser parser(input.data(), input.data() + input.size());
+    NHXTree tree;
+    QVERIFY(parser.next(tree));
+    QCOMPARE(tree.size(), 5u);
+    const unsigned root = tree.getRoot();
+    QVERIFY(tree.isRoot(root));
+    const NHXNode &inner = tree[tree[root].left];
+    QCOMPARE(inner.name.str(), std::string("95"));
+    QCOMPARE(tree.findAnnotation(tree[root].left, "NW")->number, 1e-3);
+    QCOMPARE(tree.findAnnotation(inner.right, "NW")->number, 0.30000000000000004);
+    const unsigned leaf = tree[root].right;
+    QCOMPARE(tree[leaf].name.str(), std::string("c d"));
+    QCOMPARE(tree.speciesName(leaf)->str(), std::string("human"));
+    const NHXAnnotation *ac = tree.findAnnotation(leaf, "AC");
+    QCOMPARE(ac->size, 2u);
+    QCOMPARE(tree.getIntegers(*ac)[1], 2);
+
+    QVERIFY(parser.next(tree));
+    QCOMPARE(tree.findAnnotation(tree.getRoot(), "NAME")->text.str(), std::string("second"));
+    QCOMPARE(tree.findAnnotation(0, "ET")->type, NHXAnnotation::Float);
+    QVERIFY(!parser.next(tree));
+
+    const char *broken[] = { "(a,b", "(a,,b);", "(a,b)[&&PRIME ID=x];", "(a:,b);", "(a,b)[comment" };
+    for (unsigned i = 0; i < sizeof(broken) / sizeof(broken[0]); i++)
+    {
+        const std::string text = broken[i];
+        NHXParser p(text.data(), text.data() + text.size());
+        QVERIFY_EXCEPTION_THROWN(p.next(tree), AnError);
+    }
+
+    // the builder checks the tags of the trees it reads, numbering the
+    // nodes in postorder, and sets the lengths once the traits are known
+    const std::string tagged = "((a:1,b:1)[&&PRIME S=ab]:1,(c[&&PRIME S=x]:2,d:1):1);";
+    NHXParser tag_parser(tagged.data(), tagged.data() + tagged.size());
+    TreeBuilder builder;
+    QVERIFY(tag_parser.next(builder));
+    TreeIOTraits traits;
+    builder.getTags(traits);
+    QVERIFY(traits.hasNW());
+    QVERIFY(!traits.hasGS());
+    TreeExtended *built = builder.takeTree(traits);
+    QCOMPARE(built->getNode(2)->getName(), std::string("ab"));
+    QCOMPARE(built->getNode(3)->getName(), std::string("c"));
+    QCOMPARE(built->getNode(5)->getLength(), 1.0);
+    QVERIFY(builder.takeTree(traits) == 0);
+    delete built;
+
+    // no depth limit
+    const unsigned depth = 100000;
+    std::ostringstream deep;
+    deep << std::string(depth - 1, '(') << "g0:1";
+    for (unsigned i = 1; i < depth; i++)
+    {
+        deep << ",g" << i << ":1)" << (i + 1 < depth ? ":1" : ";");
+    }
+    TreeExtended *gene = TreeIO::fromString(deep.str()).readNewickTree();
+    QCOMPARE(gene->getNumberOfLeaves(), depth);
+    QCOMPARE(gene->getNode(depth - 1)->getLength(), 1.0);
+    delete gene;
+}
+
+void GeneralTests::testCladeHash()
+{
+    TreeIO io = TreeIO::fromString("((a:1,b:2):1,(c:1,(d:1,e:1):1):1);\n"
+                                   "((a:1,c:1):1,(b:1,(d:1,e:1):1):1);\n"
+                                   "((a:1,b:1):1,(c:1,(d:1,f:1):1):1);");
+    std::vector<TreeExtended*> trees = io.readAllNewickTrees();
+    QCOMPARE(trees.size(), size_t(3));
+    const CladeHash before(*trees[0]);
+
+    // rotating the children changes neither the clades nor the tree
+    TreeExtended rotated(*trees[0]);
+    for (unsigned i = 0; i < rotated.getNumberOfNodes(); i++)
+    {
+        if (!rotated.getNode(i)->isLeaf())
+        {
+            rotated.getNode(i)->rotate();
+        }
+    }
+    QVERIFY(rotated.getRootNode()->getLeftChild()->getLeftChild()->getName() != "a");
+    const CladeHash after(rotated);
+    QCOMPARE(after.getTreeHash(), before.getTreeHash());
+    for (unsigned i = 0; i < rotated.getNumberOfNodes(); i++)
+    {
+        QCOMPARE(after[i], before[i]);
+    }
+    QVERIFY(CladeHash::sameTopology(before, after));
+
+    // another topology or other leaves give other hashes
+    const CladeHash other_topology(*trees[1]);
+    const CladeHash other_leaves(*trees[2]);
+    QVERIFY(other_topology.getTreeHash() != before.getTreeHash());
+    QVERIFY(other_leaves.getTreeHash() != before.getTreeHash());
+    QVERIFY(!CladeHash::sameTopology(before, other_topology));
+    const unsigned root = trees[0]->getRootNode()->getNumber();
+    QVERIFY(!CladeHash::sameClade(before, root, other_leaves, trees[2]->getRootNode()->getNumber()));
+    // the clades (a,b) of the first and the third tree are the same
+    const unsigned ab = trees[0]->getRootNode()->getLeftChild()->getNumber();
+    QVERIFY(CladeHash::sameClade(before, ab, other_leaves, trees[2]->getRootNode()->getLeftChild()->getNumber()));
+    for (unsigned i = 0; i < trees.size(); i++)
+    {
+        delete trees[i];
+    }
+
+    // a sample is collapsed to its topologies weighted by the counts, which
+    // need not be whole numbers
+    QTemporaryFile temp_file_sample;
+    QString sample_file;
+    createTempFile(temp_file_sample, "3 ((a:1,b:1):1,(c:1,d:1):1);\n"
+                                     "((c:2,d:2):1,(b:1,a:1):1);\n"
+                                     "2 ((a:1,c:1):1,(b:1,d:1):1);\n"
+                                     "1.5 ((a:1,d:1):1,(b:1,c:1):1);\n"
+                                     "0.75 ((d:1,a:1):1,(c:1,b:1):1);\n", sample_file);
+    TreeStream stream(sample_file.toStdString());
+    TopologySet topologies;
+    QCOMPARE(topologies.insert(stream), 5ul);
+    QCOMPARE(topologies.size(), 3u);
+    QCOMPARE(topologies.getTotalWeight(), 8.25);
+    QCOMPARE(topologies[0].weight, 4.0);
+    QCOMPARE(topologies[1].weight, 2.0);
+    QCOMPARE(topologies[2].weight, 2.25);
+    QCOMPARE(topologies.getMostFrequent(), 0u);
+
+    // the set owns the trees, a repeated topology is deleted on insert
+    QCOMPARE(topologies.insert(TreeIO::fromString("((b,a),(c,d));").readNewickTree(), 0.5), 0u);
+    QCOMPARE(topologies.insert(TreeIO::fromString("((a,b),c);").readNewickTree(), 2.5), 3u);
+    QCOMPARE(topologies[0].weight, 4.5);
+    QCOMPARE(topologies.getMostFrequent(), 0u);
+    topologies.clear();
+    QCOMPARE(topologies.size(), 0u);
+    QVERIFY_EXCEPTION_THROWN(topologies.getMostFrequent(), AnError);
+
+    // the topologies compared by their rooted clades
+    TopologySet summary;
+    summary.insert(TreeIO::fromString("((a,b),(c,d));").readNewickTree(), 3.0);
+    summary.insert(TreeIO::fromString("(((b,a),c),d);").readNewickTree(), 1.0);
+    summary.insert(TreeIO::fromString("((a,c),(b,d));").readNewickTree(), 1.0);
+    const std::vector<unsigned> distances = summary.getDistances(0);
+    QCOMPARE(distances.size(), size_t(3));
+    QCOMPARE(distances[0], 0u);
+    QCOMPARE(distances[1], 2u);
+    QCOMPARE(distances[2], 4u);
+    QVERIFY(summary.getDistances(1) == std::vector<unsigned>({2u, 0u, 4u}));
+    std::vector<double> support = summary.getCladeSupport(0);
+    std::sort(support.begin(), support.end());
+    QCOMPARE(support.size(), size_t(2));
+    QCOMPARE(support[0], 0.6);
+    QCOMPARE(support[1], 0.8);
+    summary.insert(TreeIO::fromString("((a,b),c);").readNewickTree());
+    QVERIFY_EXCEPTION_THROWN(summary.getDistances(0), AnError);
+    QFile::remove(sample_file);
+}
+
+void GeneralTests::testStrStrMap()
+{
+    StrStrMap gs;
+    gs.insert("gene_b", "B");
+    gs.insert("gene_a", "A");
+    gs.insert("gene_c", "B");
+    QCOMPARE(gs.size(), 3u);
+    QCOMPARE(gs.findId("gene_b"), gs.findId("gene_c"));
+    QVERIFY(gs.findId("gene_a") != gs.findId("gene_b"));
+    QCOMPARE(gs.findId("gene_d"), NameTable::NO_NAME);
+    QCOMPARE(gs.find("gene_a"), std::string("A"));
+
+    // the items come in the order of the names, also after new ones
+    QCOMPARE(gs.getNthItem(0), std::string("gene_a"));
+    QCOMPARE(gs.getNthItem(2), std::string("gene_c"));
+    gs.insert("gene", "C");
+    gs.change("gene_a", "C");
+    QCOMPARE(gs.getNthItem(0), std::string("gene"));
+    QCOMPARE(gs.getNthItem(1), std::string("gene_a"));
+    QCOMPARE(gs.getNthItem(3), std::string("gene_c"));
+    QCOMPARE(gs.getNthItem(4), std::string(""));
+    QCOMPARE(gs.find("gene_a"), std::string("C"));
+
+    const StrStrMap copy(gs);
+    gs.clearMap();
+    QCOMPARE(gs.getNthItem(0), std::string(""));
+    QCOMPARE(copy.getNthItem(2), std::string("gene_b"));
+}
+
+void GeneralTests::testTreeStream()
+{
+    // a count column in front of some of the trees, as in Examples/cyano.trees
+    std::ostringstream sampled;
+    const unsigned trees = TreeStream::CHECKPOINT_TREES + 10;
+    for (unsigned i = 0; i < trees; i++)
+    {
+        if (i % 2 == 0)
+        {
+            sampled << "   " << i + 1 << " ";
+        }
+        sampled << "((a:1,b:" << i + 1 << "):1,c:1);\n";
+    }
+    QTemporaryFile temp_file_trees;
+    QString trees_file;
+    createTempFile(temp_file_trees, sampled.str(), trees_file);
+
+    TreeStream stream(trees_file.toStdString());
+    TreeExtended *tree = stream.next();
+    QVERIFY(tree != 0);
+    QCOMPARE(stream.getWeight(), 1.0);
+    QCOMPARE(tree->getNode(1)->getLength(), 1.0);
+    delete tree;
+    QCOMPARE(stream.skip(trees), static_cast<unsigned long>(trees - 1));
+    QVERIFY(stream.next() == 0);
+
+    // back over a checkpoint and forward again
+    QVERIFY(stream.seek(trees - 2));
+    tree = stream.next();
+    QCOMPARE(stream.getWeight(), double(trees - 1));
+    QCOMPARE(tree->getNode(1)->getLength(), double(trees - 1));
+    delete tree;
+    QVERIFY(stream.seek(3));
+    tree = stream.next();
+    QCOMPARE(stream.getWeight(), 1.0);
+    QCOMPARE(tree->getNode(1)->getLength(), 4.0);
+    delete tree;
+    QCOMPARE(stream.getIndex(), 4ul);
+    QVERIFY(!stream.seek(trees + 1));
+    stream.rewind();
+    QCOMPARE(stream.getIndex(), 0ul);
+    QFile::remove(trees_file);
+}
+
+void GeneralTests::testInputFile()
+{
+    // a regular file is mapped as it is
+    const std::string text = "gene1 species1\n  gene2\tspecies2\n";
+    QTemporaryFile temp_file_text;
+    QString text_file;
+    createTempFile(temp_file_text, text, text_file);
+    {
+        InputFile mapped(text_file.toStdString());
+        QVERIFY(mapped.isMapped());
+        QCOMPARE(mapped.size(), text.size());
+        QVERIFY(std::string(mapped.begin(), mapped.end()) == text);
+        const char *position = mapped.begin();
+        const char *word = 0;
+        size_t length = 0;
+        QVERIFY(InputFile::nextWord(position, mapped.end(), word, length));
+        QVERIFY(std::string(word, length) == "gene1");
+        InputFile::skipLine(position, mapped.end());
+        QVERIFY(InputFile::nextWord(position, mapped.end(), word, length));
+        QVERIFY(std::string(word, length) == "gene2");
+    }
+
+    // an empty file can not be mapped and is read instead
+    QTemporaryFile temp_file_empty;
+    QString empty_file;
+    createTempFile(temp_file_empty, "", empty_file);
+    {
+        InputFile empty(empty_file.toStdString());
+        QVERIFY(!empty.isMapped());
+        QCOMPARE(empty.size(), size_t(0));
+        QVERIFY(empty.begin() == empty.end());
+    }
+
+    // a pipe has no size, it is read to the end in a growing buffer
+    const std::string fifo = text_file.toStdString() + ".fifo";
+    QCOMPARE(mkfifo(fifo.c_str(), 0600), 0);
+    std::string piped;
+    while (piped.size() < 200000)
+    {
+        piped += text;
+    }
+    std::thread writer([&]()
+    {
+        std::ofstream out(fifo.c_str(), std::ios::binary);
+        out << piped;
+    });
+    {
+        InputFile pipe(fifo);
+        writer.join();
+        QVERIFY(!pipe.isMapped());
+        QCOMPARE(pipe.size(), piped.size());
+        QVERIFY(std::string(pipe.begin(), pipe.end()) == piped);
+    }
+
+    QVERIFY_EXCEPTION_THROWN(InputFile(fifo + ".missing"), AnError);
+    std::remove(fifo.c_str());
+    QFile::remove(empty_file);
+    QFile::remove(text_file);
+}
+
+void GeneralTests::testScenario()
+{
+    TreeExtended *species = TreeIO::fromString("((a,b),(c,d));").readNewickTree();
+    TreeExtended *gene = TreeIO::fromString("(((a1,c1),b1),((d1,c2),(a2,b2)));").readNewickTree();
+    StrStrMap gs;
+    gs.insert("a1", "a");
+    gs.insert("a2", "a");
+    gs.insert("b1", "b");
+    gs.insert("b2", "b");
+    gs.insert("c1", "c");
+    gs.insert("c2", "c");
+    gs.insert("d1", "d");
+    ProgramInput &input = Phyltr::g_input;
+    const ProgramInput saved = input;
+    input.gene_tree = gene;
+    input.species_tree = species;
+    input.duplication_cost = 1.0;
+    input.transfer_cost = 1.5;
+    input.min_cost = 0.0;
+    input.max_cost = 8.0;
+    input.print_only_minimal_loss_scenarios = false;
+    input.print_only_minimal_transfer_scenarios = false;
+    const unsigned nodes = gene->getNumberOfNodes();
+
+    // the events are kept sorted and once whatever the order they are set
+    Scenario sparse(nodes);
+    sparse.set_transfer_edge(7);
+    sparse.set_transfer_edge(2);
+    sparse.set_transfer_edge(7);
+    sparse.set_duplication(9);
+    sparse.set_duplication(0);
+    QCOMPARE(sparse.transfer_edges.size(), size_t(2));
+    QCOMPARE(sparse.transfer_edges[0], vid_t(2));
+    QCOMPARE(sparse.duplications[1], vid_t(9));
+    QVERIFY(sparse.is_transfer_edge(7) && !sparse.is_transfer_edge(9));
+    QVERIFY(sparse.is_duplication(0) && !sparse.is_duplication(2));
+    const dynamic_bitset<> transfers = sparse.getTransferEdges();
+    QCOMPARE(transfers.size(), size_t(nodes));
+    QCOMPARE(transfers.count(), size_t(2));
+    QVERIFY(transfers.test(2) && transfers.test(7));
+
+    Scenario other(nodes);
+    other.set_transfer_edge(4);
+    other.set_duplication(9);
+    Scenario merged(nodes);
+    merged.merge(sparse, other);
+    QCOMPARE(merged.transfer_edges.size(), size_t(3));
+    QCOMPARE(merged.transfer_edges[1], vid_t(4));
+    QCOMPARE(merged.duplications.size(), size_t(2));
+    QCOMPARE(merged.cost, 2 * 1.0 + 3 * 1.5);
+
+    // every scenario found comes back from its Candidate unchanged, and the
+    // rebuilt Candidate is the one the search built for it
+    Phyltr late;
+    late.read_sigma(gs);
+    late.fpt_algorithm();
+    QVERIFY(!late.scenarios.empty());
+    for (unsigned i = 0; i < late.scenarios.size(); i++)
+    {
+        const Scenario &sc = late.scenarios[i];
+        Candidate c = sc.reconstruct();
+        QCOMPARE(c.cost(), sc.cost);
+        QVERIFY(c.is_elegant());
+        QVERIFY(c.getDuplications() == sc.getDuplications());
+        QVERIFY(c.getTransferEdges() == sc.getTransferEdges());
+        QCOMPARE(c.get_s_move(), Phyltr::NONE);
+
+        Candidate searched = searchPath(sc);
+        QCOMPARE(searched.get_s_move(), Phyltr::NONE);
+        QCOMPARE(searched.cost(), c.cost());
+        QVERIFY(searched.getDuplications() == c.getDuplications());
+        QVERIFY(searched.getTransferEdges() == c.getTransferEdges());
+        QVERIFY(searched.getLambda() == c.getLambda());
+        for (vid_t u = 0; u < nodes; u++)
+        {
+            QCOMPARE(c.parent(u), searched.parent(u));
+            QCOMPARE(c.left(u), searched.left(u));
+            QCOMPARE(c.right(u), searched.right(u));
+        }
+        QCOMPARE(count_losses(*species, *gene, input.sigma, c.getTransferEdges()),
+                 count_losses(*species, *gene, input.sigma, searched.getTransferEdges()));
+        const Scenario back(c, nodes);
+        QVERIFY(back.duplications == sc.duplications);
+        QVERIFY(back.transfer_edges == sc.transfer_edges);
+        QCOMPARE(back.cost, sc.cost);
+    }
+
+    input = saved;
+    delete gene;
+    delete species;
+}
+
+void GeneralTests::testScenarioIO()
+{
+    TreeExtended *species = TreeIO::fromString("((a,b),(c,d));").readNewickTree();
+    TreeExtended *gene = TreeIO::fromString("(((a1,c1),b1),(d1,(a2,b2)));").readNewickTree();
+    ProgramInput &input = Phyltr::g_input;
+    TreeExtended *saved_gene = input.gene_tree;
+    TreeExtended *saved_species = input.species_tree;
+    input.gene_tree = gene;
+    input.species_tree = species;
+    const unsigned nodes = gene->getNumberOfNodes();
+
+    // enough records for several blocks, the costs are not exact in binary
+    QTemporaryFile temp_file_scenarios;
+    QString scenarios_file;
+    createTempFile(temp_file_scenarios, "", scenarios_file);
+    const unsigned records = 20000;
+    std::vector<Scenario> written;
+    {
+        ScenarioWriter writer(scenarios_file.toStdString());
+        for (unsigned i = 0; i < records; i++)
+        {
+            Scenario sc(nodes);
+            for (unsigned u = 1; u < nodes; u++)
+            {
+                if ((i >> (u % 8)) & 1)
+                {
+                    sc.set_transfer_edge(u);
+                }
+                else if (u % 3 == i % 3)
+                {
+                    sc.set_duplication(u);
+                }
+            }
+            sc.cost = 0.1 * i + 1.0 / 3.0;
+            writer.write(sc, i % 7);
+            written.push_back(sc);
+        }
+        writer.close();
+        QCOMPARE(writer.size(), static_cast<unsigned long>(records));
+    }
+
+    ScenarioReader reader(scenarios_file.toStdString());
+    reader.checkTrees(*gene, *species);
+    Scenario sc(nodes);
+    unsigned losses = 0;
+    unsigned read = 0;
+    while (reader.next(sc, losses))
+    {
+        QVERIFY(read < records);
+        QCOMPARE(sc.cost, written[read].cost);
+        QCOMPARE(losses, read % 7);
+        QVERIFY(sc.transfer_edges == written[read].transfer_edges);
+        QVERIFY(sc.duplications == written[read].duplications);
+        read++;
+    }
+    QCOMPARE(read, records);
+    QVERIFY(!reader.next(sc, losses));
+    QVERIFY_EXCEPTION_THROWN(reader.checkTrees(*species, *species), AnError);
+
+    // the sizes in the first block frame follow the 64 byte header
+    std::ifstream original(scenarios_file.toStdString().c_str(), std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(original)),
+                            std::istreambuf_iterator<char>());
+    original.close();
+    const size_t frame = 64;
+    const char *sizes[][2] = {
+        {"\x00\x00\x00\x00", "\x00\x00\x00\x00"},  // no compressed data
+        {"\xff\xff\xff\x7f", "\x10\x00\x00\x00"},  // raw size too large
+        {"\x00\x00\x01\x00", "\xff\xff\x00\x00"},  // past the end of the file
+    };
+    for (unsigned i = 0; i < 3; i++)
+    {
+        std::string corrupted(bytes);
+        corrupted.replace(frame + 4, 4, sizes[i][0], 4);
+        corrupted.replace(frame + 8, 4, sizes[i][1], 4);
+        if (i == 2)
+        {
+            corrupted.resize(frame + 12 + 16);
+        }
+        std::ofstream(scenarios_file.toStdString().c_str(), std::ios::binary | std::ios::trunc)
+                << corrupted;
+        ScenarioReader broken(scenarios_file.toStdString());
+        QVERIFY_EXCEPTION_THROWN(broken.next(sc, losses), AnError);
+    }
+
+    // event lists that are not strictly increasing, a repeated id and an id
+    // whose delta wraps around
+    for (unsigned i = 0; i < 2; i++)
+    {
+        Scenario bad(nodes);
+        bad.transfer_edges.push_back(5);
+        bad.transfer_edges.push_back(i == 0 ? 5 : 2);
+        {
+            ScenarioWriter writer(scenarios_file.toStdString());
+            writer.write(bad, 0);
+        }
+        ScenarioReader broken(scenarios_file.toStdString());
+        QVERIFY_EXCEPTION_THROWN(broken.next(sc, losses), AnError);
+    }
+
+    QFile::remove(scenarios_file);
+    input.gene_tree = saved_gene;
+    input.species_tree = saved_species;
+    delete gene;
+    delete species;
+}
+
+void GeneralTests::testUniqueScenarios()
+{
+    TreeExtended *species = TreeIO::fromString("((((a,b),c),(d,e)),(f,(g,h)));").readNewickTree();
+    TreeExtended *gene = TreeIO::fromString(
+                "((((a1,f1),(c1,b1)),((d1,h1),e1)),((f2,a2),(g1,(h2,b2))));").readNewickTree();
+    TreeExtended *other = TreeIO::fromString(
+                "((((a1,f1),(c1,b1)),((d1,e1),h1)),((f2,a2),(g1,(h2,b2))));").readNewickTree();
+    StrStrMap gs;
+    const char *leaves[][2] = {
+        {"a1", "a"}, {"a2", "a"}, {"b1", "b"}, {"b2", "b"}, {"c1", "c"}, {"d1", "d"},
+        {"e1", "e"}, {"f1", "f"}, {"f2", "f"}, {"g1", "g"}, {"h1", "h"}, {"h2", "h"}
+    };
+    for (unsigned i = 0; i < sizeof(leaves) / sizeof(leaves[0]); i++)
+    {
+        gs.insert(leaves[i][0], leaves[i][1]);
+    }
+
+    ProgramInput &input = Phyltr::g_input;
+    const ProgramInput saved = input;
+    input.gene_tree = gene;
+    input.species_tree = species;
+    input.duplication_cost = 1.0;
+    input.min_cost = 0.0;
+    input.max_cost = 6.0;
+    input.print_only_minimal_loss_scenarios = false;
+    input.print_only_minimal_transfer_scenarios = false;
+
+    ScenarioSet unique;
+    QVERIFY(unique.setTrees(*gene, *species));
+    QVERIFY(!unique.setTrees(*gene, *species));
+
+    // a cancelled run adds nothing
+    Progress progress;
+    progress.cancel();
+    Phyltr cancelled;
+    cancelled.set_progress(&progress);
+    cancelled.set_unique_scenarios(&unique);
+    cancelled.read_sigma(gs);
+    input.transfer_cost = 1.5;
+    QVERIFY_EXCEPTION_THROWN(cancelled.fpt_algorithm(), Progress::Cancelled);
+    QVERIFY(unique.empty());
+    cancelled.fpt_anytime(0.0, 0, 0.0);
+    QVERIFY(cancelled.scenarios.empty());
+    QVERIFY(unique.empty());
+
+    Phyltr first;
+    first.set_unique_scenarios(&unique);
+    first.read_sigma(gs);
+    first.fpt_algorithm();
+    // Phyltr::scenarios is shared by all the instances
+    const std::vector<Scenario> first_scenarios = first.scenarios;
+    QVERIFY(!first_scenarios.empty());
+    QCOMPARE(unique.size(), first_scenarios.size());
+
+    // the second run adds the scenarios that only its costs allow
+    input.transfer_cost = 1.0;
+    input.max_cost = 8.0;
+    Phyltr second;
+    second.set_unique_scenarios(&unique);
+    second.read_sigma(gs);
+    second.fpt_anytime(0.0, 0, 0.0);
+    ScenarioSet merged;
+    merged.insert(first_scenarios);
+    merged.insert(second.scenarios);
+    QVERIFY(merged.size() > first_scenarios.size());
+    QCOMPARE(unique.size(), merged.size());
+    for (unsigned i = 0; i < second.scenarios.size(); i++)
+    {
+        QVERIFY(unique.contains(second.scenarios[i]));
+    }
+
+    // other trees start a new set
+    QVERIFY(!unique.setTrees(*gene, *species));
+    QCOMPARE(unique.size(), merged.size());
+    QVERIFY(unique.setTrees(*other, *species));
+    QVERIFY(unique.empty());
+
+    input = saved;
+    delete other;
+    delete gene;
+    delete species;
+}
+
+void GeneralTests::testAnytimeLayers()
+{
+    TreeExtended *species = TreeIO::fromString("((((a,b),c),(d,e)),(f,(g,h)));").readNewickTree();
+    TreeExtended *gene = TreeIO::fromString(
+                "((((a1,f1),(c1,b1)),((d1,h1),e1)),((f2,a2),(g1,(h2,b2))));").readNewickTree();
+    StrStrMap gs;
+    const char *leaves[][2] = {
+        {"a1", "a"}, {"a2", "a"}, {"b1", "b"}, {"b2", "b"}, {"c1", "c"}, {"d1", "d"},
+        {"e1", "e"}, {"f1", "f"}, {"f2", "f"}, {"g1", "g"}, {"h1", "h"}, {"h2", "h"}
+    };
+    for (unsigned i = 0; i < sizeof(leaves) / sizeof(leaves[0]); i++)
+    {
+        gs.insert(leaves[i][0], leaves[i][1]);
+    }
+
+    ProgramInput &input = Phyltr::g_input;
+    const ProgramInput saved = input;
+    input.gene_tree = gene;
+    input.species_tree = species;
+    input.duplication_cost = 1.0;
+    input.transfer_cost = 1.5;
+    input.min_cost = 0.0;
+    input.max_cost = 8.0;
+    input.print_only_minimal_loss_scenarios = false;
+    input.print_only_minimal_transfer_scenarios = false;
+
+    Phyltr late;
+    late.read_sigma(gs);
+    late.fpt_algorithm();
+    // Phyltr::scenarios is shared by all the instances
+    const std::vector<Scenario> all = late.scenarios;
+    QVERIFY(!all.empty());
+
+    // the bounds only go up, every layer holds the scenarios between the
+    // previous bound and its own, and together they are the whole search
+    std::vector<double> bounds;
+    std::vector<std::vector<Scenario> > layers;
+    late.fpt_anytime(0.0, 0, 0.0,
+                     [&](double bound, const std::vector<Scenario> &layer)
+    {
+        bounds.push_back(bound);
+        layers.push_back(layer);
+    });
+    QVERIFY(layers.size() > 1);
+    QCOMPARE(bounds.back(), input.max_cost);
+    double previous = -1.0;
+    size_t total = 0;
+    for (unsigned i = 0; i < layers.size(); i++)
+    {
+        QVERIFY(bounds[i] > previous);
+        for (unsigned j = 0; j < layers[i].size(); j++)
+        {
+            QVERIFY(layers[i][j].cost > previous);
+            QVERIFY(layers[i][j].cost <= bounds[i] + 1e-6);
+        }
+        previous = bounds[i];
+        total += layers[i].size();
+    }
+    QCOMPARE(total, all.size());
+    QCOMPARE(late.scenarios.size(), all.size());
+    ScenarioSet anytime;
+    anytime.insert(late.scenarios);
+    QCOMPARE(anytime.size(), all.size());
+    for (unsigned i = 0; i < all.size(); i++)
+    {
+        QVERIFY(anytime.contains(all[i]));
+    }
+
+    // with free events there is a single layer, it stops quietly when
+    // the run is cancelled
+    input.duplication_cost = 0.0;
+    input.transfer_cost = 0.0;
+    input.max_cost = 0.0;
+    late.fpt_algorithm();
+    const std::vector<Scenario> free_events = late.scenarios;
+    QVERIFY(!free_events.empty());
+    bounds.clear();
+    layers.clear();
+    late.fpt_anytime(0.0, 0, 0.0,
+                     [&](double bound, const std::vector<Scenario> &layer)
+    {
+        bounds.push_back(bound);
+        layers.push_back(layer);
+    });
+    QCOMPARE(layers.size(), size_t(1));
+    QCOMPARE(bounds[0], 0.0);
+    QCOMPARE(layers[0].size(), free_events.size());
+    QCOMPARE(late.scenarios.size(), free_events.size());
+
+    Progress progress;
+    progress.cancel();
+    late.set_progress(&progress);
+    layers.clear();
+    late.fpt_anytime(0.0, 0, 0.0,
+                     [&](double bound, const std::vector<Scenario> &layer)
+    {
+        bounds.push_back(bound);
+        layers.push_back(layer);
+    });
+    QVERIFY(layers.empty());
+    QVERIFY(late.scenarios.empty());
+
+    input = saved;
+    delete gene;
+    delete species;
+}
+
+void GeneralTests::testProgress()
+{
+    // poll() throws once the token is cancelled, or once the time limit
+    // has passed, and stays cancelled
+    Progress token;
+    token.poll(1000);
+    QVERIFY(!token.isCancelled());
+    token.cancel();
+    QVERIFY(token.isCancelled());
+    QVERIFY_EXCEPTION_THROWN(token.poll(), Progress::Cancelled);
+
+    Progress timed;
+    timed.setTimeLimit(0.001);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    QVERIFY_EXCEPTION_THROWN(timed.poll(256), Progress::Cancelled);
+    QVERIFY(timed.isCancelled());
+    QVERIFY_EXCEPTION_THROWN(timed.poll(), Progress::Cancelled);
+
+    TreeExtended *species = TreeIO::fromString("((((a,b),c),(d,e)),(f,(g,h)));").readNewickTree();
+    TreeExtended *gene = TreeIO::fromString(
+                "((((a1,f1),(c1,b1)),((d1,h1),e1)),((f2,a2),(g1,(h2,b2))));").readNewickTree();
+    StrStrMap gs;
+    const char *leaves[][2] = {
+        {"a1", "a"}, {"a2", "a"}, {"b1", "b"}, {"b2", "b"}, {"c1", "c"}, {"d1", "d"},
+        {"e1", "e"}, {"f1", "f"}, {"f2", "f"}, {"g1", "g"}, {"h1", "h"}, {"h2", "h"}
+    };
+    for (unsigned i = 0; i < sizeof(leaves) / sizeof(leaves[0]); i++)
+    {
+        gs.insert(leaves[i][0], leaves[i][1]);
+    }
+
+    ProgramInput &input = Phyltr::g_input;
+    const ProgramInput saved = input;
+    input.gene_tree = gene;
+    input.species_tree = species;
+    input.duplication_cost = 1.0;
+    input.transfer_cost = 1.5;
+    input.min_cost = 0.0;
+    input.max_cost = 8.0;
+    input.print_only_minimal_loss_scenarios = false;
+    input.print_only_minimal_transfer_scenarios = false;
+
+    // Phyltr::scenarios is shared by all the instances
+    Phyltr reference;
+    reference.read_sigma(gs);
+    reference.fpt_algorithm();
+    const std::vector<Scenario> fpt_scenarios = reference.scenarios;
+    reference.dp_algorithm();
+    reference.backtrack();
+    const std::vector<Scenario> dp_scenarios = reference.scenarios;
+    QVERIFY(!fpt_scenarios.empty() && !dp_scenarios.empty());
+
+    // an observer that cancels stops the dp part way through its rows
+    Phyltr late;
+    late.read_sigma(gs);
+    Progress observed;
+    unsigned reports = 0;
+    observed.setObserver([&](const Progress &)
+    {
+        reports++;
+        observed.cancel();
+    }, 0);
+    late.set_progress(&observed);
+    QVERIFY_EXCEPTION_THROWN(late.dp_algorithm(), Progress::Cancelled);
+    QCOMPARE(reports, 1u);
+    QCOMPARE(std::string(observed.getStage()), std::string("dp"));
+    QVERIFY(observed.getCellsDone() < observed.getCellsTotal());
+
+    // an expired token stops the backtrack and the fpt search
+    late.set_progress(0);
+    late.dp_algorithm();
+    Progress expired;
+    expired.setTimeLimit(0.001);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    late.set_progress(&expired);
+    QVERIFY_EXCEPTION_THROWN(late.backtrack(), Progress::Cancelled);
+    QVERIFY_EXCEPTION_THROWN(late.fpt_algorithm(), Progress::Cancelled);
+
+    // and the instance gives the same results as a clean one afterwards
+    Progress fresh;
+    late.set_progress(&fresh);
+    late.fpt_algorithm();
+    QCOMPARE(late.scenarios.size(), fpt_scenarios.size());
+    QCOMPARE(fresh.getScenariosFound(), static_cast<unsigned long>(fpt_scenarios.size()));
+    for (unsigned i = 0; i < fpt_scenarios.size(); i++)
+    {
+        QVERIFY(late.scenarios[i].duplications == fpt_scenarios[i].duplications);
+        QVERIFY(late.scenarios[i].transfer_edges == fpt_scenarios[i].transfer_edges);
+    }
+    late.dp_algorithm();
+    late.backtrack();
+    QCOMPARE(late.scenarios.size(), dp_scenarios.size());
+    for (unsigned i = 0; i < dp_scenarios.size(); i++)
+    {
+        QVERIFY(late.scenarios[i].duplications == dp_scenarios[i].duplications);
+        QVERIFY(late.scenarios[i].transfer_edges == dp_scenarios[i].transfer_edges);
+    }
+    QVERIFY(!fresh.isCancelled());
+
+    input = saved;
+    delete gene;
+    delete species;
+}
+
 void GeneralTests::createTempFile(QTemporaryFile &temp_file, const std::string &input, QString &output)
 {
     temp_file.setAutoRemove(false);
@@ -63,6 +63,27 @@ private:
 private slots:
 
     void initTestCase();
+    void testDeepTrees();
+    void testTraversals();
+    void testLeafSpans();
+    void testLCA();
+    void testBatchLCA();
+    void testDescendant();
+    void testFreeze();
+    void testCloneTree();
+    void testNodeArena();
+    void testNodeMapCopy();
+    void testBipartitions();
+    void testNHXParser();
+    void testStrStrMap();
+    void testCladeHash();
+    void testTreeStream();
+    void testInputFile();
+    void testScenario();
+    void testScenarioIO();
+    void testUniqueScenarios();
+    void testAnytimeLayers();
+    void testProgress();
     void cleanupTestCase();
 
 };
@@ -0,0 +1,424 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+#include "Bipartitions.h"
+
+#include <algorithm>
+
+#include "Treeextended.h"
+#include "Node.h"
+#include "HashMix.h"
+#include "../utils/AnError.h"
+
+static unsigned popcount(uint64_t v)
+{
+#ifdef __GNUC__
+    return __builtin_popcountll(v);
+#else
+    unsigned c = 0;
+    while (v != 0)
+    {
+        v &= v - 1;
+        ++c;
+    }
+    return c;
+#endif
+}
+
+namespace
+{
+    // orders the rows of a flat array of bitsets
+    struct RowLess
+    {
+        RowLess(const std::vector<uint64_t> &r, unsigned w) : rows(r), words(w) {}
+        bool operator()(unsigned a, unsigned b) const
+        {
+            return Bipartitions::compare(&rows[a * words], words, &rows[b * words], words) < 0;
+        }
+        const std::vector<uint64_t> &rows;
+        unsigned words;
+    };
+}
+
+Bipartitions::Bipartitions(const TreeExtended &tree, NameTable &names, bool r)
+    : words(0),
+      rooted(r),
+      leaves(),
+      bits()
+{
+    const std::vector<unsigned> &order = tree.postorder();
+    std::vector<unsigned> leaf_id(tree.getNumberOfNodes(), NameTable::NO_NAME);
+    for (unsigned i = 0; i < order.size(); ++i)
+    {
+        if (tree.is_leaf(order[i]))
+        {
+            leaf_id[order[i]] = names.intern(tree.getNode(order[i])->getName());
+        }
+    }
+
+    words = (names.size() + 63) / 64;
+    leaves.assign(words, 0);
+    unsigned nleaves = 0;
+    for (unsigned v = 0; v < leaf_id.size(); ++v)
+    {
+        const unsigned id = leaf_id[v];
+        if (id == NameTable::NO_NAME)
+        {
+            continue;
+        }
+        const uint64_t bit = uint64_t(1) << (id % 64);
+        if (leaves[id / 64] & bit)
+        {
+            throw AnError("Two leaves of the tree have the same name ",
+                          names.getName(id), 1);
+        }
+        leaves[id / 64] |= bit;
+        ++nleaves;
+    }
+
+    // the first word with a leaf holds the leaf with the smallest bit
+    unsigned first_word = 0;
+    while (first_word < words && leaves[first_word] == 0)
+    {
+        ++first_word;
+    }
+    const uint64_t first_bit = first_word < words ? leaves[first_word] & (~leaves[first_word] + 1) : 0;
+
+    // the clade of every node, filled in postorder
+    std::vector<uint64_t> below(tree.getNumberOfNodes() * words, 0);
+    std::vector<uint64_t> found;
+    const unsigned root = tree.root();
+    for (unsigned i = 0; i < order.size(); ++i)
+    {
+        const unsigned v = order[i];
+        uint64_t *b = &below[v * words];
+        if (tree.is_leaf(v))
+        {
+            b[leaf_id[v] / 64] |= uint64_t(1) << (leaf_id[v] % 64);
+            continue;
+        }
+        const uint64_t *l = &below[tree.left(v) * words];
+        const uint64_t *r = &below[tree.right(v) * words];
+        unsigned count = 0;
+        for (unsigned w = 0; w < words; ++w)
+        {
+            b[w] = l[w] | r[w];
+            count += popcount(b[w]);
+        }
+        if (v == root)
+        {
+            continue;
+        }
+        const size_t row = found.size();
+        found.insert(found.end(), b, b + words);
+        if (!rooted && (b[first_word] & first_bit))
+        {
+            for (unsigned w = 0; w < words; ++w)
+            {
+                found[row + w] = leaves[w] & ~b[w];
+            }
+            count = nleaves - count;
+        }
+        const bool trivial = rooted ? count < 2 || count >= nleaves
+                                    : count < 2 || count + 2 > nleaves;
+        if (trivial)
+        {
+            found.resize(row);
+        }
+    }
+
+    // sorted and without the repeated splits
+    const unsigned n = words == 0 ? 0 : found.size() / words;
+    std::vector<unsigned> rows(n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        rows[i] = i;
+    }
+    std::sort(rows.begin(), rows.end(), RowLess(found, words));
+    bits.reserve(found.size());
+    for (unsigned i = 0; i < n; ++i)
+    {
+        const uint64_t *row = &found[rows[i] * words];
+        if (bits.empty() || compare(&bits[bits.size() - words], words, row, words) != 0)
+        {
+            bits.insert(bits.end(), row, row + words);
+        }
+    }
+}
+
+Bipartitions::~Bipartitions()
+{
+
+}
+
+unsigned
+Bipartitions::size() const
+{
+    return words == 0 ? 0 : bits.size() / words;
+}
+
+unsigned
+Bipartitions::getWords() const
+{
+    return words;
+}
+
+const uint64_t*
+Bipartitions::operator[](unsigned i) const
+{
+    return &bits[i * words];
+}
+
+const uint64_t*
+Bipartitions::getLeaves() const
+{
+    return leaves.empty() ? 0 : &leaves[0];
+}
+
+bool
+Bipartitions::isRooted() const
+{
+    return rooted;
+}
+
+bool
+Bipartitions::contains(const uint64_t *b, unsigned w) const
+{
+    unsigned lo = 0;
+    unsigned hi = size();
+    while (lo < hi)
+    {
+        const unsigned mid = lo + (hi - lo) / 2;
+        const int c = compare((*this)[mid], words, b, w);
+        if (c == 0)
+        {
+            return true;
+        }
+        if (c < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return false;
+}
+
+int
+Bipartitions::compare(const uint64_t *a, unsigned wa, const uint64_t *b, unsigned wb)
+{
+    const unsigned w = std::max(wa, wb);
+    for (unsigned i = 0; i < w; ++i)
+    {
+        const uint64_t x = i < wa ? a[i] : 0;
+        const uint64_t y = i < wb ? b[i] : 0;
+        if (x != y)
+        {
+            return x < y ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+unsigned
+Bipartitions::robinsonFoulds(const Bipartitions &a, const Bipartitions &b)
+{
+    if (a.rooted != b.rooted)
+    {
+        throw AnError("Rooted and unrooted bipartitions can not be compared", 1);
+    }
+    if (compare(a.getLeaves(), a.words, b.getLeaves(), b.words) != 0)
+    {
+        throw AnError("The trees do not have the same leaves", 1);
+    }
+    unsigned i = 0;
+    unsigned j = 0;
+    unsigned common = 0;
+    while (i < a.size() && j < b.size())
+    {
+        const int c = compare(a[i], a.words, b[j], b.words);
+        if (c == 0)
+        {
+            ++common;
+        }
+        if (c <= 0)
+        {
+            ++i;
+        }
+        if (c >= 0)
+        {
+            ++j;
+        }
+    }
+    return a.size() + b.size() - 2 * common;
+}
+
+void
+Bipartitions::robinsonFoulds(const std::vector<const Bipartitions*> &trees,
+                             std::vector<unsigned> &distances)
+{
+    const unsigned n = trees.size();
+    distances.assign(n * n, 0);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        for (unsigned j = i + 1; j < n; ++j)
+        {
+            distances[i * n + j] = distances[j * n + i] = robinsonFoulds(*trees[i], *trees[j]);
+        }
+    }
+}
+
+BipartitionFrequencies::BipartitionFrequencies(NameTable &l, bool r)
+    : leaves(&l),
+      rooted(r),
+      counts(),
+      total_weight(0)
+{
+
+}
+
+BipartitionFrequencies::~BipartitionFrequencies()
+{
+
+}
+
+void
+BipartitionFrequencies::add(const TreeExtended &tree, unsigned long weight)
+{
+    add(Bipartitions(tree, *leaves, rooted), weight);
+}
+
+void
+BipartitionFrequencies::add(const Bipartitions &b, unsigned long weight)
+{
+    if (b.isRooted() != rooted)
+    {
+        throw AnError("Rooted and unrooted bipartitions can not be counted together", 1);
+    }
+    for (unsigned i = 0; i < b.size(); ++i)
+    {
+        counts[makeKey(b[i], b.getWords())] += weight;
+    }
+    total_weight += weight;
+}
+
+unsigned
+BipartitionFrequencies::size() const
+{
+    return counts.size();
+}
+
+unsigned long
+BipartitionFrequencies::getTotalWeight() const
+{
+    return total_weight;
+}
+
+unsigned long
+BipartitionFrequencies::getCount(const uint64_t *bits, unsigned words) const
+{
+    std::unordered_map<Key, unsigned long, KeyHash>::const_iterator it =
+            counts.find(makeKey(bits, words));
+    return it == counts.end() ? 0 : it->second;
+}
+
+double
+BipartitionFrequencies::getFrequency(const uint64_t *bits, unsigned words) const
+{
+    return total_weight == 0 ? 0.0 : double(getCount(bits, words)) / double(total_weight);
+}
+
+// the most frequent first, the ties in the order of the bitsets
+static bool moreFrequent(const BipartitionFrequencies::Entry &a,
+                         const BipartitionFrequencies::Entry &b)
+{
+    if (a.count != b.count)
+    {
+        return a.count > b.count;
+    }
+    return Bipartitions::compare(a.bits.empty() ? 0 : &a.bits[0], a.bits.size(),
+                                 b.bits.empty() ? 0 : &b.bits[0], b.bits.size()) < 0;
+}
+
+std::vector<BipartitionFrequencies::Entry>
+BipartitionFrequencies::getTable() const
+{
+    std::vector<Entry> table;
+    table.reserve(counts.size());
+    for (std::unordered_map<Key, unsigned long, KeyHash>::const_iterator it = counts.begin();
+         it != counts.end(); ++it)
+    {
+        Entry e;
+        e.bits = it->first;
+        e.count = it->second;
+        table.push_back(e);
+    }
+    std::sort(table.begin(), table.end(), moreFrequent);
+    return table;
+}
+
+std::vector<std::string>
+BipartitionFrequencies::getLeafNames(const std::vector<uint64_t> &bits) const
+{
+    std::vector<std::string> names;
+    for (unsigned w = 0; w < bits.size(); ++w)
+    {
+        for (unsigned i = 0; i < 64; ++i)
+        {
+            if (bits[w] & (uint64_t(1) << i))
+            {
+                names.push_back(leaves->getName(w * 64 + i));
+            }
+        }
+    }
+    return names;
+}
+
+void
+BipartitionFrequencies::clear()
+{
+    counts.clear();
+    total_weight = 0;
+}
+
+size_t
+BipartitionFrequencies::KeyHash::operator()(const Key &k) const
+{
+    uint64_t h = 0;
+    for (unsigned i = 0; i < k.size(); ++i)
+    {
+        h = hash_mix(h ^ (k[i] + 0x9e3779b97f4a7c15ULL));
+    }
+    return static_cast<size_t>(h);
+}
+
+BipartitionFrequencies::Key
+BipartitionFrequencies::makeKey(const uint64_t *bits, unsigned words)
+{
+    while (words > 0 && bits[words - 1] == 0)
+    {
+        --words;
+    }
+    return Key(bits, bits + words);
+}
@@ -0,0 +1,151 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+/* The bipartitions of a tree as bitsets of its leaves. The bit of a leaf is
+ * the id of its name in a NameTable that is shared by all the trees compared,
+ * so the same clade gets the same bitset in every tree. A bitset is stored
+ * as words of 64 bits, the bipartitions of a tree are kept sorted in one flat
+ * array, which makes the Robinson-Foulds distance a merge of two arrays.
+ *
+ * Unrooted bipartitions are the splits of the internal edges, a split is
+ * stored as the side that does not hold the leaf with the smallest bit, so
+ * the two edges below the root give the same split. Rooted bipartitions are
+ * the clades below the internal nodes other than the root. The trivial ones
+ * (a single leaf or all of them) are left out.
+ *
+ * BipartitionFrequencies counts the bipartitions of the trees of a sample,
+ * e.g. the trees of a posterior sample read with TreeIO::readAllNewickTrees. */
+
+#ifndef BIPARTITIONS_H
+#define BIPARTITIONS_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "../utils/NameTable.h"
+
+class TreeExtended;
+
+using namespace std;
+
+class Bipartitions
+{
+
+public:
+
+    // computes the bipartitions of tree in one postorder pass, the leaf
+    // names not yet in leaves are added to it. Throws AnError if two leaves
+    // of the tree have the same name.
+    Bipartitions(const TreeExtended &tree, NameTable &leaves, bool rooted = false);
+    // destructor
+    virtual ~Bipartitions();
+
+    // number of bipartitions
+    unsigned size() const;
+    // number of 64 bit words of each bitset
+    unsigned getWords() const;
+    // the bitset of the bipartition i, the bipartitions are sorted
+    const uint64_t* operator[](unsigned i) const;
+    // the bitset of all the leaves of the tree
+    const uint64_t* getLeaves() const;
+    bool isRooted() const;
+
+    // true if the tree has the bipartition given (words long)
+    bool contains(const uint64_t *bits, unsigned words) const;
+
+    // number of bipartitions found in only one of the trees, throws
+    // AnError if the trees do not have the same leaves
+    static unsigned robinsonFoulds(const Bipartitions &a, const Bipartitions &b);
+    // the distance of every pair of trees, distances[i * n + j] for n trees
+    static void robinsonFoulds(const std::vector<const Bipartitions*> &trees,
+                               std::vector<unsigned> &distances);
+
+    // orders bitsets of different length as if the shorter one was padded
+    // with zeros, returns <0, 0 or >0
+    static int compare(const uint64_t *a, unsigned wa, const uint64_t *b, unsigned wb);
+
+private:
+
+    unsigned words;
+    bool rooted;
+    std::vector<uint64_t> leaves;
+    std::vector<uint64_t> bits; // size() bitsets of words each
+};
+
+class BipartitionFrequencies
+{
+
+public:
+
+    struct Entry
+    {
+        std::vector<uint64_t> bits;
+        unsigned long count;     // sum of the weights of the trees that have it
+    };
+
+    // the leaf names are shared with the Bipartitions added
+    explicit BipartitionFrequencies(NameTable &leaves, bool rooted = false);
+    // destructor
+    virtual ~BipartitionFrequencies();
+
+    // counts the bipartitions of a tree with the given weight
+    void add(const TreeExtended &tree, unsigned long weight = 1);
+    void add(const Bipartitions &b, unsigned long weight = 1);
+
+    // number of different bipartitions seen
+    unsigned size() const;
+    // sum of the weights of the trees added
+    unsigned long getTotalWeight() const;
+
+    // count of the bipartition given (words long), 0 if never seen
+    unsigned long getCount(const uint64_t *bits, unsigned words) const;
+    // count divided by the total weight
+    double getFrequency(const uint64_t *bits, unsigned words) const;
+
+    // all the bipartitions seen, the most frequent first
+    std::vector<Entry> getTable() const;
+
+    // the leaf names of a bitset
+    std::vector<std::string> getLeafNames(const std::vector<uint64_t> &bits) const;
+
+    void clear();
+
+private:
+
+    // bitsets with the trailing zero words removed, so the key of a
+    // bipartition does not depend on the size of the NameTable
+    typedef std::vector<uint64_t> Key;
+    struct KeyHash
+    {
+        size_t operator()(const Key &k) const;
+    };
+    static Key makeKey(const uint64_t *bits, unsigned words);
+
+    NameTable *leaves;
+    bool rooted;
+    std::unordered_map<Key, unsigned long, KeyHash> counts;
+    unsigned long total_weight;
+};
+
+#endif // BIPARTITIONS_H
@@ -0,0 +1,307 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+#include "CladeHash.h"
+
+#include <memory>
+#include <utility>
+
+#include "Node.h"
+#include "HashMix.h"
+#include "Bipartitions.h"
+#include "TreeStream.h"
+#include "../utils/AnError.h"
+
+// FNV-1a over the characters of the name
+static uint64_t leafHash(const std::string &name)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < name.size(); ++i)
+    {
+        h = (h ^ static_cast<unsigned char>(name[i])) * 1099511628211ULL;
+    }
+    return hash_mix(h);
+}
+
+// the smaller hash goes first so the order of the children does not matter
+static uint64_t internalHash(uint64_t left, uint64_t right)
+{
+    if (left > right)
+    {
+        std::swap(left, right);
+    }
+    return hash_mix(left ^ hash_mix(right + 0x9e3779b97f4a7c15ULL));
+}
+
+CladeHash::CladeHash(const TreeExtended &tree)
+    : tree(&tree),
+      hashes(tree.getNumberOfNodes(), 0)
+{
+    const std::vector<unsigned> &order = tree.postorder();
+    for (unsigned i = 0; i < order.size(); ++i)
+    {
+        const unsigned v = order[i];
+        if (tree.is_leaf(v))
+        {
+            hashes[v] = leafHash(tree.getNode(v)->getName());
+        }
+        else
+        {
+            hashes[v] = internalHash(hashes[tree.left(v)], hashes[tree.right(v)]);
+        }
+    }
+}
+
+CladeHash::~CladeHash()
+{
+
+}
+
+uint64_t CladeHash::operator[](unsigned v) const
+{
+    return hashes[v];
+}
+
+uint64_t CladeHash::getCladeHash(const Node *v) const
+{
+    return hashes[v->getNumber()];
+}
+
+uint64_t CladeHash::getTreeHash() const
+{
+    const Node *root = tree->getRootNode();
+    return root ? hashes[root->getNumber()] : 0;
+}
+
+const TreeExtended& CladeHash::getTree() const
+{
+    return *tree;
+}
+
+// The pairs of clades to compare are kept on an explicit stack, the children
+// are matched by their hashes
+bool CladeHash::sameClade(const CladeHash &a, unsigned u,
+                          const CladeHash &b, unsigned v)
+{
+    const TreeExtended &ta = *a.tree;
+    const TreeExtended &tb = *b.tree;
+    std::vector<std::pair<unsigned, unsigned> > stack(1, std::make_pair(u, v));
+    while (!stack.empty())
+    {
+        u = stack.back().first;
+        v = stack.back().second;
+        stack.pop_back();
+
+        if (a.hashes[u] != b.hashes[v] || ta.is_leaf(u) != tb.is_leaf(v))
+        {
+            return false;
+        }
+        if (ta.is_leaf(u))
+        {
+            if (ta.getNode(u)->getName() != tb.getNode(v)->getName())
+            {
+                return false;
+            }
+            continue;
+        }
+
+        unsigned ul = ta.left(u);
+        unsigned ur = ta.right(u);
+        unsigned vl = tb.left(v);
+        unsigned vr = tb.right(v);
+        if (a.hashes[ul] > a.hashes[ur])
+        {
+            std::swap(ul, ur);
+        }
+        if (b.hashes[vl] > b.hashes[vr])
+        {
+            std::swap(vl, vr);
+        }
+        stack.push_back(std::make_pair(ul, vl));
+        stack.push_back(std::make_pair(ur, vr));
+    }
+    return true;
+}
+
+bool CladeHash::sameTopology(const CladeHash &a, const CladeHash &b)
+{
+    const Node *ra = a.tree->getRootNode();
+    const Node *rb = b.tree->getRootNode();
+    if (ra == 0 || rb == 0)
+    {
+        return ra == rb;
+    }
+    return sameClade(a, ra->getNumber(), b, rb->getNumber());
+}
+
+TopologySet::TopologySet()
+    : topologies(),
+      hashes(),
+      index(),
+      total_weight(0.0)
+{
+
+}
+
+TopologySet::~TopologySet()
+{
+    clear();
+}
+
+unsigned TopologySet::insert(TreeExtended *tree, double weight)
+{
+    if (tree == 0)
+    {
+        throw AnError("TopologySet::insert: the tree is 0");
+    }
+    std::unique_ptr<TreeExtended> owned(tree);
+    CladeHash h(*tree);
+    total_weight += weight;
+
+    typedef std::multimap<uint64_t, unsigned>::const_iterator iterator;
+    std::pair<iterator, iterator> range = index.equal_range(h.getTreeHash());
+    for (iterator it = range.first; it != range.second; ++it)
+    {
+        if (CladeHash::sameTopology(hashes[it->second], h))
+        {
+            topologies[it->second].weight += weight;
+            return it->second;
+        }
+    }
+
+    Topology t;
+    t.tree = tree;
+    t.weight = weight;
+    topologies.reserve(topologies.size() + 1);
+    hashes.push_back(h);
+    topologies.push_back(t);
+    owned.release();
+    const unsigned i = topologies.size() - 1;
+    index.insert(std::make_pair(h.getTreeHash(), i));
+    return i;
+}
+
+unsigned long TopologySet::insert(TreeStream &stream)
+{
+    unsigned long trees = 0;
+    while (TreeExtended *tree = stream.next())
+    {
+        insert(tree, stream.getWeight());
+        ++trees;
+    }
+    return trees;
+}
+
+unsigned TopologySet::getMostFrequent() const
+{
+    if (topologies.empty())
+    {
+        throw AnError("TopologySet::getMostFrequent: the set is empty");
+    }
+    unsigned best = 0;
+    for (unsigned i = 1; i < topologies.size(); ++i)
+    {
+        if (topologies[i].weight > topologies[best].weight)
+        {
+            best = i;
+        }
+    }
+    return best;
+}
+
+unsigned TopologySet::size() const
+{
+    return topologies.size();
+}
+
+const TopologySet::Topology& TopologySet::operator[](unsigned i) const
+{
+    return topologies[i];
+}
+
+const CladeHash& TopologySet::getHashes(unsigned i) const
+{
+    return hashes[i];
+}
+
+double TopologySet::getTotalWeight() const
+{
+    return total_weight;
+}
+
+// the rooted clades of every topology, with the leaf names shared
+static std::vector<Bipartitions> rootedClades(const TopologySet &set, NameTable &leaves)
+{
+    std::vector<Bipartitions> clades;
+    clades.reserve(set.size());
+    for (unsigned i = 0; i < set.size(); ++i)
+    {
+        clades.push_back(Bipartitions(*set[i].tree, leaves, true));
+    }
+    return clades;
+}
+
+std::vector<unsigned> TopologySet::getDistances(unsigned i) const
+{
+    NameTable leaves;
+    const std::vector<Bipartitions> clades = rootedClades(*this, leaves);
+    std::vector<unsigned> distances(clades.size());
+    for (unsigned j = 0; j < clades.size(); ++j)
+    {
+        distances[j] = Bipartitions::robinsonFoulds(clades[i], clades[j]);
+    }
+    return distances;
+}
+
+std::vector<double> TopologySet::getCladeSupport(unsigned i) const
+{
+    NameTable leaves;
+    const std::vector<Bipartitions> clades = rootedClades(*this, leaves);
+    const Bipartitions &mine = clades[i];
+    std::vector<double> support(mine.size(), 0.0);
+    for (unsigned c = 0; c < mine.size(); ++c)
+    {
+        for (unsigned j = 0; j < clades.size(); ++j)
+        {
+            if (clades[j].contains(mine[c], mine.getWords()))
+            {
+                support[c] += topologies[j].weight;
+            }
+        }
+        if (total_weight > 0.0)
+        {
+            support[c] /= total_weight;
+        }
+    }
+    return support;
+}
+
+void TopologySet::clear()
+{
+    for (unsigned i = 0; i < topologies.size(); ++i)
+    {
+        delete topologies[i].tree;
+    }
+    topologies.clear();
+    hashes.clear();
+    index.clear();
+    total_weight = 0.0;
+}
@@ -0,0 +1,138 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+/* Structural hashes of the clades of a tree. The hash of a leaf is computed
+ * from its name and the hash of an internal node from the hashes of its two
+ * children taken in sorted order, so that the left to right order of the
+ * children, the node numbers and the branch lengths do not matter. Two
+ * rooted trees with the same topology and leaf names get the same hash.
+ *
+ * TopologySet uses the tree hash to collapse the trees of a multi-tree input
+ * that share the topology, a collision of the hashes is ruled out by
+ * comparing the trees before two of them are merged. A sample read with
+ * TreeStream is collapsed as it is read, so only one tree per topology is
+ * held in memory. The topologies are compared by their rooted Bipartitions
+ * to summarize the sample. */
+
+#ifndef CLADEHASH_H
+#define CLADEHASH_H
+
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+#include "Treeextended.h"
+
+class TreeStream;
+
+using namespace std;
+
+class CladeHash
+{
+
+public:
+
+    // hashes all the clades of tree in one postorder pass, the hashes are
+    // not updated if the tree is changed afterwards
+    explicit CladeHash(const TreeExtended &tree);
+    // destructor
+    virtual ~CladeHash();
+
+    // the hash of the clade below the node with number v
+    uint64_t operator[](unsigned v) const;
+    uint64_t getCladeHash(const Node *v) const;
+
+    // the hash of the clade below the root
+    uint64_t getTreeHash() const;
+
+    const TreeExtended& getTree() const;
+
+    // true if the clade below u in a and the clade below v in b have the
+    // same topology and leaf names
+    static bool sameClade(const CladeHash &a, unsigned u,
+                          const CladeHash &b, unsigned v);
+    static bool sameTopology(const CladeHash &a, const CladeHash &b);
+
+private:
+
+    const TreeExtended *tree;
+    std::vector<uint64_t> hashes;
+};
+
+class TopologySet
+{
+
+public:
+
+    struct Topology
+    {
+        TreeExtended *tree; // the first tree seen with this topology
+        double weight;      // sum of the weights of the trees inserted
+    };
+
+    // constructor
+    explicit TopologySet();
+    // destructor, deletes the trees of the topologies
+    virtual ~TopologySet();
+
+    // adds tree with the given weight (e.g., the count of a sampled tree)
+    // and returns the index of its topology. The set owns the tree: it is
+    // kept if its topology is new and deleted otherwise
+    unsigned insert(TreeExtended *tree, double weight = 1.0);
+    // adds the trees left in the stream weighted by their counts, returns
+    // the number of trees read
+    unsigned long insert(TreeStream &stream);
+
+    // index of the topology with the largest weight, the first one inserted
+    // on ties. Throws AnError if the set is empty
+    unsigned getMostFrequent() const;
+
+    // number of distinct topologies
+    unsigned size() const;
+    const Topology& operator[](unsigned i) const;
+    const CladeHash& getHashes(unsigned i) const;
+
+    // sum of the weights of all the trees inserted
+    double getTotalWeight() const;
+
+    // Robinson-Foulds distance over the rooted clades (see Bipartitions)
+    // from topology i to each topology of the set. Throws AnError if the
+    // trees do not have the same leaves
+    std::vector<unsigned> getDistances(unsigned i) const;
+    // for each rooted clade of topology i, in the order of its Bipartitions,
+    // the fraction of the total weight held by the topologies that have it
+    std::vector<double> getCladeSupport(unsigned i) const;
+
+    // deletes the trees and empties the set
+    void clear();
+
+private:
+
+    TopologySet(const TopologySet &);
+    TopologySet& operator=(const TopologySet &);
+
+    std::vector<Topology> topologies;
+    std::vector<CladeHash> hashes;
+    std::multimap<uint64_t, unsigned> index; // tree hash -> topology
+    double total_weight;
+};
+
+#endif // CLADEHASH_H
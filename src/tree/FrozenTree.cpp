@@ -0,0 +1,164 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+#include "FrozenTree.h"
+#include "Node.h"
+
+#include "../utils/AnError.h"
+
+const unsigned FrozenTree::NO_NODE;
+
+FrozenTree::FrozenTree(const TreeExtended &tree)
+    : tree(&tree)
+{
+    if (!tree.isFrozen())
+    {
+        throw AnError("FrozenTree: the tree has not been frozen");
+    }
+}
+
+FrozenTree::~FrozenTree()
+{
+
+}
+
+const TreeExtended& FrozenTree::getTree() const
+{
+    return *tree;
+}
+
+unsigned FrozenTree::getNumberOfNodes() const
+{
+    return tree->getNumberOfNodes();
+}
+
+unsigned FrozenTree::getNumberOfLeaves() const
+{
+    return tree->getNumberOfLeaves();
+}
+
+unsigned FrozenTree::root() const
+{
+    return tree->root();
+}
+
+unsigned FrozenTree::parent(unsigned v) const
+{
+    return tree->parent(v);
+}
+
+unsigned FrozenTree::left(unsigned v) const
+{
+    return tree->left(v);
+}
+
+unsigned FrozenTree::right(unsigned v) const
+{
+    return tree->right(v);
+}
+
+bool FrozenTree::is_leaf(unsigned v) const
+{
+    return tree->is_leaf(v);
+}
+
+const std::vector<unsigned>& FrozenTree::preorder() const
+{
+    return tree->preorder();
+}
+
+const std::vector<unsigned>& FrozenTree::postorder() const
+{
+    return tree->postorder();
+}
+
+unsigned FrozenTree::dfs_entry(unsigned v) const
+{
+    return tree->dfs_entry(v);
+}
+
+unsigned FrozenTree::dfs_exit(unsigned v) const
+{
+    return tree->dfs_exit(v);
+}
+
+unsigned FrozenTree::depth(unsigned v) const
+{
+    return tree->depth(v);
+}
+
+bool FrozenTree::descendant(unsigned v1, unsigned v2) const
+{
+    return tree->descendant(v1, v2);
+}
+
+unsigned FrozenTree::lca(unsigned v1, unsigned v2) const
+{
+    return tree->lca(v1, v2);
+}
+
+void FrozenTree::lca(const std::vector<std::pair<unsigned, unsigned> > &queries,
+                     std::vector<unsigned> &answers) const
+{
+    tree->lca(queries, answers);
+}
+
+unsigned FrozenTree::getNumberOfLeaves(unsigned v) const
+{
+    return tree->getNumberOfLeaves(*tree->getNode(v));
+}
+
+unsigned FrozenTree::getMaxPathToLeaf(unsigned v) const
+{
+    return tree->getMaxPathToLeaf(*tree->getNode(v));
+}
+
+const Node* FrozenTree::getNode(unsigned v) const
+{
+    return tree->getNode(v);
+}
+
+const std::string& FrozenTree::getName(unsigned v) const
+{
+    return tree->getNode(v)->getName();
+}
+
+unsigned FrozenTree::findNode(const std::string &name) const
+{
+    const Node *v = tree->findNode(name);
+    return v ? v->getNumber() : NO_NODE;
+}
+
+bool FrozenTree::hasTimes() const
+{
+    return tree->hasTimes();
+}
+
+double FrozenTree::getTime(unsigned v) const
+{
+    return tree->getTime(*tree->getNode(v));
+}
+
+double FrozenTree::getTopTime() const
+{
+    return tree->getTopTime();
+}
@@ -0,0 +1,91 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+/* FrozenTree is a read only view of a frozen TreeExtended. It gives access
+ * to the topology arrays, the traversals, the LCA and the names and times of
+ * the nodes, all by node number, and only hands out const nodes. The tree
+ * is not copied: a view is a pointer to it and can be passed by value to
+ * every worker thread, as long as the tree stays frozen and alive. */
+
+#ifndef FROZENTREE_H
+#define FROZENTREE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "Treeextended.h"
+
+using namespace std;
+
+class FrozenTree
+{
+
+public:
+
+    static const unsigned NO_NODE = TreeExtended::NO_NODE;
+
+    // throws AnError if tree is not frozen
+    explicit FrozenTree(const TreeExtended &tree);
+    // destructor
+    virtual ~FrozenTree();
+
+    const TreeExtended& getTree() const;
+
+    unsigned getNumberOfNodes() const;
+    unsigned getNumberOfLeaves() const;
+
+    // topology, see TreeExtended
+    unsigned root() const;
+    unsigned parent(unsigned v) const;
+    unsigned left(unsigned v) const;
+    unsigned right(unsigned v) const;
+    bool is_leaf(unsigned v) const;
+    const std::vector<unsigned>& preorder() const;
+    const std::vector<unsigned>& postorder() const;
+    unsigned dfs_entry(unsigned v) const;
+    unsigned dfs_exit(unsigned v) const;
+    unsigned depth(unsigned v) const;
+    bool descendant(unsigned v1, unsigned v2) const;
+    unsigned lca(unsigned v1, unsigned v2) const;
+    void lca(const std::vector<std::pair<unsigned, unsigned> > &queries,
+             std::vector<unsigned> &answers) const;
+
+    // subtree aggregates
+    unsigned getNumberOfLeaves(unsigned v) const;
+    unsigned getMaxPathToLeaf(unsigned v) const;
+
+    // node attributes
+    const Node* getNode(unsigned v) const;
+    const std::string& getName(unsigned v) const;
+    // the node with the given name or NO_NODE
+    unsigned findNode(const std::string &name) const;
+    bool hasTimes() const;
+    double getTime(unsigned v) const;
+    double getTopTime() const;
+
+private:
+
+    const TreeExtended *tree;
+};
+
+#endif // FROZENTREE_H
@@ -15,43 +15,27 @@
     You should have received a copy of the GNU General Public License along
     with this program; if not, write to the Free Software Foundation, Inc.,
     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
-    
-    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
-             Lars Arvestad, © the MCMC-club, SBC, all rights reserved
- */
-
-#ifndef NHXTREE_H
-#define NHXTREE_H
 
-/*
-  An NHXtree keeps the pointer to the root node of a tree
-  and has also a pointer to the next tree in the list, since
-  we are actually talking about a tree list here!
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
 */
 
-#include "NHXnode.h"
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-#include <stdio.h>
-
-
-struct NHXtree {
-    struct NHXtree *next;
-    struct NHXnode *root;
-};
+/* Hash mixing shared by the structural hashes of the tree module (see
+ * CladeHash.h and Bipartitions.h). Internal to the module. */
 
-struct NHXtree *read_tree(const char *filename);
-struct NHXtree *read_tree_string(const char *str);
-struct NHXtree *read_tree_from_file_stream(FILE * f);
-void delete_trees(struct NHXtree *tree);
+#ifndef HASHMIX_H
+#define HASHMIX_H
 
-unsigned treeSize(const struct NHXtree *tree);
+#include <stdint.h>
 
-struct NHXtree *new_tree(struct NHXnode *root, struct NHXtree *next_tree);
-#ifdef __cplusplus
+// finalizer of splitmix64, every bit of x affects every bit of the result
+inline uint64_t hash_mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
 }
-#endif
 
-#endif
+#endif // HASHMIX_H
@@ -26,11 +26,11 @@
 #include <cstring>
 #include <cstdio>
 #include <sstream>
+#include <vector>
 
 #include "../utils/AnError.h"
 #include "Node.h"
 #include "Tree.h"
-#include "../reconcilation/BeepVector.h"
 
 using namespace std;
 
@@ -43,15 +43,7 @@ Node::Node(unsigned id)
       nodeTime(0.0),
       branchLength(0.0),
       name(),
-      ownerTree(0),
-      color(),
-      size(0.0),
-      x(0.0),
-      y(0.0),
-      hostParent(0),
-      hostChild(0),
-      reconcilation(Undefined),
-      visited(0)
+      ownerTree(0)
 {
 
 }
@@ -65,15 +57,7 @@ Node::Node(unsigned id, const string& nodeName)
       nodeTime(0.0),
       branchLength(0.0),
       name(nodeName),
-      ownerTree(0),
-      color(),
-      size(0.0),
-      x(0.0),
-      y(0.0),
-      hostParent(0),
-      hostChild(0),
-      reconcilation(Undefined),
-      visited(0)
+      ownerTree(0)
 {
 
 }
@@ -139,24 +123,16 @@ Node::getDominatingChild(Node* y)
 void
 Node::rotate()
 {
+    if(ownerTree)
+    {
+        ownerTree->topologyChanged();
+    }
     Node *tmp;
     tmp = leftChild;
     leftChild = rightChild;
     rightChild = tmp;
 }
 
-// rotate cordinates from left two right or viceversa
-void
-Node::rotateCordinates()
-{
-    double temp_x = leftChild->getX();
-    double temp_y = leftChild->getY();
-    leftChild->setX(rightChild->getX());
-    leftChild->setY(rightChild->getY());
-    rightChild->setX(temp_x);
-    rightChild->setY(temp_y);
-}
-
 // get the (leaf) name
 const string&
 Node::getName() const
@@ -188,16 +164,7 @@ Node::getNumber() const
 unsigned
 Node::getNumberOfLeaves() const
 {
-    if (isLeaf())
-    {
-        return 1;
-    }
-    else
-    {
-        unsigned left = leftChild->getNumberOfLeaves();
-        unsigned right = rightChild->getNumberOfLeaves();
-        return left + right;
-    }
+    return ownerTree->getNumberOfLeaves(*this);
 }
 
 double Node::getBranchLength() const
@@ -208,35 +175,17 @@ double Node::getBranchLength() const
 unsigned
 Node::getMaxPathToLeaf() const
 {
-    if(isLeaf())
-    {
-        return 0;
-    }
-    else
-    {
-        unsigned left = leftChild->getMaxPathToLeaf();
-        unsigned right = rightChild->getMaxPathToLeaf();
-        return 1 + ((left > right)? left:right);
-    }
+    return ownerTree->getMaxPathToLeaf(*this);
 }
 
 SetOfNodesEx<Node>
 Node::getLeaves()
 {
     SetOfNodesEx<Node> nodes;
-    if ( isLeaf() )
-    {
-        nodes.insert(this);
-    }
-    else
+    const NodeSpan leaves = ownerTree->getLeaves(*this);
+    for(unsigned i = 0; i < leaves.size(); i++)
     {
-        //Find leaves recursively
-        nodes = leftChild->getLeaves();
-        SetOfNodesEx<Node> r = rightChild->getLeaves();
-        for(unsigned i = 0; i < r.size(); i++)
-        {
-            nodes.insert(r[i]);
-        }
+        nodes.insert(leaves[i]);
     }
     return nodes;
 }
@@ -262,6 +211,10 @@ Node::setTree(Tree& tree)
 void
 Node::setChildren(Node *l, Node *r)
 {
+    if(ownerTree)
+    {
+        ownerTree->topologyChanged();
+    }
     //NOTE possible memory leak
     leftChild = l;
     rightChild = r;
@@ -281,6 +234,10 @@ Node::setChildren(Node *l, Node *r)
 void
 Node::setParent(Node *v)
 {
+    if(ownerTree)
+    {
+        ownerTree->topologyChanged();
+    }
     //NOTE possible memory leak
     parent = v;
 }
@@ -291,24 +248,33 @@ void
 Node::changeID(unsigned newID)
 {
     assert(newID < getTree()->getNumberOfNodes());
+    ownerTree->topologyChanged();
     number = newID;
 }
 
 
-// Delete all nodes lower in the tree. The current node is not deleted.
+// Detach all nodes lower in the tree. The nodes are stored in the node
+// arena of the tree and are released together with it.
 void
 Node::deleteSubtree()
 {
-    if(isLeaf() == false)
+    if(ownerTree)
+    {
+        ownerTree->topologyChanged();
+    }
+    std::vector<Node*> stack(1, this);
+    while(stack.empty() == false)
     {
-        leftChild -> deleteSubtree();
-        delete leftChild;
-        rightChild -> deleteSubtree();
-        delete rightChild;
-        
+        Node *v = stack.back();
+        stack.pop_back();
+        if(v->isLeaf() == false)
+        {
+            stack.push_back(v->leftChild);
+            stack.push_back(v->rightChild);
+        }
+        v->leftChild = 0;
+        v->rightChild = 0;
     }
-    leftChild = 0;
-    rightChild = 0;
 }
 
 
@@ -551,114 +517,20 @@ operator<< (std::ostream& o, const Node *v)
 
 /*** EXTRA FEATURES ***/
 
-void Node::setColor(Color c)
-{
-    color = c;
-}
-
-void Node::setSize(double _size)
-{
-    size = _size;
-}
-
-void Node::setX(double _x)
-{
-    x = _x;
-}
-
-void Node::setY(double _y)
-{
-    y = _y;
-}
-
-void Node::setHostChild(Node* _hostchild)
-{
-    //NOTE possible memory leak
-   hostChild = _hostchild;
-}
-
-void Node::setHostParent(Node* _hostparent)
-{
-    //NOTE possible memory leak
-    hostParent = _hostparent;
-}
-
-void Node::setReconcilation(Type t)
-{
-    reconcilation = t;
-}
-
-void Node::setVisited(unsigned inc)
-{
-    visited = inc;
-}
-
-void Node::incVisited()
-{
-    visited++;
-}
-
-Color Node::getColor()
-{
-    return color;
-}
-
-double Node::getSize() const
-{
-    return size;
-}
-
-double Node::getX() const
-{
-    return x;
-}
-
-double Node::getY() const
-{
-    return y;
-}
-
-Node* Node::getHostParent()
-{
-    return hostParent;
-}
-
-Node* Node::getHostChild()
-{
-    return hostChild;
-}
-
-Node::Type Node::getReconcilation() const
-{
-    return reconcilation;
-}
-
-Node* Node::getHostParent() const
-{
-    return hostParent;
-}
-
-Node* Node::getHostChild() const
-{
-    return hostChild;
-}
-
-Node::Type Node::getReconcilation()
-{
-    return reconcilation;
-}
-
-unsigned Node::getVisited() const
-{
-    return visited;
-}
-
 void Node::setRightChild(Node *r )
 {
+    if(ownerTree)
+    {
+        ownerTree->topologyChanged();
+    }
     rightChild = r;
 }
 
 void Node::setLeftChild(Node *l )
 {
+    if(ownerTree)
+    {
+        ownerTree->topologyChanged();
+    }
     leftChild = l;
 }
@@ -27,7 +27,6 @@
 #include <string>
 #include <map>
 
-#include "../draw/Color.h"
 #include "../reconcilation/SetOfNodesEx.h"
 
 using namespace std;
@@ -36,47 +35,21 @@ class Tree;
 class Node
 {
 
-public:
+    // the tree moves the pointers of the nodes it copies
+    friend class Tree;
 
-    enum Type{
-        Leaf = 0,
-        Speciation = 1,
-        Duplication = 2,
-        LateralTransfer = 3,
-        Undefined = 4
-    };
+public:
 
     explicit Node(unsigned id);
     explicit Node(unsigned id, const std::string& nodeName);
     virtual ~Node();
 
     //Extra Methods
-    void setColor(Color c);
-    void setSize(double s);
-    void setX(double x);
-    void setY(double y);
-    void setHostParent(Node *hostparent);
-    void setHostChild(Node *hostchild);
-    void setReconcilation(Type t);
-    void setVisited(unsigned inc);
-    void incVisited();
-    Color getColor();
-    double getSize() const;
-    double getX() const;
-    double getY() const;
-    Node *getHostParent();
-    Node *getHostChild();
-    Type getReconcilation();
-    Node *getHostParent() const;
-    Node *getHostChild() const;
-    Type getReconcilation() const;
-    unsigned getVisited() const;
     void setRightChild(Node *);
     void setLeftChild(Node *);
     //Extra Methods
 
     void rotate();
-    void rotateCordinates();
 
     Node* getLeftChild() const;
     Node* getRightChild() const;
@@ -145,16 +118,6 @@ protected:
 
     std::string name;     // the (leaf) name
     Tree* ownerTree;      // The tree to which I belong
-
-    /* extra features */
-    Color color;
-    double size;
-    double x;
-    double y;
-    Node *hostParent;
-    Node *hostChild;
-    Type reconcilation;
-    unsigned visited;
 };
 
 #endif
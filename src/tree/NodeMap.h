@@ -0,0 +1,202 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+/* NodeMap keeps a value for every node of a tree in one contiguous array
+ * indexed by the node numbers. The accesses are not bounds checked, the
+ * asserts only catch a bad index in debug builds, so a lookup in a hot loop
+ * is a plain indexed load. The values can also be handed out as a span and
+ * filled or transformed in bulk. */
+
+#ifndef NODEMAP_H
+#define NODEMAP_H
+
+#include <cassert>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+#include "Node.h"
+
+using namespace std;
+
+// A run of consecutive values of a NodeMap
+template<typename Type>
+struct NodeMapSpan
+{
+    Type *first;
+    Type *last;
+
+    Type* begin() const { return first; }
+    Type* end() const { return last; }
+    unsigned size() const { return static_cast<unsigned>(last - first); }
+    Type& operator[](unsigned i) const { return first[i]; }
+};
+
+template<typename Type>
+class NodeMap
+{
+
+public:
+
+    typedef typename std::vector<Type>::iterator iterator;
+    typedef typename std::vector<Type>::const_iterator const_iterator;
+
+    // an empty map
+    NodeMap()
+        : pv()
+    {
+    }
+
+    // n_elems values initialized to Type() (zero for numbers and pointers)
+    explicit NodeMap(unsigned n_elems)
+        : pv(n_elems)
+    {
+    }
+
+    // n_elems values initialized to value
+    NodeMap(unsigned n_elems, const Type &value)
+        : pv(n_elems, value)
+    {
+    }
+
+    bool operator==(const NodeMap<Type> &m) const
+    {
+        return pv == m.pv;
+    }
+
+    // the map is indexed by nodes, pointers to nodes or node numbers
+    Type& operator[](const Node &v)
+    {
+        return operator[](v.getNumber());
+    }
+
+    const Type& operator[](const Node &v) const
+    {
+        return operator[](v.getNumber());
+    }
+
+    Type& operator[](const Node *v)
+    {
+        assert(v != 0);
+        return operator[](v->getNumber());
+    }
+
+    const Type& operator[](const Node *v) const
+    {
+        assert(v != 0);
+        return operator[](v->getNumber());
+    }
+
+    Type& operator[](unsigned i)
+    {
+        assert(i < pv.size());
+        return pv[i];
+    }
+
+    const Type& operator[](unsigned i) const
+    {
+        assert(i < pv.size());
+        return pv[i];
+    }
+
+    // the values in the order of the node numbers
+    Type* data() { return pv.empty() ? 0 : &pv[0]; }
+    const Type* data() const { return pv.empty() ? 0 : &pv[0]; }
+
+    NodeMapSpan<Type> span()
+    {
+        NodeMapSpan<Type> s = { data(), data() + pv.size() };
+        return s;
+    }
+
+    NodeMapSpan<const Type> span() const
+    {
+        NodeMapSpan<const Type> s = { data(), data() + pv.size() };
+        return s;
+    }
+
+    iterator begin() { return pv.begin(); }
+    const_iterator begin() const { return pv.begin(); }
+    iterator end() { return pv.end(); }
+    const_iterator end() const { return pv.end(); }
+
+    unsigned size() const
+    {
+        return static_cast<unsigned>(pv.size());
+    }
+
+    bool empty() const
+    {
+        return pv.empty();
+    }
+
+    // the new values are initialized to value
+    void resize(unsigned n_elems, const Type &value = Type())
+    {
+        pv.resize(n_elems, value);
+    }
+
+    // sets all the values to value
+    void fill(const Type &value)
+    {
+        std::fill(pv.begin(), pv.end(), value);
+    }
+
+    // replaces every value x by op(x)
+    template<typename Operation>
+    void transform(Operation op)
+    {
+        std::transform(pv.begin(), pv.end(), pv.begin(), op);
+    }
+
+    // sets all the values to Type()
+    void clearValues()
+    {
+        fill(Type());
+    }
+
+    void clear()
+    {
+        pv.clear();
+    }
+
+    friend std::ostream& operator<<(std::ostream &o, const NodeMap<Type> &m)
+    {
+        return o << m.print();
+    }
+
+    std::string print() const
+    {
+        std::ostringstream oss;
+        for (unsigned i = 0; i < pv.size(); i++)
+        {
+            oss << pv[i] << ";\t";
+        }
+        return oss.str();
+    }
+
+protected:
+
+    std::vector<Type> pv;
+};
+
+#endif // NODEMAP_H
@@ -24,9 +24,11 @@
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <new>
+#include <algorithm>
+#include <utility>
 
 #include "../utils/AnError.h"
-#include "../reconcilation/BeepVector.h"
 #include "Tree.h"
 #include "Node.h"
 #include "TreeIO.h"
@@ -39,27 +41,198 @@ Tree::Tree() :
     noOfNodes(0),
     noOfLeaves(0),
     rootNode(0),
+    names(),
     name2node(),
     all_nodes(DEF_NODE_VEC_SIZE, 0),
     name("Tree"),
-    times(0),
-    lengths(0),
-    rates(0),
-    topTime(0)
+    times(),
+    lengths(),
+    rates(),
+    topTime(0),
+    topology_version(0),
+    frozen(false),
+    aggregates_built(static_cast<unsigned long>(-1)),
+    leaf_count(),
+    max_path(),
+    leaf_begin(),
+    leaf_order(),
+    retired_leaf_orders(),
+    node_blocks()
 {
 }
 
 Tree::~Tree()
 {
-    if(rootNode)
-    {
-        rootNode->deleteSubtree();
-        delete rootNode;
-    }
+    releaseNodes();
     rootNode = 0;
     clearNodeAttributes();
 }
 
+Tree::Tree(const Tree &T) :
+    noOfNodes(0),
+    noOfLeaves(0),
+    rootNode(0),
+    names(),
+    name2node(),
+    all_nodes(),
+    name(),
+    times(),
+    lengths(),
+    rates(),
+    topTime(0),
+    topology_version(0),
+    frozen(false),
+    aggregates_built(static_cast<unsigned long>(-1)),
+    leaf_count(),
+    max_path(),
+    leaf_begin(),
+    leaf_order(),
+    retired_leaf_orders(),
+    node_blocks()
+{
+    copyTree(T);
+}
+
+Tree&
+Tree::operator=(const Tree &T)
+{
+    if (this != &T)
+    {
+        clearTree();
+        clearNodeAttributes();
+        copyTree(T);
+    }
+    return *this;
+}
+
+namespace
+{
+    // Moves the node pointers of a tree into its copy, the copy holds the
+    // blocks of the source one after the other
+    class NodeRemap
+    {
+    public:
+        NodeRemap(Node *b) : base(b), blocks() {}
+
+        void addBlock(const Node *first, unsigned used, unsigned offset)
+        {
+            blocks.push_back(Block(first, used, offset));
+        }
+
+        void sort()
+        {
+            std::sort(blocks.begin(), blocks.end());
+        }
+
+        Node* operator()(const Node *v) const
+        {
+            if (v == 0)
+            {
+                return 0;
+            }
+            // the last block starting at or before v
+            std::vector<Block>::const_iterator it =
+                    std::upper_bound(blocks.begin(), blocks.end(), Block(v, 0, 0));
+            assert(it != blocks.begin());
+            --it;
+            assert(v < it->first + it->used);
+            return base + it->offset + (v - it->first);
+        }
+
+    private:
+        struct Block
+        {
+            Block(const Node *f, unsigned u, unsigned o) : first(f), used(u), offset(o) {}
+            bool operator<(const Block &b) const { return std::less<const Node*>()(first, b.first); }
+            const Node *first;
+            unsigned used;
+            unsigned offset;
+        };
+
+        Node *base;
+        std::vector<Block> blocks;
+    };
+}
+
+// this has no nodes when called, but may have an empty block left by clear()
+void
+Tree::copyTree(const Tree &T)
+{
+    unsigned total = 0;
+    for (std::vector<NodeBlock>::const_iterator it = T.node_blocks.begin();
+         it != T.node_blocks.end(); ++it)
+    {
+        total += it->used;
+    }
+    // a cleared tree may still have an empty block that is large enough
+    if (total > 0 && (node_blocks.empty() || node_blocks.back().capacity < total))
+    {
+        releaseNodes();
+        addNodeBlock(total);
+    }
+    NodeBlock *block = total > 0 ? &node_blocks.back() : 0;
+    NodeRemap remap(block ? block->nodes : 0);
+    for (std::vector<NodeBlock>::const_iterator it = T.node_blocks.begin();
+         it != T.node_blocks.end(); ++it)
+    {
+        // reserved blocks may have no nodes yet, and then there may be no
+        // block to copy to
+        if (it->used == 0)
+        {
+            continue;
+        }
+        remap.addBlock(it->nodes, it->used, block->used);
+        for (unsigned i = 0; i < it->used; i++)
+        {
+            new (block->nodes + block->used) Node(it->nodes[i]);
+            block->used++;
+        }
+    }
+    remap.sort();
+    for (unsigned i = 0; i < total; i++)
+    {
+        Node *v = block->nodes + i;
+        v->parent = remap(v->parent);
+        v->leftChild = remap(v->leftChild);
+        v->rightChild = remap(v->rightChild);
+        v->ownerTree = this;
+    }
+
+    noOfNodes = T.noOfNodes;
+    noOfLeaves = T.noOfLeaves;
+    rootNode = remap(T.rootNode);
+    names = T.names;
+    name2node.resize(T.name2node.size());
+    for (unsigned i = 0; i < T.name2node.size(); i++)
+    {
+        name2node[i] = remap(T.name2node[i]);
+    }
+    all_nodes.resize(T.all_nodes.size());
+    for (unsigned i = 0; i < T.all_nodes.size(); i++)
+    {
+        all_nodes[i] = remap(T.all_nodes[i]);
+    }
+    name = T.name;
+
+    times = T.times;
+    lengths = T.lengths;
+    rates = T.rates;
+    topTime = T.topTime;
+    topology_version = T.topology_version;
+    frozen = false;
+
+    aggregates_built = T.aggregates_built;
+    leaf_count = T.leaf_count;
+    max_path = T.max_path;
+    leaf_begin = T.leaf_begin;
+    leaf_order.resize(T.leaf_order.size());
+    for (unsigned i = 0; i < T.leaf_order.size(); i++)
+    {
+        leaf_order[i] = remap(T.leaf_order[i]);
+    }
+    retired_leaf_orders.clear();
+}
+
 string
 Tree::getName() const
 {
@@ -99,13 +272,22 @@ Tree::getHeight() const
 bool
 Tree::IDnumbersAreSane(Node& n) const
 {
-    bool ret = n.getNumber() < getNumberOfNodes();
-    if(n.isLeaf() == false)
+    std::vector<Node*> stack(1, &n);
+    while (!stack.empty())
     {
-        ret = ret && IDnumbersAreSane(*n.getLeftChild()) &&
-                IDnumbersAreSane(*n.getRightChild());
+        Node *v = stack.back();
+        stack.pop_back();
+        if (v->getNumber() >= getNumberOfNodes())
+        {
+            return false;
+        }
+        if (v->isLeaf() == false)
+        {
+            stack.push_back(v->getRightChild());
+            stack.push_back(v->getLeftChild());
+        }
     }
-    return ret;
+    return true;
 }
 
 // delete and remove all nodes from tree
@@ -129,6 +311,7 @@ Tree::setRootNode(Node *v)
 {
     assert(v!=0);
     assert(v->getNumber()<all_nodes.size());
+    topologyChanged();
     rootNode = v;
 }
 
@@ -150,15 +333,14 @@ Tree::getNode(unsigned no) const
 Node*
 Tree::findNode(const string& name) const
 {
-    if(name2node.count(name) > 0)
-    {
-        map<string, Node*>::const_iterator iter = name2node.find(name);
-        return iter->second;
-    }
-    else
-    {
-        return 0;
-    }
+    const unsigned id = names.find(name);
+    return id == NameTable::NO_NAME ? 0 : name2node[id];
+}
+
+const NameTable&
+Tree::getNames() const
+{
+    return names;
 }
 
 // Accessing leaves from a name
@@ -186,18 +368,16 @@ Tree::addNode(Node *leftChild,
 {
     assert(leftChild==0 || leftChild->getNumber()<all_nodes.size());
     assert(rightChild==0 || rightChild->getNumber()<all_nodes.size());
+    topologyChanged();
     noOfNodes++;
     if (leftChild == 0 && rightChild == 0)
     {
         noOfLeaves++;
     }
 
-    Node *v = new Node(node_id, name);
-    v->setTree(*this);
-    v->setChildren(leftChild, rightChild);
-    while(all_nodes.size() <= node_id)
+    if(all_nodes.size() <= node_id)
     {
-        all_nodes.resize(2 * all_nodes.size(), 0);
+        all_nodes.resize(MAX(2 * all_nodes.size(), node_id + 1), 0);
     }
     if(all_nodes[node_id] != 0)
     {
@@ -206,30 +386,24 @@ Tree::addNode(Node *leftChild,
         throw AnError("There seems to be two nodes with the same id!",
                       id_str.str(), 1);
     }
+
+    Node *v = new (allocateNode()) Node(node_id, name);
+    v->setTree(*this);
+    v->setChildren(leftChild, rightChild);
     all_nodes[node_id] = v;
-    name2node.insert(pair<string, Node*>(name, v));
+    if(names.intern(name) == name2node.size())
+    {
+        name2node.push_back(v);
+    }
     return v;
 }
 
 void
 Tree::clearNodeAttributes()
 {
-    if (times != 0)
-    {
-        delete times;
-    }
-    times = 0;
-    if (rates != 0)  // rates is owned by EdgeRateModel
-    {
-        delete rates;
-    }
-    rates = 0;
-    if (lengths != 0)
-    {
-        delete lengths;
-        
-    }
-    lengths = 0;
+    times.clear();
+    rates.clear();
+    lengths.clear();
     topTime = 0;
 }
 
@@ -243,6 +417,139 @@ Tree::addNode(Node *leftChild,
     return addNode(leftChild, rightChild, getNumberOfNodes(), name);
 }
 
+// Makes sure that the next n nodes added to the tree are placed in
+// the same block and that all_nodes does not need to grow for them
+void
+Tree::reserveNodes(unsigned n)
+{
+    if(n == 0)
+    {
+        return;
+    }
+    if(all_nodes.size() < noOfNodes + n)
+    {
+        all_nodes.resize(noOfNodes + n, 0);
+    }
+    names.reserve(names.size() + n);
+    name2node.reserve(names.size() + n);
+    if(!node_blocks.empty())
+    {
+        const NodeBlock &last = node_blocks.back();
+        if(last.capacity - last.used >= n)
+        {
+            return;
+        }
+    }
+    addNodeBlock(n);
+}
+
+void
+Tree::topologyChanged()
+{
+    if (frozen)
+    {
+        throw AnError("The topology of a frozen tree can not be changed",
+                      "Tree::topologyChanged");
+    }
+    topology_version++;
+}
+
+unsigned long
+Tree::getTopologyVersion() const
+{
+    return topology_version;
+}
+
+void
+Tree::freeze()
+{
+    buildIndices();
+    for (unsigned i = 0; i < all_nodes.size(); i++)
+    {
+        if (all_nodes[i] != 0)
+        {
+            buildAggregates(*all_nodes[i]);
+        }
+    }
+    frozen = true;
+}
+
+void
+Tree::thaw()
+{
+    frozen = false;
+}
+
+bool
+Tree::isFrozen() const
+{
+    return frozen;
+}
+
+void
+Tree::buildIndices() const
+{
+}
+
+void
+Tree::addNodeBlock(unsigned capacity)
+{
+    NodeBlock block;
+    block.nodes = static_cast<Node*>(::operator new(capacity * sizeof(Node)));
+    block.capacity = capacity;
+    block.used = 0;
+    node_blocks.push_back(block);
+}
+
+Node*
+Tree::allocateNode()
+{
+    if(node_blocks.empty() || node_blocks.back().used == node_blocks.back().capacity)
+    {
+        // the blocks grow geometrically when the size of the tree is unknown
+        unsigned capacity = DEF_NODE_VEC_SIZE;
+        if(!node_blocks.empty())
+        {
+            capacity = MAX(capacity, 2 * node_blocks.back().capacity);
+        }
+        addNodeBlock(capacity);
+    }
+    NodeBlock &block = node_blocks.back();
+    return block.nodes + block.used++;
+}
+
+void
+Tree::releaseNodes(bool keep_largest)
+{
+    NodeBlock kept;
+    kept.nodes = 0;
+    kept.capacity = 0;
+    kept.used = 0;
+    for(std::vector<NodeBlock>::iterator it = node_blocks.begin();
+        it != node_blocks.end(); ++it)
+    {
+        for(unsigned i = 0; i < it->used; i++)
+        {
+            it->nodes[i].~Node();
+        }
+        if(keep_largest && it->capacity > kept.capacity)
+        {
+            ::operator delete(kept.nodes);
+            kept = *it;
+            kept.used = 0;
+        }
+        else
+        {
+            ::operator delete(it->nodes);
+        }
+    }
+    node_blocks.clear();
+    if(kept.nodes != 0)
+    {
+        node_blocks.push_back(kept);
+    }
+}
+
 // MRCA gets most recent common ancestor of two speciesNodes
 Node* 
 Tree::mostRecentCommonAncestor(Node* a, Node* b) const
@@ -268,26 +575,26 @@ Tree::mostRecentCommonAncestor(Node* a, Node* b) const
 bool
 Tree::hasTimes() const
 {
-    return times != 0;
+    return !times.empty();
 }
 
 bool
 Tree::hasRates() const
 {
-    return rates != 0;
+    return !rates.empty();
 }
 
 bool
 Tree::hasLengths() const
 {
-    return lengths != 0;
+    return !lengths.empty();
 }
 
 // Gets the node time of node v
 double
 Tree::getTime(const Node& v) const
 {
-    return (*times)[v];
+    return times[v];
 }
 
 // Gets the node time of node v
@@ -300,7 +607,7 @@ Tree::getEdgeTime(const Node& v) const
     }
     else
     {
-        return (*times)[v.getParent()] - (*times)[v];
+        return times[v.getParent()] - times[v];
     }
 }
 
@@ -323,17 +630,25 @@ Tree::getTopToLeafTime() const
 bool
 Tree::checkTimeSanity(Node& root) const
 {
-    Node& left = *root.getLeftChild();
-    Node& right = *root.getRightChild();
-
-    if(getTime(left) > getTime(right) || getTime(right) > getTime(left))
+    std::vector<Node*> stack(1, &root);
+    while (!stack.empty())
     {
-        return false;
-    }
-    else
-    {
-        return checkTimeSanity(left) && checkTimeSanity(right);
+        Node *v = stack.back();
+        stack.pop_back();
+        if (v->isLeaf())
+        {
+            continue;
+        }
+        Node& left = *v->getLeftChild();
+        Node& right = *v->getRightChild();
+        if(getTime(left) > getTime(right) || getTime(right) > getTime(left))
+        {
+            return false;
+        }
+        stack.push_back(&right);
+        stack.push_back(&left);
     }
+    return true;
 }
 
 // access and manipulate TopTime
@@ -353,20 +668,20 @@ Tree::setTopTime(double newTime)
 double
 Tree::getLength(const Node& v) const
 {
-    return (*lengths)[v];
+    return lengths[v];
 }
 
 // Gets the rate of node v
 double
 Tree::getRate(const Node& v) const
 {
-    if(rates->size() == 1)
+    if(rates.size() == 1)
     {
-        return (*rates)[0u];
+        return rates[0u];
     }
     else
     {
-        return (*rates)[v];
+        return rates[v];
     }
 }
 
@@ -374,17 +689,17 @@ Tree::getRate(const Node& v) const
 void
 Tree::setTimeNoAssert(const Node& v, double time) const
 {
-    (*times)[v] = time;
+    times[v] = time;
 }
 
 // Sets the divergence time of node v
 void
 Tree::setTime(const Node& v, double time) const
 {
-    (*times)[v] = time;
-    assert(v.isLeaf() || (*times)[v] >= (*times)[v.getLeftChild()]);
-    assert(v.isLeaf() || (*times)[v] >= (*times)[v.getRightChild()]);
-    assert(v.isRoot() || (*times)[v.getParent()] >= (*times)[v]);
+    times[v] = time;
+    assert(v.isLeaf() || times[v] >= times[v.getLeftChild()]);
+    assert(v.isLeaf() || times[v] >= times[v.getRightChild()]);
+    assert(v.isRoot() || times[v.getParent()] >= times[v]);
 }
 
 // Sets the edge time of node v
@@ -397,9 +712,9 @@ Tree::setEdgeTime(const Node& v, double time) const
     }
     else
     {
-        (*times)[v] = (*times)[v.getParent()] - time;
-        assert((*times)[v] > (*times)[v.getLeftChild()]);
-        assert((*times)[v] > (*times)[v.getRightChild()]);
+        times[v] = times[v.getParent()] - time;
+        assert(times[v] > times[v.getLeftChild()]);
+        assert(times[v] > times[v.getRightChild()]);
     }
 }
 
@@ -414,76 +729,61 @@ Tree::setLength(const Node& v, double weight) const
     if(v.isRoot() == false && v.getParent()->isRoot())
     {
         Node& s = *v.getSibling();
-        weight = (weight + (*lengths)[s])/2;
-        (*lengths)[s] = weight;
+        weight = (weight + lengths[s])/2;
+        lengths[s] = weight;
     }
-    (*lengths)[v] = weight;
+    lengths[v] = weight;
 }
 
 // Sets the rate of node v
 void
 Tree::setRate(const Node& v, double rate) const
 {
-    if(rates->size() == 1)
+    if(rates.size() == 1)
     {
-        (*rates)[0u] = rate;
+        rates[0u] = rate;
     }
     else
     {
-        (*rates)[v] = rate;
+        rates[v] = rate;
     }
 }
 
 // Handle to time, lengths and rates
-const RealVector&
+const NodeMap<double>&
 Tree::getTimes() const
 {
-    return *times;
+    return times;
 }
 
-const RealVector&
+const NodeMap<double>&
 Tree::getRates() const
 {
-    return *rates;
+    return rates;
 }
 
-const RealVector&
+const NodeMap<double>&
 Tree::getLengths() const
 {
-    return *lengths;
+    return lengths;
 }
 
 void
-Tree::setTimes(RealVector& v)
+Tree::setTimes(const NodeMap<double>& v)
 {
-    if(times)
-    {
-        delete times;
-        times = 0;
-    }
-    times = &v;
+    times = v;
 }
 
 void
-Tree::setRates(RealVector& v)
+Tree::setRates(const NodeMap<double>& v)
 {
-    if(rates)
-    {
-        delete rates;
-        rates = 0;
-    }
-    rates = &v;
+    rates = v;
 }
 
 void
-Tree::setLengths(RealVector& v)
+Tree::setLengths(const NodeMap<double>& v)
 {
-    if(lengths)
-    {
-        delete lengths;
-        lengths = 0;
-    }
-    lengths = &v;
+    lengths = v;
 }
 
 double Tree::imbalance() const
@@ -497,35 +797,40 @@ double Tree::imbalance() const
 void
 Tree::clearTree()
 {
-    if(rootNode != 0)
-    {
-        rootNode->deleteSubtree();
-        delete rootNode;
-        rootNode = 0;
-    }
+    topologyChanged();
+    releaseNodes(true);
+    rootNode = 0;
     noOfNodes = noOfLeaves = 0;
+    names.clear();
     name2node.clear();
     all_nodes.clear();
     all_nodes = std::vector<Node*>(DEF_NODE_VEC_SIZE, 0);
 }
 
+// The times are not part of the cached aggregates, the subtree is walked
+// with an explicit stack
 double
 Tree::imbalance(Node *v) const
 {
-    if (v->isLeaf())
+    double ret = 0;
+    std::vector<Node*> stack(1, v);
+    while (!stack.empty())
     {
-        return 0;
-    }
-    else
-    {
-        Node *l = v->getLeftChild();
-        Node *r = v->getRightChild();
+        Node *u = stack.back();
+        stack.pop_back();
+        if (u->isLeaf())
+        {
+            continue;
+        }
+        Node *l = u->getLeftChild();
+        Node *r = u->getRightChild();
         const double my_imbalance = fabs(l->getNodeTime() + l->getTime() -
                                  r->getNodeTime() - r->getTime());
-        const double l_imbalance = imbalance(l);
-        const double r_imbalance = imbalance(r);
-        return MAX(my_imbalance, MAX(l_imbalance, r_imbalance));
+        ret = MAX(ret, my_imbalance);
+        stack.push_back(r);
+        stack.push_back(l);
     }
+    return ret;
 }
 
 unsigned
@@ -534,6 +839,110 @@ Tree::getHeight(Node* v) const
     if (v == 0)
         return 0;
     else
-        return 1 + max(getHeight(v->getLeftChild()),
-                       getHeight(v->getRightChild()));
+        return 1 + getMaxPathToLeaf(*v);
+}
+
+unsigned
+Tree::getNumberOfLeaves(const Node &v) const
+{
+    buildAggregates(v);
+    return leaf_count[v.getNumber()];
+}
+
+unsigned
+Tree::getMaxPathToLeaf(const Node &v) const
+{
+    buildAggregates(v);
+    return max_path[v.getNumber()];
+}
+
+NodeSpan
+Tree::getLeaves(const Node &v) const
+{
+    buildAggregates(v);
+    NodeSpan span;
+    span.first = leaf_order.data() + leaf_begin[v.getNumber()];
+    span.last = span.first + leaf_count[v.getNumber()];
+    return span;
+}
+
+// The aggregates of the whole tree are built at once, a node that is not
+// reachable from the root (a tree under construction) gets its subtree
+// added on demand
+void
+Tree::buildAggregates(const Node &v) const
+{
+    if (aggregates_built != topology_version)
+    {
+        leaf_count.assign(all_nodes.size(), 0);
+        max_path.assign(all_nodes.size(), 0);
+        leaf_begin.assign(all_nodes.size(), 0);
+        leaf_order.clear();
+        leaf_order.reserve(noOfLeaves);
+        retired_leaf_orders.clear();
+        if (rootNode != 0)
+        {
+            addAggregates(rootNode);
+        }
+        aggregates_built = topology_version;
+    }
+    if (v.getNumber() >= leaf_count.size() || leaf_count[v.getNumber()] == 0)
+    {
+        // The leaves of a subtree are appended again each time a node above
+        // it is added, so there is no final size to reserve. A subtree has
+        // at most noOfLeaves leaves; if they may not fit, the order is moved
+        // to a larger vector and the old one is kept for its spans.
+        if (leaf_order.capacity() - leaf_order.size() < noOfLeaves)
+        {
+            std::vector<Node*> grown;
+            grown.reserve(2 * leaf_order.size() + noOfLeaves);
+            grown.assign(leaf_order.begin(), leaf_order.end());
+            retired_leaf_orders.push_back(std::vector<Node*>());
+            retired_leaf_orders.back().swap(leaf_order);
+            leaf_order.swap(grown);
+        }
+        addAggregates(const_cast<Node*>(&v));
+    }
+}
+
+// One depth first pass with an explicit stack, a node is pushed twice so
+// that its aggregates are computed after those of its children
+void
+Tree::addAggregates(Node *from) const
+{
+    std::vector<std::pair<Node*, bool> > stack(1, std::make_pair(from, false));
+    while (!stack.empty())
+    {
+        Node *v = stack.back().first;
+        const bool children_done = stack.back().second;
+        stack.pop_back();
+        const unsigned id = v->getNumber();
+        if (id >= leaf_count.size())
+        {
+            leaf_count.resize(id + 1, 0);
+            max_path.resize(id + 1, 0);
+            leaf_begin.resize(id + 1, 0);
+        }
+        if (v->isLeaf())
+        {
+            leaf_begin[id] = leaf_order.size();
+            leaf_count[id] = 1;
+            max_path[id] = 0;
+            leaf_order.push_back(v);
+        }
+        else if (!children_done)
+        {
+            stack.push_back(std::make_pair(v, true));
+            stack.push_back(std::make_pair(v->getRightChild(), false));
+            stack.push_back(std::make_pair(v->getLeftChild(), false));
+        }
+        else
+        {
+            const unsigned l = v->getLeftChild()->getNumber();
+            const unsigned r = v->getRightChild()->getNumber();
+            leaf_begin[id] = leaf_begin[l];
+            leaf_count[id] = leaf_count[l] + leaf_count[r];
+            max_path[id] = 1 + MAX(max_path[l], max_path[r]);
+        }
+    }
 }
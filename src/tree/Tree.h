@@ -27,13 +27,35 @@
 #include <string>
 #include <vector>
 
+#include "../utils/NameTable.h"
+#include "NodeMap.h"
+
 // Forward declarations.
 class Node;
-class RealVector;
 using namespace std;
 
 const unsigned DEF_NODE_VEC_SIZE = 100;
 
+// A run of consecutive nodes, Tree::getLeaves() returns the leaves of a
+// subtree this way without copying them.
+struct NodeSpan
+{
+    Node * const *first;
+    Node * const *last;
+
+    Node * const *begin() const { return first; }
+    Node * const *end() const { return last; }
+    unsigned size() const { return static_cast<unsigned>(last - first); }
+    Node* operator[](unsigned i) const { return first[i]; }
+};
+
+// The nodes of a tree are stored in blocks owned by the tree (the node arena),
+// a block is never moved so the Node pointers handed out by addNode() remain
+// valid until the tree is cleared or destroyed. reserveNodes() with the number
+// of nodes of the tree makes the whole tree one contiguous block. Clearing a
+// tree keeps its largest block, so a tree that is rebuilt or assigned to
+// after clear() reuses it.
+
 class Tree 
 {
 public:
@@ -41,6 +63,13 @@ public:
     explicit Tree();
     virtual ~Tree();
 
+    // The copy gets its own nodes in one block of the arena, they are copied
+    // block by block from the source and their pointers are moved by the
+    // offset of the block they point into. The cached aggregates are copied
+    // as they are, the copy is never frozen.
+    Tree(const Tree &T);
+    Tree& operator=(const Tree &T);
+
     std::string getName() const;
     void setName(const string &s);
 
@@ -54,10 +83,31 @@ public:
     Node* findLeaf(const std::string& name) const;
     Node* findNode(const std::string& name) const;
 
+    // the names of the nodes as they were given to addNode(), the id of a
+    // name indexes the node returned by findNode()
+    const NameTable& getNames() const;
+
     Node* addNode(Node *leftChild, Node *rightChild, unsigned id, const string &name = "");
     Node* addNode(Node *leftChild,  Node *rightChild, const string &name = "");
     void setRootNode(Node *r);
 
+    // makes room for n more nodes in the node arena
+    void reserveNodes(unsigned n);
+
+    // called by Node when the children or the parent of a node change, the
+    // version is used by the derived classes to know when the indices they
+    // build from the nodes have to be rebuilt
+    void topologyChanged();
+    unsigned long getTopologyVersion() const;
+
+    // A frozen tree does not change: freeze() builds all the cached indices
+    // at once and from then on the const functions only read the tree, so
+    // one tree can be shared by several threads without locks. Changing the
+    // topology of a frozen tree throws AnError until thaw() is called.
+    void freeze();
+    void thaw();
+    bool isFrozen() const;
+
     /* annoying methods I want to get rid of */
     bool hasTimes() const;
     bool hasRates() const;
@@ -71,12 +121,12 @@ public:
     void setEdgeTime(const Node& v, double time) const;
     void setLength(const Node& v, double weight)const;
     void setRate(const Node& v, double rate)const;
-    const RealVector& getTimes() const;
-    const RealVector& getRates() const;
-    const RealVector& getLengths() const;
-    void setTimes(RealVector& v);
-    void setRates(RealVector& v);
-    void setLengths(RealVector& v);
+    const NodeMap<double>& getTimes() const;
+    const NodeMap<double>& getRates() const;
+    const NodeMap<double>& getLengths() const;
+    void setTimes(const NodeMap<double>& v);
+    void setRates(const NodeMap<double>& v);
+    void setLengths(const NodeMap<double>& v);
     bool checkTimeSanity(Node& root) const;
     double getTopTime() const;
     void setTopTime(double newTime);
@@ -90,23 +140,71 @@ public:
     double imbalance(Node *v) const;
     unsigned getHeight(Node* v) const;
 
+    // Subtree aggregates. They are filled for every node by one postorder
+    // pass and kept until the topology changes. The leaves of a subtree are
+    // consecutive in the left to right order of the leaves of the tree, a
+    // span returned by getLeaves() stays valid until the topology changes.
+    unsigned getNumberOfLeaves(const Node &v) const;
+    unsigned getMaxPathToLeaf(const Node &v) const;
+    NodeSpan getLeaves(const Node &v) const;
+
     void clear();
     void clearTree();
     void clearNodeAttributes();
 
 protected:
 
+    // builds the indices of the derived classes, called by freeze()
+    virtual void buildIndices() const;
+
     unsigned noOfNodes;
     unsigned noOfLeaves;
     Node *rootNode;
-    std::map<std::string, Node*> name2node;
+    NameTable names;
+    std::vector<Node*> name2node;  // indexed by name id, the first node with the name
     std::vector<Node*> all_nodes;
     std::string name;
 
-    mutable RealVector* times;
-    mutable RealVector* lengths;
-    mutable RealVector* rates;
+    // empty when the tree has no times, lengths or rates
+    mutable NodeMap<double> times;
+    mutable NodeMap<double> lengths;
+    mutable NodeMap<double> rates;
     mutable double topTime;
+    unsigned long topology_version;
+    bool frozen;
+
+private:
+
+    struct NodeBlock
+    {
+        Node *nodes;
+        unsigned capacity;
+        unsigned used;
+    };
+
+    void addNodeBlock(unsigned capacity);
+    void copyTree(const Tree &T);
+    void buildAggregates(const Node &v) const;
+    void addAggregates(Node *from) const;
+
+    mutable unsigned long aggregates_built; // topology version of the aggregates
+    mutable std::vector<unsigned> leaf_count;
+    mutable std::vector<unsigned> max_path;
+    mutable std::vector<unsigned> leaf_begin; // first leaf of the subtree in leaf_order
+    mutable std::vector<Node*> leaf_order;
+    // leaf orders outgrown by the subtrees added on demand, kept so that the
+    // spans into them stay valid until the topology changes
+    mutable std::vector<std::vector<Node*> > retired_leaf_orders;
+
+    // returns uninitialized storage for one node from the arena
+    Node* allocateNode();
+    // destroys all the nodes and releases the arena blocks, except the
+    // largest one if keep_largest is set, which is left empty for reuse.
+    // A Node owns its name, so the nodes are still destroyed one by one
+    // and this is linear in the number of nodes.
+    void releaseNodes(bool keep_largest = false);
+
+    std::vector<NodeBlock> node_blocks;
 };
 
 #endif
@@ -0,0 +1,615 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+#include "TreeBuilder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "Node.h"
+#include "Treeextended.h"
+#include "../utils/AnError.h"
+
+namespace
+{
+    // the bits of the tags in TreeBuilder::Pending::tags, in the order of
+    // the enum
+    const char *tag_names[] =
+    {
+        "NW", "ET", "NT", "BL", "AC", "S", "ID", "NAME", "TT", "HY", "EX", "OP", 0
+    };
+
+    inline bool given(const NodeMap<double> &values, const Node *v)
+    {
+        return !values.empty() && !std::isnan(values[v]);
+    }
+
+    // the lengths are bounded as Tree::setLength() does, but the edges
+    // below the root are not averaged, as the reader never did
+    inline double boundedLength(double length)
+    {
+        return std::max(length, 2 * std::numeric_limits<double>::min());
+    }
+
+    // the first node of the subtree of v in postorder
+    inline Node* firstInPostorder(Node *v)
+    {
+        while (!v->isLeaf())
+        {
+            v = v->getLeftChild();
+        }
+        return v;
+    }
+}
+
+TreeBuilder::TreeBuilder(bool build)
+    : tags(),
+      build(build),
+      trees(0),
+      pending(),
+      has_pending(false),
+      subtrees(),
+      built()
+{
+    tags.setNW(true);
+    tags.setET(true);
+    tags.setNT(true);
+    tags.setBL(true);
+    tags.setGS(true);
+    tags.setAC(false);
+    tags.setHY(false);
+}
+
+TreeBuilder::~TreeBuilder()
+{
+    for (std::deque<BuiltTree>::iterator it = built.begin(); it != built.end(); ++it)
+    {
+        delete it->tree;
+    }
+}
+
+TreeExtended* TreeBuilder::takeTree(const TreeIOTraits &traits,
+                                    std::vector<SetOfNodesEx<Node> > *AC,
+                                    StrStrMap *gs)
+{
+    if (built.empty() || !built.front().complete)
+    {
+        return 0;
+    }
+    TreeExtended *tree = built.front().tree;
+    try
+    {
+        setValues(built.front(), traits, AC, gs);
+    }
+    catch (...)
+    {
+        delete tree;
+        built.pop_front();
+        throw;
+    }
+    built.pop_front();
+    return tree;
+}
+
+void TreeBuilder::getTags(TreeIOTraits &traits) const
+{
+    traits.setNW(tags.hasNW());
+    traits.setET(tags.hasET());
+    traits.setNT(tags.hasNT());
+    traits.setBL(tags.hasBL());
+    traits.setGS(tags.hasGS());
+    traits.setAC(tags.hasAC());
+    traits.setHY(tags.hasHY());
+}
+
+unsigned TreeBuilder::getNumberOfTrees() const
+{
+    return trees;
+}
+
+void TreeBuilder::beginTree(unsigned nodes)
+{
+    has_pending = false;
+    subtrees.clear();
+    // a tree whose parsing failed
+    if (!built.empty() && !built.back().complete)
+    {
+        delete built.back().tree;
+        built.pop_back();
+    }
+    if (!build)
+    {
+        return;
+    }
+
+    built.push_back(BuiltTree());
+    BuiltTree &b = built.back();
+    b.tree = new TreeExtended();
+    b.tree->reserveNodes(nodes);
+    b.nodes = nodes;
+    b.top_time = 0.0;
+    b.has_top_time = false;
+    b.complete = false;
+}
+
+unsigned TreeBuilder::addLeaf(const NHXString &name)
+{
+    Pending p = Pending();
+    p.name = name;
+    p.leaf = true;
+    return open(p);
+}
+
+unsigned TreeBuilder::addInner(unsigned left, unsigned right)
+{
+    // the children are the last two subtrees
+    close(false);
+    assert(subtrees.size() >= 2);
+    assert(left == subtrees.size() - 2 && right == subtrees.size() - 1);
+    (void)left;
+    (void)right;
+
+    Pending p = Pending();
+    p.left = subtrees[subtrees.size() - 2];
+    p.right = subtrees.back();
+    p.leaf = false;
+    subtrees.resize(subtrees.size() - 2);
+    return open(p);
+}
+
+void TreeBuilder::setName(unsigned v, const NHXString &name)
+{
+    assert(has_pending && v == subtrees.size() - 1);
+    (void)v;
+    pending.name = name;
+}
+
+void TreeBuilder::addAnnotation(unsigned v, const NHXAnnotation &a, const int *values)
+{
+    assert(has_pending && v == subtrees.size() - 1);
+    (void)v;
+    unsigned tag = 0;
+    while (tag_names[tag] != 0 && !(a.tag == tag_names[tag]))
+    {
+        tag++;
+    }
+    if (tag_names[tag] == 0)
+    {
+        return;
+    }
+
+    Pending &p = pending;
+    p.tags |= 1u << tag;
+    switch (1u << tag)
+    {
+    case tagNW:
+        p.weight = a.number;
+        break;
+    case tagET:
+        p.edge_time = a.number;
+        break;
+    case tagNT:
+        p.node_time = a.number;
+        break;
+    case tagBL:
+        p.length = a.number;
+        break;
+    case tagAC:
+        if (build)
+        {
+            std::vector<int> &integers = built.back().integers;
+            p.ac_first = static_cast<unsigned>(integers.size());
+            p.ac_size = a.size;
+            integers.insert(integers.end(), values, values + a.size);
+        }
+        break;
+    case tagS:
+        p.species = a.text;
+        break;
+    case tagID:
+        p.id = a.integer;
+        break;
+    case tagNAME:
+        p.tree_name = a.text;
+        break;
+    case tagTT:
+        p.top_time = a.number;
+        break;
+    default:
+        break;
+    }
+}
+
+void TreeBuilder::endTree(unsigned root)
+{
+    assert(root == 0 && subtrees.size() == 1);
+    (void)root;
+    close(true);
+    trees++;
+    if (!build)
+    {
+        return;
+    }
+
+    BuiltTree &b = built.back();
+    Node *r = subtrees.back();
+    if(pending.tags & tagNAME)
+    {
+        b.tree->setName(pending.tree_name.str());
+    }
+    b.top_time = pending.top_time;
+    b.has_top_time = (pending.tags & tagTT) != 0;
+
+    if(b.tree->IDnumbersAreSane(*r) == false)
+    {
+        throw AnError("There are higher ID-numbers than there are nodes in tree", "TreeIO::readBeepTree");
+    }
+
+    b.tree->setRootNode(r);
+    b.complete = true;
+}
+
+unsigned TreeBuilder::open(const Pending &p)
+{
+    if (has_pending)
+    {
+        close(false);
+    }
+    pending = p;
+    has_pending = true;
+    subtrees.push_back(0);
+    return static_cast<unsigned>(subtrees.size()) - 1;
+}
+
+void TreeBuilder::close(bool root)
+{
+    assert(has_pending);
+    has_pending = false;
+    checkTags(pending, root);
+    if (build)
+    {
+        subtrees.back() = createNode(pending);
+    }
+}
+
+// Checks what tags are given for the node p
+// Precondition: All bool argument has proper values. Assume a specific
+// bool argument, 'A' has incoming value 'a', and the value for the
+// current node is 'b', then on return, A = a && b.
+void TreeBuilder::checkTags(const Pending &p, bool root)
+{
+    // Determine if NW is given
+    if(!(p.tags & tagNW) && !root)
+    {
+        tags.setNW(false);
+    }
+
+    // Determine if ET is given
+    if(!(p.tags & tagET) && !root)
+    {
+        tags.setET(false);
+    }
+
+    // Check if NT is given
+    if(!(p.tags & tagNT) && !p.leaf)
+    {
+        tags.setNT(false);
+    }
+
+    // Check if BL is given
+    if(!(p.tags & tagBL) && !root)
+    {
+        tags.setBL(false);
+    }
+
+    // Check if AC is given.
+    if(p.tags & tagAC)
+    {
+        tags.setAC(true);
+    }
+
+    // Check if GS is given for leaves.
+    if(p.leaf && !(p.tags & tagS))
+    {
+        tags.setGS(false);
+    }
+
+    // Check if there are hybrid annotations
+    if(p.tags & (tagHY | tagEX | tagOP))
+    {
+        tags.setHY(true);
+    }
+}
+
+// The children of p were created before it, so the tree is built in
+// postorder. The values of the tags are kept for setValues()
+Node* TreeBuilder::createNode(const Pending &p)
+{
+    BuiltTree &b = built.back();
+    TreeExtended *tree = b.tree;
+
+    // Always include name, if it exists
+    std::string name;
+    if(!p.name.empty())
+    {
+        name = p.name.str();
+    }
+    else if(p.tags & tagS)
+    {
+        name = p.species.str();
+    }
+
+    Node *new_node;
+    if(p.tags & tagID)
+    {
+        if(p.id < 0 || static_cast<unsigned>(p.id) >= b.nodes)
+        {
+            throw AnError("There are higher ID-numbers than there are nodes in tree", "TreeIO::readBeepTree");
+        }
+        // We must have ID to be able to give HY, which gives
+        // the other parent of a hybrid child
+        if(tree->getNode(p.id) != 0)
+        {
+            if(p.tags & tagHY)
+            {
+                throw AnError("This is a HybridTree. Please use "
+                              "readHybridTree instead",
+                              "TreeBuilder::createNode",
+                              1);
+            }
+            ostringstream oss;
+            oss << "TreeBuilder::createNode\n"
+                << "Found duplicate ID for non-hybrid node "
+                << p.id << endl;
+            throw AnError(oss.str(),1);
+        }
+        new_node = tree->addNode(p.left, p.right, p.id, name);
+    }
+    else
+    {
+        new_node = tree->addNode(p.left, p.right, name);
+    }
+    assert(new_node != 0 && new_node->getNumber() < b.nodes);
+
+    if(p.tags & tagNW)
+    {
+        storeValue(b.weights, new_node, p.weight);
+    }
+    if(p.tags & tagET)
+    {
+        storeValue(b.edge_times, new_node, p.edge_time);
+    }
+    if(p.tags & tagNT)
+    {
+        storeValue(b.node_times, new_node, p.node_time);
+    }
+    if(p.tags & tagBL)
+    {
+        storeValue(b.lengths, new_node, p.length);
+    }
+    if(p.leaf && (p.tags & tagS))
+    {
+        b.species.push_back(std::make_pair(new_node, p.species));
+    }
+    if(p.tags & tagAC)
+    {
+        const Antichains ac = { new_node, p.ac_first, p.ac_size };
+        b.antichains.push_back(ac);
+    }
+
+    if(p.tags & tagEX)
+    {
+        throw AnError("TreeBuilder::createNode\n"
+                      "Please use readHybridTree",1);
+    }
+    return new_node;
+}
+
+void TreeBuilder::storeValue(NodeMap<double> &values, const Node *v, double value)
+{
+    if (values.empty())
+    {
+        values.resize(built.back().nodes, std::numeric_limits<double>::quiet_NaN());
+    }
+    values[v] = value;
+}
+
+void TreeBuilder::setValues(const BuiltTree &b, const TreeIOTraits &traits,
+                            std::vector<SetOfNodesEx<Node> > *AC, StrStrMap *gs) const
+{
+    TreeExtended &tree = *b.tree;
+
+    // Create NodeMaps to hold required 'tag' info
+    NodeMap<double> times;
+    NodeMap<double> lengths;
+    if(traits.hasET() || traits.hasNT() ||
+            (traits.hasNW() && traits.hasNWisET()))
+    {
+        times.resize(b.nodes, 0.0);
+    }
+    const bool use_lengths = traits.hasBL() || (traits.hasNW() && traits.hasNWisET() == false);
+    if(use_lengths)
+    {
+        lengths.resize(b.nodes, 0.0);
+    }
+    const NodeMap<double> &edge_times = traits.hasNWisET() ? b.weights : b.edge_times;
+    double top_time = 0.0;
+
+    // the nodes in postorder, following the parents from the first leaf
+    Node *root = tree.getRootNode();
+    for(Node *v = firstInPostorder(root); v != 0;
+        v = v == root ? 0 : (v == v->getParent()->getLeftChild()
+                             ? firstInPostorder(v->getParent()->getRightChild())
+                             : v->getParent()))
+    {
+        const bool is_root = v == root;
+
+        // Handle the various rules for how to set the time over an edge
+        if(traits.hasET())
+        {
+            double edge_time = 0.0;
+            if(given(edge_times, v))
+            {
+                edge_time = edge_times[v];
+            }
+            else if(!is_root)
+            {
+                throw AnError("Edge without edge time found in tree.", 1);
+            }
+
+            // Check for sanity
+            if(edge_time < 0)
+            {
+                throw AnError("Tree contains an edge with negative time",1);
+            }
+            else if(edge_time == 0 && !is_root)
+            {
+                throw AnError("Tree contains an edge with zero time.", 1);
+            }
+
+            // the time of v by each of its subtrees
+            if(!v->isLeaf())
+            {
+                const Node *l = v->getLeftChild();
+                const Node *r = v->getRightChild();
+                const double left_time = times[l] + edge_times[l];
+                const double right_time = times[r] + edge_times[r];
+                if ((2 * std::abs(left_time - right_time) / (left_time + right_time)) >= 0.01)
+                {
+                    ostringstream oss;
+                    oss << "Tree time inconsistency at node  "
+                        << v->getNumber()
+                        <<"\nAccording to left subtree, node time is "
+                       << left_time
+                       << " but right subtree says it should be "
+                       << right_time
+                       << ".\n";
+                    throw AnError("TreeBuilder::setValues: " +
+                                  oss.str());
+                }
+                times[v] = left_time;
+            }
+            top_time = edge_time;
+        }
+
+        // Check if any existing info about node time should be used
+        // Note that we don't allow using both ET and NT
+        if(traits.hasNT())
+        {
+            // check for sanity - we only need one time measure!
+            if(traits.hasET())
+            {
+                throw AnError("Superfluous time measure, use either ET or NT, "
+                              "but not both");
+            }
+            if(given(b.node_times, v))
+            {
+                times[v] = b.node_times[v];
+            }
+            else
+            {
+                throw AnError("Edge without node time found in tree.", 1);
+            }
+        }
+
+        // Check if any existing branchLength should be used
+        if(use_lengths)
+        {
+            if(given(b.lengths, v))
+            {
+                lengths[v] = boundedLength(b.lengths[v]);
+            }
+            else if(traits.hasNWisET())
+            {
+                throw AnError("TreeBuilder::setValues:\n"
+                              "No branch length info found either in 'BL' and 'NW' is used for 'ET'",
+                              234);
+            }
+            else if(given(b.weights, v))
+            {
+                lengths[v] = boundedLength(b.weights[v]);
+            }
+            else if(!is_root)
+            {
+                throw AnError("TreeBuilder::setValues:\n"
+                              "No branch length info found either in 'BL' or 'NW'",
+                              234);
+            }
+        }
+    }
+
+    if(!times.empty())
+    {
+        tree.setTimes(times);
+    }
+    if(traits.hasET())
+    {
+        tree.setTopTime(top_time);
+    }
+    if(traits.hasNT() && b.has_top_time)
+    {
+        tree.setTopTime(b.top_time);
+    }
+    if(use_lengths)
+    {
+        tree.setLengths(lengths);
+    }
+
+    //Associate gene and species names
+    if(gs != 0)
+    {
+        for(unsigned i = 0; i < b.species.size(); i++)
+        {
+            gs->insert(b.species[i].first->getName(), b.species[i].second.str());
+        }
+    }
+
+    // get antichain (gamma) info if requested
+    if(AC != 0)
+    {
+        if(AC->empty()) // if elements is not allocated in AC do so!
+        {
+            AC->resize(100); // Warning arbitrary default size
+        }
+        for(unsigned i = 0; i < b.antichains.size(); i++)
+        {
+            const Antichains &ac = b.antichains[i];
+            for(unsigned j = ac.first; j < ac.first + ac.size; j++)
+            {
+                const int x = b.integers[j];
+                if(x < 0)
+                {
+                    throw AnError("Negative node number in the antichain of node",
+                                  ac.node->getName(), 1);
+                }
+                if(static_cast<unsigned>(x) >= AC->size())
+                {
+                    AC->resize(x + 1);
+                }
+                (*AC)[x].insert(ac.node);
+            }
+        }
+    }
+}
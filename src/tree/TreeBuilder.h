@@ -0,0 +1,181 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+/* TreeBuilder creates a TreeExtended from the events of NHXParser, there is
+ * no intermediate tree. The parser gives the name and the annotations of a
+ * node right after the node, so the values of the tags TreeIO reads are kept
+ * in a single pending record and the node is created when the parser moves
+ * on to the next node, or to the end of the tree for the root. The nodes are
+ * thus created in postorder, numbered as the recursive reader numbered them.
+ * The subtrees that have no parent yet are kept on a stack. The node arena
+ * is sized from the number of nodes the parser counted.
+ *
+ * Which tags give the times and the lengths depends on the tags all the
+ * nodes have (see TreeIOTraits), which is only known at the end. So while a
+ * tree is read its tags are checked as TreeIO::checkTagsForTree() describes
+ * and their values are kept by node number; takeTree() then sets the times
+ * and the lengths in one pass over the tree. A tree is thus parsed once.
+ * The builder made with build set to false only checks the tags. */
+
+#ifndef TREEBUILDER_H
+#define TREEBUILDER_H
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "../parser/NHXParser.h"
+#include "../reconcilation/StrStrMap.h"
+#include "../reconcilation/SetOfNodesEx.h"
+#include "NodeMap.h"
+#include "TreeIOTraits.h"
+
+class Node;
+class TreeExtended;
+
+using namespace std;
+
+class TreeBuilder : public NHXSink
+{
+
+public:
+
+    // constructor, with build false the trees are not built
+    explicit TreeBuilder(bool build = true);
+    // deletes the trees that were not taken
+    virtual ~TreeBuilder();
+
+    // the first tree built that was not taken yet, 0 if there is none. Its
+    // times and lengths are set from the tags as traits tells, and the
+    // antichains and the gene species map are read into AC and gs if they
+    // are not 0. Throws AnError if the tags do not give what traits asks
+    // for, the tree is then deleted. The caller owns the tree.
+    TreeExtended* takeTree(const TreeIOTraits &traits,
+                           std::vector<SetOfNodesEx<Node> > *AC = 0,
+                           StrStrMap *gs = 0);
+
+    // the tags NW, ET, NT, BL, AC, GS and HY are set in traits as
+    // TreeIO::checkTagsForTree() does for all the trees read so far
+    void getTags(TreeIOTraits &traits) const;
+
+    // number of trees read so far
+    unsigned getNumberOfTrees() const;
+
+    // NHXSink
+    virtual void beginTree(unsigned nodes);
+    virtual unsigned addLeaf(const NHXString &name);
+    virtual unsigned addInner(unsigned left, unsigned right);
+    virtual void setName(unsigned v, const NHXString &name);
+    virtual void addAnnotation(unsigned v, const NHXAnnotation &a, const int *values);
+    virtual void endTree(unsigned root);
+
+private:
+
+    // the tags given for a node
+    enum Tags
+    {
+        tagNW = 1 << 0,
+        tagET = 1 << 1,
+        tagNT = 1 << 2,
+        tagBL = 1 << 3,
+        tagAC = 1 << 4,
+        tagS = 1 << 5,
+        tagID = 1 << 6,
+        tagNAME = 1 << 7,
+        tagTT = 1 << 8,
+        tagHY = 1 << 9,
+        tagEX = 1 << 10,
+        tagOP = 1 << 11
+    };
+
+    // the node that was read last and is not created yet, the last value
+    // of a tag is the one kept
+    struct Pending
+    {
+        NHXString name;
+        NHXString species;     // S
+        NHXString tree_name;   // NAME
+        Node *left;
+        Node *right;
+        int id;
+        double weight;         // NW
+        double edge_time;      // ET
+        double node_time;      // NT
+        double length;         // BL
+        double top_time;       // TT
+        unsigned ac_first;     // the antichains in BuiltTree::integers
+        unsigned ac_size;
+        unsigned tags;
+        bool leaf;
+    };
+
+    // the antichains of a node
+    struct Antichains
+    {
+        Node *node;
+        unsigned first;
+        unsigned size;
+    };
+
+    // a tree built and the values of its tags by node number, NaN where a
+    // node lacks the tag; the map of a tag no node has is empty
+    struct BuiltTree
+    {
+        TreeExtended *tree;
+        unsigned nodes;
+        NodeMap<double> weights;       // NW
+        NodeMap<double> edge_times;    // ET
+        NodeMap<double> node_times;    // NT
+        NodeMap<double> lengths;       // BL
+        std::vector<std::pair<Node*, NHXString> > species;   // S of the leaves
+        std::vector<Antichains> antichains;
+        std::vector<int> integers;
+        double top_time;               // TT of the root
+        bool has_top_time;
+        bool complete;
+    };
+
+    TreeBuilder(const TreeBuilder &);
+    TreeBuilder& operator=(const TreeBuilder &);
+
+    // starts the pending node, returns its handle
+    unsigned open(const Pending &p);
+    // checks the tags of the pending node and creates it
+    void close(bool root);
+    void checkTags(const Pending &p, bool root);
+    Node* createNode(const Pending &p);
+    void storeValue(NodeMap<double> &values, const Node *v, double value);
+    // sets the times and lengths of the tree, its antichains and gene
+    // species map, in postorder
+    void setValues(const BuiltTree &b, const TreeIOTraits &traits,
+                   std::vector<SetOfNodesEx<Node> > *AC, StrStrMap *gs) const;
+
+    TreeIOTraits tags;       // the tags found in the trees
+    bool build;
+    unsigned trees;
+    Pending pending;
+    bool has_pending;
+    std::vector<Node*> subtrees;
+    std::deque<BuiltTree> built;
+};
+
+#endif // TREEBUILDER_H
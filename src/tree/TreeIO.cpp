@@ -22,10 +22,11 @@
  */
 
 #include "TreeIO.h"
+#include "TreeBuilder.h"
+#include "../utils/InputFile.h"
 
 #include <cassert>		// For early bug detection
 #include <iostream>
-#include <fstream>
 #include <sstream>
 #include <string>
 #include <map>
@@ -36,12 +37,14 @@ using namespace std;
 
 TreeIO::TreeIO()
     : source(readFromStdin),
-      stringThatWasPreviouslyNamedS("")
+      stringThatWasPreviouslyNamedS(""),
+      input()
 {}
 
 TreeIO::TreeIO(enum TreeSource source, const std::string &s)
     : source(source),
-      stringThatWasPreviouslyNamedS(s)
+      stringThatWasPreviouslyNamedS(s),
+      input()
 {}
 
 TreeIO::~TreeIO()
@@ -73,6 +76,7 @@ TreeIO::setSourceFile(const std::string &filename)
 {
     source = readFromFile;
     stringThatWasPreviouslyNamedS = filename;
+    input.reset();
 }
 
 void
@@ -80,6 +84,7 @@ TreeIO::setSourceString(const std::string &str)
 {
     source = readFromString;
     stringThatWasPreviouslyNamedS = str;
+    input.reset();
 }
 
 // Map leaves in the gene tree to leaves in the species tree
@@ -87,88 +92,88 @@ TreeIO::setSourceString(const std::string &str)
 // probably get its own class! /arve
 // Expected line format: 
 // <whitespace>? <gene name> <whitespace> <species name> <whitespace>?
-// Line length is at most 1024 chars.
+// The names are taken straight from the file contents, which are mapped
+// in memory when possible.
 StrStrMap
 TreeIO::readGeneSpeciesInfo(const std::string &filename)
 {
-    ifstream is(filename.c_str());
+    InputFile file(filename);
+    const char *position = file.begin();
+    const char *end = file.end();
     unsigned lineno = 1;
 
     StrStrMap gene2species;
-    if(is.peek() == '#') // gs may start with a '#'
+    if (position != end && *position == '#') // gs may start with a '#'
     {
-        char dummy[LINELENGTH];
-        is.getline(dummy, LINELENGTH);// >> dummy;
+        InputFile::skipLine(position, end);
     }
 
-    while (is.good())
+    const char *gene;
+    size_t gene_length;
+    while (InputFile::nextWord(position, end, gene, gene_length))
     {
-        std::string gene = std::string();
-        std::string species = std::string();
-        if (is >> gene)
+        const char *species;
+        size_t species_length;
+        if (!InputFile::nextWord(position, end, species, species_length))
         {
-            if (is >> species)
-            {
-                gene2species.insert(gene, species);
-            }
-            else
-            {
-                std::ostringstream line_str;
-                line_str << "Line " << lineno;
-                is.close();
-                throw AnError("The gene-to-species mapping seems to be "
-                              "badly formatted. ", line_str.str());
-            }
+            std::ostringstream line_str;
+            line_str << "Line " << lineno;
+            throw AnError("The gene-to-species mapping seems to be "
+                          "badly formatted. ", line_str.str());
         }
+        gene2species.insert(std::string(gene, gene_length),
+                            std::string(species, species_length));
         lineno++;
     }
-    is.close();
     return gene2species;
 }
 
+// Every map starts with a line holding a single '#', only the first two
+// words of each of the other lines are read.
 std::vector<StrStrMap>
 TreeIO::readGeneSpeciesInfoVector(const std::string &filename)
 {
-    ifstream is(filename.c_str());
+    InputFile file(filename);
+    const char *position = file.begin();
+    const char *end = file.end();
     unsigned lineno = 1;
     std::vector<StrStrMap> gene2speciesVec;
     StrStrMap gene2species;
-    std::string gsmark;
-    is >> gsmark;
-    if(gsmark != "#")
+
+    const char *gene;
+    size_t gene_length;
+    if (!InputFile::nextWord(position, end, gene, gene_length)
+            || gene_length != 1 || *gene != '#')
     {
         throw AnError("error in gs vector, every gs must be preceeded by '#' line\n");
     }
 
-    while (is.good())
+    for (;;)
     {
-        char dummy[LINELENGTH];
-        is.getline(dummy, LINELENGTH);
-        std::string gene;
-        std::string species;
-        if (is >> gene)
+        InputFile::skipLine(position, end);
+        if (!InputFile::nextWord(position, end, gene, gene_length))
         {
-            if(gene == "#")
-            {
-                gene2speciesVec.push_back(gene2species);
-                gene2species.clearMap();
-            }
-            else
+            break;
+        }
+        if (gene_length == 1 && *gene == '#')
+        {
+            gene2speciesVec.push_back(gene2species);
+            gene2species.clearMap();
+        }
+        else
+        {
+            const char *species;
+            size_t species_length;
+            if (!InputFile::nextWord(position, end, species, species_length))
             {
-                if (is >> species)
-                {
-                    gene2species.insert(gene, species);
-                }
-                else
-                {
-                    std::ostringstream line_str;
-                    line_str << "(Line " << lineno << ")";
-                    throw AnError("The gene-to-species mapping seems to be "
-                                  "badly formatted. ", line_str.str());
-                }
+                std::ostringstream line_str;
+                line_str << "(Line " << lineno << ")";
+                throw AnError("The gene-to-species mapping seems to be "
+                              "badly formatted. ", line_str.str());
             }
+            gene2species.insert(std::string(gene, gene_length),
+                                std::string(species, species_length));
         }
-        
         lineno++;
     }
     gene2speciesVec.push_back(gene2species);
@@ -177,20 +182,16 @@ TreeIO::readGeneSpeciesInfoVector(const std::string &filename)
 
 TreeExtended* TreeIO::readHostTree()
 {
+    TreeBuilder builder;
+    readFirstTree(builder);
     TreeIOTraits traits;
-    checkTagsForTree(traits);
-    NHXtree *t = readTree();
+    builder.getTags(traits);
     if(traits.containsTimeInformation() == false)
     {
         throw AnError("Host tree lacks time information for some of it nodes", 1);
     }
     traits.enforceHostTree();
-    std::vector<SetOfNodesEx<Node> > *AC = 0;
-    StrStrMap *gs = 0;
-    TreeExtended *tree = readBeepTree(t, traits, AC, gs);
-    delete_trees(t);
-    t = 0;
-    return tree;
+    return builder.takeTree(traits);
 }
 
 TreeExtended* TreeIO::readGuestTree()
@@ -202,19 +203,53 @@ TreeExtended* TreeIO::readGuestTree()
 
 TreeExtended* TreeIO::readNewickTree()
 {
+    TreeBuilder builder;
+    readFirstTree(builder);
     TreeIOTraits traits;
-    checkTagsForTree(traits);
-    NHXtree *t = readTree();
+    builder.getTags(traits);
     traits.setET(false);
     traits.setNT(false);
     traits.setBL(traits.hasNW());
     traits.setNWisET(false);
-    std::vector<SetOfNodesEx<Node> > *AC = 0;
-    StrStrMap *gs = 0;
-    TreeExtended *tree = readBeepTree(t, traits, AC, gs);
-    delete_trees(t);
-    t = 0;
-    return tree;
+    return builder.takeTree(traits);
+}
+
+std::vector<TreeExtended*> TreeIO::readAllNewickTrees()
+{
+    // the traits hold for all the trees, so they are set once all are read
+    TreeBuilder builder;
+    NHXParser parser = makeParser();
+    while (parser.next(builder))
+    {
+
+    }
+    if (builder.getNumberOfTrees() == 0)
+    {
+        throw AnError("No tree found!");
+    }
+    TreeIOTraits traits;
+    builder.getTags(traits);
+    traits.setET(false);
+    traits.setNT(false);
+    traits.setBL(traits.hasNW());
+    traits.setNWisET(false);
+    std::vector<TreeExtended*> trees;
+    try
+    {
+        while (TreeExtended *tree = builder.takeTree(traits))
+        {
+            trees.push_back(tree);
+        }
+    }
+    catch (...)
+    {
+        for (unsigned i = 0; i < trees.size(); i++)
+        {
+            delete trees[i];
+        }
+        throw;
+    }
+    return trees;
 }
 
 std::string TreeIO::writeBeepTree(const TreeExtended &G,const TreeIOTraits& traits,const GammaMapEx* gamma)
@@ -263,10 +298,12 @@ std::string TreeIO::writeBeepTree(const TreeExtended& G, const GammaMapEx *gamma
 
 TreeExtended* TreeIO::readBeepTree(std::vector<SetOfNodesEx<Node> > *AC, StrStrMap *gs)
 {
+    TreeBuilder builder;
+    readFirstTree(builder);
     TreeIOTraits traits;
-    checkTagsForTree(traits);
+    builder.getTags(traits);
     traits.enforceStandardSanity();
-    return readBeepTree(traits, AC, gs);
+    return builder.takeTree(traits, AC, gs);
 }
 
 std::string TreeIO::writeGuestTree(const TreeExtended& G, const GammaMapEx* gamma)
@@ -283,23 +320,17 @@ std::string TreeIO::writeGuestTree(const TreeExtended& G, const GammaMapEx* gamm
 TreeExtended* TreeIO::readBeepTree(const TreeIOTraits& tr, std::vector<SetOfNodesEx<Node> > *AC,
                                   StrStrMap *gs)
 {
-    NHXtree* t = readTree();
-    if (t == 0)
-    {
-        throw AnError("No tree found!");
-    }
-
-    TreeExtended *tree = readBeepTree(t, tr, AC, gs);
-    delete_trees(t);
-    t = 0;
-    return tree;
+    TreeBuilder builder;
+    readFirstTree(builder);
+    return builder.takeTree(tr, AC, gs);
 }
 
 TreeExtended* TreeIO::readGuestTree(std::vector<SetOfNodesEx<Node> >* AC, StrStrMap* gs)
 {
+    TreeBuilder builder;
+    readFirstTree(builder);
     TreeIOTraits traits;
-    checkTagsForTree(traits);
-    NHXtree *t = readTree();
+    builder.getTags(traits);
     if(traits.hasGS() == false)
     {
         gs = 0;
@@ -309,695 +340,246 @@ TreeExtended* TreeIO::readGuestTree(std::vector<SetOfNodesEx<Node> >* AC, StrStr
         AC = 0;
     }
     traits.enforceGuestTree();
-    TreeExtended *tree = readBeepTree(t, traits, AC, gs);
-    delete_trees(t);
-    t = 0;
-    return tree;
+    return builder.takeTree(traits, AC, gs);
 }
 
 void TreeIO::checkTagsForTree(TreeIOTraits &traits)
 {
-    // Reset all argmuents before starting
-    traits.setNW(true);
-    traits.setET(true);
-    traits.setNT(true);
-    traits.setBL(true);
-    traits.setGS(true);
-    traits.setAC(false);
-    traits.setHY(false);
-
-    // Parse tree from its source, into temporary datastructure
-    NHXtree* t = readTree();
-    if (t == 0)
+    // Parse the trees from their source, only collecting the tags
+    TreeBuilder checker(false);
+    NHXParser parser = makeParser();
+    while (parser.next(checker))
     {
-        throw AnError("The input tree is 0!",
-                      "TreeIO::checkTagsForTree()",
-                      1);
-    }
-
-    while(t)
-    {
-        if(recursivelyCheckTags(t->root, traits) == false)
-        {
-            throw AnError("The input tree was empty!",
-                          "TreeIO::checkTagsForTree()",
-                          1);
-        }
-        t = t->next;
-    }
-
-    delete_trees(t);
-    t = 0;
-}
-
-// Find the right value for edge time
-double
-TreeIO::decideEdgeTime(const NHXnode *v, const TreeIOTraits& traits, bool isHY) const
-{
-    double edge_time = 0.0;
-
-    //NHX_debug_print(const_cast<NHXnode*>(v));
-
-    if(traits.hasET()) // Use edge time info from file
-    {
-        if(traits.hasNWisET())
-        {
-            NHXannotation* a = find_annotation(v, "NW");
-            if(a != 0)
-            {
-                edge_time = a->arg.t;
-            }
-            else if (isRoot(v))
-            {
-                edge_time = 0.0;
-            }
-            else
-            {
-                throw AnError("Edge without edge time found in tree.", 1);
-            }
-        }
-        else
-        {
-            NHXannotation *a = find_annotation(v, "ET");
-            if(a != 0)
-            {
-                edge_time = a->arg.t;
-            }
-            else if (isRoot(v))
-            {
-                edge_time = 0.0;
-            }
-            else
-            {
-                throw AnError("Edge without edge time found in tree.", 1);
-            }
-
-        }
 
-        // Check for sanity
-        if(edge_time <= 0)
-        {
-
-            if(edge_time < 0)
-            {
-                throw AnError("Tree contains an edge with negative time",1);
-            }
-            else if(isHY == false && !(bool)isRoot(v))
-            {
-                throw AnError("Tree contains an edge with zero time.", 1);
-            }
-        }
-    }
-
-    return edge_time;
-}
-
-// Always include name , if it exists
-std::string
-TreeIO::decideNodeName(const NHXnode *v)
-{
-    std::string name = "";		// Default name is empty
-    if (v->name)		// Leaf names are always inserted into 'name'
-    {
-        name = v->name;
     }
-    else			// Inner nodes might have a name. Go check
+    if (checker.getNumberOfTrees() == 0)
     {
-        NHXannotation *a = find_annotation(v, "S");
-        if (a)			// Great, we found it
-        {
-            name = a->arg.str;	// Pick string from union 'arg'
-        }
+        throw AnError("The input tree is 0!",
+                      "TreeIO::checkTagsForTree()",
+                      1);
     }
-    return name;
+    checker.getTags(traits);
 }
 
+// Generic reading functions, interfacing the NHX parser. The readers
+// parse the first tree once, its tags are collected while it is built.
 void
-TreeIO::handleBranchLengths(Node *node, const NHXnode *v, bool NWIsET)
+TreeIO::readFirstTree(TreeBuilder &builder)
 {
-    if(NHXannotation *a = find_annotation(v, "BL"))
+    NHXParser parser = makeParser();
+    if (parser.next(builder) == false)
     {
-        node->setLength(a->arg.t);
-    }
-    else if(NWIsET)
-    {
-        throw AnError("TreeIO::extendBeepTree(...):\n"
-                      "No branch length info found either in 'BL' and 'NW' is used for 'ET'",
-                      234);
-    }
-    else if(NHXannotation *a = find_annotation(v, "NW"))
-    {
-        node->setLength(a->arg.t);
-    }
-    else if (v->parent)		// If not root...
-    {
-        throw AnError("TreeIO::extendBeepTree(...):\n"
-                      "No branch length info found either in 'BL' or 'NW'",
-                      234);
-    }
-}
-
-// Recursively checks what tags are given for all nodes in subtree T_v
-// Precondition: All bool argument has proper values. Assume a specific
-// bool argument, 'A' has incoming value 'a', and the value for the 
-// current subtree is 'b', then on return, A = a && b, i.e., false if 
-// either a or b is false.
-// postcondition: return true if subtree is non-empty, i.e, v != 0
-bool TreeIO::recursivelyCheckTags(const NHXnode* v, TreeIOTraits& traits)
-{
-    if (v == 0) // i.e. if the parent was not a leaf
-    {
-        return false;
+        throw AnError("No tree found!");
     }
-
-    recursivelyCheckTags(v->left, traits);
-    recursivelyCheckTags(v->right, traits);
-    checkTags(v, traits);
-    return true;
 }
 
-
-// Checks what tags are given for node v
-// Precondition: All bool argument has proper values. Assume a specific
-// bool argument, 'A' has incoming value 'a', and the value for the 
-// current node is 'b', then on return, A = a && b.
-void
-TreeIO::checkTags(const NHXnode *v, TreeIOTraits& traits) const
+NHXParser
+TreeIO::makeParser()
 {
-    // Determine if NW is given
-    if(find_annotation(v, "NW") == 0 && !isRoot(v))
-    {
-        traits.setNW(false);
-    }
-
-    // Determine if ET is given
-    if(find_annotation(v, "ET") == 0 && !isRoot(v))
-    {
-        traits.setET(false);
-    }
-
-    // Check if NT is given
-    if(find_annotation(v, "NT") == 0 && !isLeaf(v))
+    if (source == readFromString)
     {
-        traits.setNT(false);
+        const std::string &s = stringThatWasPreviouslyNamedS;
+        return NHXParser(s.data(), s.data() + s.size());
     }
-
-    // Check if BL is given
-    if(find_annotation(v, "BL") == 0 && !isRoot(v))
-    {
-        traits.setBL(false);
-    }
-
-    // Check if AC is given.
-    if(find_annotation(v, "AC"))
-    {
-        traits.setAC(true);
-    }
-
-    // Check if GS is given for leaves.
-    if (v->left == 0 && v->right == 0 && speciesName(v) == 0)
+    else if (source != readFromStdin && source != readFromFile)
     {
-        traits.setGS(false);
+        throw AnError("TreeIO not properly initialized!");
     }
 
-    // Check if there are hybrid annotations
-    if(find_annotation(v, "HY") || find_annotation(v, "EX") ||
-            find_annotation(v, "OP"))
+    if (!input)
     {
-        traits.setHY(true);
+        input.reset(source == readFromStdin ? new InputFile()
+                                            : new InputFile(stringThatWasPreviouslyNamedS));
     }
+    return NHXParser(input->begin(), input->end(), input->getName());
 }
 
-
-// Generic reading function, interfacing NHX* code
-NHXtree*
-TreeIO::readTree()
+// Basic helper functions for writing trees in PRIME format. The subtrees
+// are ordered by the order map, the least leaf name is used otherwise.
+std::string
+TreeIO::recursivelyWriteBeepTree(Node &u,
+                                 std::map<Node *, string> least,
+                                 const TreeIOTraits& traits,
+                                 const GammaMapEx* gamma,
+                                 std::map<const Node*,Node*>* otherParent,
+                                 std::map<const Node*,unsigned>* extinct,
+                                 std::map<unsigned, unsigned>* id)
 {
-    if (source == readFromStdin)
-    {
-        return read_tree(0);
-    }
-    else if (source == readFromFile)
-    {
-        return read_tree(stringThatWasPreviouslyNamedS.c_str());
-    }
-    else if (source == readFromString)
-    {
-        return read_tree_string(stringThatWasPreviouslyNamedS.c_str());
-    }
-    else
-    {
-        throw AnError("TreeIO not properly initialized!");
-        return 0;
-    }
+    std::string least_leaf;
+    return writeBeepSubtree(u, &least, least_leaf, traits, gamma,
+                            otherParent, extinct, id);
 }
 
-// The basic function for reading NHX trees
-TreeExtended* TreeIO::readBeepTree(NHXtree *t, const TreeIOTraits& traits,
-                                  std::vector<SetOfNodesEx<Node> > *AC, StrStrMap *gs)
+std::string
+TreeIO::recursivelyWriteBeepTree(Node &u, std::string& least,
+                                 const TreeIOTraits& traits,
+                                 const GammaMapEx *gamma,
+                                 std::map<const Node*,Node*>* otherParent,
+                                 std::map<const Node*,unsigned>* extinct,
+                                 std::map<unsigned, unsigned>* id)
 {
-    TreeExtended *tree = new TreeExtended();
-    assert(tree);
-    assert(t);
-
-    // Create BeepVectors to hold required 'tag' info
-    if(traits.hasET() || traits.hasNT() ||
-            (traits.hasNW() && traits.hasNWisET()))
-    {
-        RealVector *timevector = new RealVector(treeSize(t));
-        tree->setTimes(*timevector);
-    }
-    if(traits.hasBL()|| (traits.hasNW() && traits.hasNWisET() == false))
-    {
-        RealVector *lengthvector = new RealVector(treeSize(t));
-        tree->setLengths(*lengthvector);
-    }
-
-    // Convert it into our preferred C++ data structure
-    Node *r = extendBeepTree(*tree, t->root, traits, AC, gs, 0, 0);
-    if (r == 0)
-    {
-        throw AnError("The input tree was empty!");
-    }
-
-    NHXannotation *a = find_annotation(t->root, "NAME");
-    if(a != 0)
-    {
-        tree->setName(a->arg.str);
-    }
-
-    if(traits.hasNT())
-    {
-        NHXannotation *a = find_annotation(t->root, "TT");
-        if(a != 0)
-        {
-            tree->setTopTime(a->arg.t);
-        }
-    }
-
-    tree->setRootNode(r);
-
-    if(tree->IDnumbersAreSane(*r) == false)
-    {
-        throw AnError("There are higher ID-numbers than there are nodes in tree", "TreeIO::readBeepTree");
-    }
-
-    return tree;
+    return writeBeepSubtree(u, 0, least, traits, gamma,
+                            otherParent, extinct, id);
 }
 
-// The basic recursion function for reading node info from NHX structs
-
-Node* TreeIO::extendBeepTree(TreeExtended &S,
-                             const NHXnode *v,
-                             const TreeIOTraits& traits,
-                             std::vector<SetOfNodesEx<Node> > *AC,
-                             StrStrMap *gs,
-                             std::map<const Node*, Node*>* otherParent,
-                             std::map<const Node*, unsigned>* extinct)
+void TreeIO::decideSubtreeOrder(Node &u, std::map<Node*, std::string> order)
 {
-    if (v == 0)
+    std::vector<std::pair<Node*, bool> > stack(1, std::make_pair(&u, false));
+    while (!stack.empty())
     {
-        return 0;
-    }
-    else
-    {
-        // First find out if node already exists
-        Node* new_node;
-        NHXannotation* id = find_annotation(v, "ID");
-        const bool hasID = (id != 0);
-        if(hasID)
-        {
-            new_node = S.getNode(id->arg.i);
-
-            // We must have ID to be able to give HY, which gives
-            // the other parent of a hybrid child
-            if(new_node)
-            {
-                NHXannotation* h = find_annotation(v, "HY");
-                if(h != 0)
-                {
-                    if(otherParent)
-                    {
-                        (*otherParent)[new_node] = new_node->getParent();
-                        S.setTopTime(new_node->getTime());
-                        return new_node;
-                    }
-                    else
-                    {
-                        throw AnError("This is a HybridTree. Please use "
-                                      "readHybridTree instead",
-                                      "TreeIO::extendBeepTree",
-                                      1);
-                    }
-                }
-                else
-                {
-                    ostringstream oss;
-                    oss << "TreeIO::extendBeepTree\n"
-                        << "Found duplicate ID for non-hybrid node "
-                        << id->arg.i << endl;
-                    throw AnError(oss.str(),1);
-                }
-            }
-        }
-
-        //Otherwise create new node
-        string name = decideNodeName(v);
-        double leftTime = 0;
-        double rightTime = 0;
-
-        // Pass on recursion -- topTime is used to temporarily store
-        // the edgeTime of a Node, remember to record them in left/rightTime
-        Node* l = extendBeepTree(S, v->left, traits, AC, gs, otherParent, extinct);
-        if(traits.hasET() && l)
-        {
-            leftTime = S.getTopTime() + S.getTime(*l);
-        }
-        Node* r = extendBeepTree(S, v->right, traits, AC, gs, otherParent, extinct);
-        if(traits.hasET() && r)
-        {
-            rightTime = S.getTopTime() + S.getTime(*r);
-        }
-
-        // Now create the new node
-        if(hasID)
-        {
-            new_node = S.addNode(l, r, id->arg.i, name);
-        }
-        else
+        Node *v = stack.back().first;
+        const bool children_done = stack.back().second;
+        stack.pop_back();
+        if(order.find(v) != order.end())
         {
-            new_node =  S.addNode(l, r, name);
+            continue;
         }
-        assert(new_node != 0);
-
-        double edge_time = decideEdgeTime(v, traits, otherParent);
-
-        if(traits.hasET())
-        {
-            if(r && l)
-            {
-                if ((2 * abs(leftTime - rightTime) / (leftTime + rightTime)) >= 0.01)
-                {
-                    ostringstream oss;
-                    oss << "Tree time inconsistency at node  "
-                        << new_node->getNumber()
-                        <<"\nAccording to left subtree, node time is "
-                       << leftTime
-                       << " but right subtree says it should be "
-                       << rightTime
-                       << ".\n";
-                    throw AnError("TreeIO::extendBeepTree: " +
-                                  oss.str());
-                }
-            }
-            S.setTime(*new_node, leftTime);
-            S.setTopTime(edge_time);
-        }
-        //NOTE this is doing S.seTime again
-        sanityCheckOnTimes(S, new_node, v, traits);
-
-        // Check if any existing branchLength should be used
-        if(traits.hasBL() || (traits.hasNW() && traits.hasNWisET() == false))
-        {
-            handleBranchLengths(new_node, v, traits.hasNWisET());
-        }
-
-        //Associate gene and species names
-        if (l == 0 && r == 0 && gs != 0) // If this is a leaf and we want to read gs
-        {
-            if (speciesName(v) != 0)
-            {
-                gs->insert(name, string(speciesName(v)));
-            }
-
-        }
-
-        // get antichain (gamma) info if requested
-        if (AC != 0)
+        else if(v->isLeaf())
         {
-            if(AC->empty()) // if elements is not allocated in AC do so!
-            {
-                AC->resize(100); // Warning arbitrary default size
-            }
-            updateACInfo(v, new_node, *AC);
+            order[v] = v->getName();
         }
-
-        if(find_annotation(v, "EX"))
+        else if(!children_done)
         {
-            if(extinct)
-            {
-                if(new_node->isLeaf() == false)
-                {
-                    throw AnError("TreeIO::extinct node must be a leaf",1);
-                }
-                (*extinct)[new_node] = 1;
-            }
-            else
-            {
-                throw AnError("TreeIO::extendBeepTree\n"
-                              "Please use readHybridTree",1);
-            }
-        }
-        return new_node;
-    }
-}
-
-void TreeIO::sanityCheckOnTimes(TreeExtended &S, Node *node, const NHXnode *v, const TreeIOTraits& traits)
-{
-    // Check if any existing info about node time should be used
-    // Note that we don't allow using both ET and NT
-    if(traits.hasNT())
-    {
-        // check for sanity - we only need one time measure!
-        if(traits.hasET())
-        {
-            throw AnError("Superfluous time measure, use either ET or NT, "
-                          "but not both");
-        }
-        if(NHXannotation *a = find_annotation(v, "NT"))
-        {
-            S.setTime(*node, a->arg.t);
+            stack.push_back(std::make_pair(v, true));
+            stack.push_back(std::make_pair(v->getRightChild(), false));
+            stack.push_back(std::make_pair(v->getLeftChild(), false));
         }
         else
         {
-            throw AnError("Edge without node time found in tree.", 1);
+            order[v] = min(order[v->getLeftChild()], order[v->getRightChild()]);
         }
     }
-
+    return;
 }
 
-// Basic helper function for writing trees in PRIME format
+// The markup of every node is computed in a first postorder pass, in the
+// same order as the ID numbers are handed out, and the newick string is
+// then put together in a second pass. Both passes use an explicit stack.
 std::string
-TreeIO::recursivelyWriteBeepTree(Node &u,
-                                 std::map<Node *, string> least,
-                                 const TreeIOTraits& traits,
-                                 const GammaMapEx* gamma,
-                                 std::map<const Node*,Node*>* otherParent,
-                                 std::map<const Node*,unsigned>* extinct,
-                                 std::map<unsigned, unsigned>* id)
+TreeIO::writeBeepSubtree(Node &u,
+                         const std::map<Node*, std::string> *order,
+                         std::string& least,
+                         const TreeIOTraits& traits,
+                         const GammaMapEx *gamma,
+                         std::map<const Node*,Node*>* otherParent,
+                         std::map<const Node*,unsigned>* extinct,
+                         std::map<unsigned, unsigned>* id)
 {
-    assert((traits.hasID() && id != 0) == false);
-    string ret;
+    assert((traits.hasID() && id) == false);
 
-    // Determine what should be tagged in PRIME markup
-    std::ostringstream tagstr;
-    std::ostringstream NWstr;
+    std::vector<std::string> markup;
+    std::vector<std::string> least_leaf;
+    std::vector<Node*> first_child;
 
-    if(traits.hasID())
+    std::vector<std::pair<Node*, bool> > stack(1, std::make_pair(&u, false));
+    while (!stack.empty())
     {
-        tagstr << " ID=" << u.getNumber();
-    }
-
-    if (traits.hasET())
-    {
-        if (traits.hasNWisET())
+        Node *v = stack.back().first;
+        const bool children_done = stack.back().second;
+        stack.pop_back();
+        const unsigned n = v->getNumber();
+        if (n >= markup.size())
         {
-            NWstr << std::showpoint <<":" << u.getTime();
+            markup.resize(n + 1);
+            least_leaf.resize(n + 1);
+            first_child.resize(n + 1, 0);
         }
-        else
-        {
-            tagstr << " ET=" << std::showpoint << u.getTime();
-        }
-    }
 
-    if (traits.hasNT())
-    {
-        tagstr << " NT=" << u.getNodeTime();
-    }
-
-    if (traits.hasBL())
-    {
-        if (traits.hasNWisET())
-        {
-            tagstr << " BL=" << u.getLength();
-        }
-        else
+        if (v->isLeaf())
         {
-            NWstr << ":" << u.getLength();
+            least_leaf[n] = v->getName();
         }
-    }
-
-    // Now add node in newick format and gamma/AC if requested
-    // This is done differently ifor leaves and internal nodes
-    if (u.isLeaf())  // leaves recursion stops and 'S' is set
-    {
-        if(id != 0)
+        else if (!children_done)
         {
-            if(id->find(u.getNumber()) == id->end())
+            Node *l = v->getLeftChild();
+            Node *r = v->getRightChild();
+            // the subtree written first is also numbered first
+            if (order != 0)
             {
-                unsigned i = id->size();
-                (*id)[u.getNumber()] = i;
+                std::map<Node*, std::string>::const_iterator li = order->find(l);
+                std::map<Node*, std::string>::const_iterator ri = order->find(r);
+                const std::string lo = li == order->end() ? "" : li->second;
+                const std::string ro = ri == order->end() ? "" : ri->second;
+                first_child[n] = lo < ro ? l : r;
             }
-            tagstr << " ID=" << (*id)[u.getNumber()];
+            else
+            {
+                first_child[n] = l;
+            }
+            Node *second = first_child[n] == l ? r : l;
+            stack.push_back(std::make_pair(v, true));
+            stack.push_back(std::make_pair(second, false));
+            stack.push_back(std::make_pair(first_child[n], false));
+            continue;
         }
-
-        // then add gamma to PRIME markup if requested
-        if(gamma)
+        else if (order == 0)
         {
-            Node *species = gamma->getLowestGammaPath(u);
-            // check for consistency
-            if(species)
+            // Always order leaves in as alphabetical order as possible
+            const unsigned l = v->getLeftChild()->getNumber();
+            const unsigned r = v->getRightChild()->getNumber();
+            if (least_leaf[l] < least_leaf[r])
             {
-                // Add species info and AC
-                tagstr << " S=" << species->getName()
-                       << getAntiChainMarkup(u, *gamma);
+                least_leaf[n] = least_leaf[l];
+                first_child[n] = v->getLeftChild();
             }
             else
             {
-                ostringstream err;
-                err << "Cannot write AC, since leaf "
-                    << u.getNumber()
-                    <<" lacks a species";
-                throw AnError(err.str());
+                least_leaf[n] = least_leaf[r];
+                first_child[n] = v->getRightChild();
             }
         }
+        markup[n] = writeNodeMarkup(*v, traits, gamma, otherParent, extinct, id);
     }
-    else   // Internal nodes needs to send recursion on and sets 'D'
+    least = least_leaf[u.getNumber()];
+
+    // A node is opened, its children written with a separator (0) between
+    // them, and then closed with its own markup
+    std::string ret;
+    std::vector<std::pair<Node*, bool> > emit(1, std::make_pair(&u, false));
+    while (!emit.empty())
     {
-        // First get the strings for subtrees
-        // Add node in newick format
-        // Always order leaves in as alphabetical order as possible
-        if(least[u.getLeftChild()] < least[u.getRightChild()])
+        Node *v = emit.back().first;
+        const bool close = emit.back().second;
+        emit.pop_back();
+        if (v == 0)
         {
-            string left_str = recursivelyWriteBeepTree(*u.getLeftChild(),
-                                                       least, traits,
-                                                       gamma, otherParent, extinct, id);
-            string right_str = recursivelyWriteBeepTree(*u.getRightChild(),
-                                                        least, traits,
-                                                        gamma, otherParent, extinct, id);
-            ret = "(" + left_str + ", " + right_str + ")";
+            ret.append(", ");
         }
-        else
+        else if (close)
         {
-            string right_str = recursivelyWriteBeepTree(*u.getRightChild(),
-                                                        least, traits,
-                                                        gamma, otherParent, extinct, id);
-            string left_str = recursivelyWriteBeepTree(*u.getLeftChild(),
-                                                       least, traits,
-                                                       gamma, otherParent, extinct, id);
-            ret = "(" + right_str + ", " + left_str + ")";
+            ret.append(")");
+            ret.append(markup[v->getNumber()]);
         }
-
-        if(id != 0)
+        else if (v->isLeaf())
         {
-            if(id->find(u.getNumber()) == id->end())
-            {
-                unsigned i = id->size();
-                (*id)[u.getNumber()] = i;
-            }
-            tagstr << " ID=" << (*id)[u.getNumber()];
+            ret.append(markup[v->getNumber()]);
         }
-
-        ret.reserve(1024); 	// Avoid too many internal resize (expensive)
-
-
-        // then add gamma/AC to BEEP markup if requested
-        if(gamma)
-        {
-            if(gamma->isSpeciation(u))
-            {
-                tagstr << " D=0";
-            }
-            else
-            {
-                tagstr << " D=1";
-            }
-            tagstr << getAntiChainMarkup(u, *gamma);
-        }
-    }
-
-    if(otherParent && otherParent->find(&u) != otherParent->end())
-    {
-        unsigned pn = u.getParent()->getNumber();
-        unsigned opn = (*otherParent)[&u]->getNumber();
-        if(id != 0)
+        else
         {
-            if(id->find(pn) == id->end())
-            {
-                unsigned i = id->size();
-                (*id)[pn] = i;
-            }
-            if(id->find(opn) == id->end())
-            {
-                unsigned i = id->size();
-                (*id)[opn] = i;
-            }
-        
-            tagstr << " HY=(" << (*id)[pn] << " " << (*id)[opn] << ")";
+            Node *first = first_child[v->getNumber()];
+            Node *second = first == v->getLeftChild() ? v->getRightChild() : v->getLeftChild();
+            ret.append("(");
+            emit.push_back(std::make_pair(v, true));
+            emit.push_back(std::make_pair(second, false));
+            emit.push_back(std::make_pair(static_cast<Node*>(0), false));
+            emit.push_back(std::make_pair(first, false));
         }
     }
-
-    if(extinct && extinct->find(&u) != extinct->end())
-    {
-        tagstr << " EX=1";
-    }
-
-    if(u.getName()!= "")
-    {
-        ret.append(u.getName());
-    }
-
-    ret.append(NWstr.str());
-
-    if(tagstr.str() != "")
-    {
-        ret.append("[&&PRIME" + tagstr.str() + "]");
-    }
-
     return ret;
 }
 
-void TreeIO::decideSubtreeOrder(Node &u, std::map<Node*, std::string> order)
-{
-    if(order.find(&u) != order.end())
-    {
-        return;
-    }
-    else if(u.isLeaf())
-    {
-        order[&u] = u.getName();
-    }
-    else
-    {
-        decideSubtreeOrder(*u.getLeftChild(), order);
-        decideSubtreeOrder(*u.getRightChild(),order);
-        order[&u] = min(order[u.getLeftChild()], order[u.getRightChild()]);
-    }
-    return;
-}
-
+// Name, newick length and PRIME markup of the node u alone
 std::string
-TreeIO::recursivelyWriteBeepTree(Node &u, std::string& least,
-                                 const TreeIOTraits& traits,
-                                 const GammaMapEx *gamma,
-                                 std::map<const Node*,Node*>* otherParent,
-                                 std::map<const Node*,unsigned>* extinct,
-                                 std::map<unsigned, unsigned>* id)
+TreeIO::writeNodeMarkup(Node &u,
+                        const TreeIOTraits& traits,
+                        const GammaMapEx *gamma,
+                        std::map<const Node*,Node*>* otherParent,
+                        std::map<const Node*,unsigned>* extinct,
+                        std::map<unsigned, unsigned>* id)
 {
-    assert((traits.hasID() && id) == false);
     string ret;
 
-    // Determine what should be tagged in PRIME markup´
+    // Determine what should be tagged in PRIME markup
     std::ostringstream tagstr;
     std::ostringstream NWstr;
 
@@ -1035,25 +617,20 @@ TreeIO::recursivelyWriteBeepTree(Node &u, std::string& least,
         }
     }
 
-    // Now add node in newick format and gamma/AC if requested
-    // This is done differently ifor leaves and internal nodes
-    if (u.isLeaf())  // leaves recursion stops and 'S' is set
+    if(id)
     {
-        if(id)
+        if(id->find(u.getNumber()) == id->end())
         {
-            if(id->find(u.getNumber()) == id->end())
-            {
-                unsigned i = id->size();
-                (*id)[u.getNumber()] = i;
-            }
-            tagstr << " ID=" << (*id)[u.getNumber()];
+            unsigned i = id->size();
+            (*id)[u.getNumber()] = i;
         }
+        tagstr << " ID=" << (*id)[u.getNumber()];
+    }
 
-        // add node in newick format
-        // 	ret = least = u.getName();
-        least = u.getName();
-
-        // then add gamma to PRIME markup if requested
+    // Now add gamma/AC if requested
+    // This is done differently ifor leaves and internal nodes
+    if (u.isLeaf())  // 'S' is set for leaves
+    {
         if(gamma)
         {
             Node *species = gamma->getLowestGammaPath(u);
@@ -1074,43 +651,8 @@ TreeIO::recursivelyWriteBeepTree(Node &u, std::string& least,
             }
         }
     }
-    else   // Internal nodes needs to send recursion on and sets 'D'
+    else   // and 'D' for internal nodes
     {
-        // First get the strings for subtrees
-        string least_left;
-        string least_right;
-        string left_str = recursivelyWriteBeepTree(*u.getLeftChild(),
-                                                   least_left, traits,
-                                                   gamma, otherParent, extinct, id);
-        string right_str = recursivelyWriteBeepTree(*u.getRightChild(),
-                                                    least_right, traits,
-                                                    gamma, otherParent, extinct, id);
-        if(id)
-        {
-            if(id->find(u.getNumber()) == id->end())
-            {
-                unsigned i = id->size();
-                (*id)[u.getNumber()] = i;
-            }
-            tagstr << " ID=" << (*id)[u.getNumber()];
-        }
-
-        ret.reserve(1024); 	// Avoid too many internal resize (expensive)
-
-        // Add node in newick format
-        // Always order leaves in as alphabetical order as possible
-        if (least_left < least_right)
-        {
-            least = least_left;
-            ret = "(" + left_str + ", " + right_str + ")";
-        }
-        else
-        {
-            least = least_right;
-            ret = "(" + right_str + ", " + left_str + ")";
-        }
-
-        // then add gamma/AC to BEEP markup if requested
         if(gamma)
         {
             if(gamma->isSpeciation(u))
@@ -1203,18 +745,3 @@ std::string TreeIO::getAntiChainMarkup(Node &u, const GammaMapEx &gamma)
     }
     return ac;
 }
-
-void TreeIO::updateACInfo(const NHXnode *v, Node *new_node,
-                          std::vector<SetOfNodesEx<Node> > &AC)
-{
-    NHXannotation *a = find_annotation(v, "AC");
-    if (a != 0)
-    {
-        int_list *il = a->arg.il;
-        while (il)
-        {
-            AC[il->i].insert(new_node);
-            il = il->next;
-        }
-    }
-}
@@ -24,9 +24,7 @@
 #ifndef TREEIO_HH
 #define TREEIO_HH
 
-#include "../parser/NHXtree.h"
-#include "../parser/NHXnode.h"
-#include "../parser/NHXannotation.h"
+#include "../parser/NHXParser.h"
 #include "../reconcilation/StrStrMap.h"
 #include "../reconcilation/SetOfNodesEx.h"
 #include "../reconcilation/GammaMapEx.h"
@@ -35,13 +33,13 @@
 #include "Node.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
-// The size of a char buffer when reading gene-species info:
-#define LINELENGTH 10000   //1024
-
 class Tree;
+class TreeBuilder;
+class InputFile;
 
 using namespace std;
 
@@ -80,7 +78,9 @@ public:
     void setSourceString(const std::string &str);
 
     // Precheck what tags are present in the read NHX-tree. Since ID,
-    // Names of nodes and trees are always read - these are not checked
+    // Names of nodes and trees are always read - these are not checked.
+    // The readers below do not need it, they check the tags of the tree
+    // while they build it.
     void checkTagsForTree(TreeIOTraits &traits);
 
     // Convenience front to readBeepTree(...)
@@ -105,6 +105,11 @@ public:
     // Reads a plain newick tree with branch lengths from NW only
     TreeExtended* readNewickTree();
 
+    // Reads all the trees of the source as readNewickTree() does, in the
+    // order they are given (e.g., the trees of a posterior sample). The
+    // caller owns the trees.
+    std::vector<TreeExtended*> readAllNewickTrees();
+
     // Basic function for writing tree TreeExtended in newick format, with the tags
     // indicated by traits included in PRIME markup. If gamma != 0 then AC
     // markup will also be included.
@@ -125,39 +130,10 @@ public:
     inline std::string writeGuestTree(const TreeExtended& G) { return writeGuestTree(G, 0); }
 
 protected:
-    
-    // Handle the various rules for how to set the time over an edge
-    double decideEdgeTime(const NHXnode *v, const TreeIOTraits& traits, bool isHY) const;
-
-    std::string decideNodeName(const NHXnode *v);
-
-    void handleBranchLengths(Node *node, const NHXnode *v, bool NWIsET);
-
-    // Recursively checks what tags are given for all nodes in subtree T_v
-    // Precondition: All bool argument has proper values. Assume a specific
-    // bool argument, 'A' has incoming value 'a', and the value for the
-    // current subtree is 'b', then on return, A = a && b, i.e., false if
-    // either a or b is false.
-    // postcondition: return statement is true if v != 0
-    bool recursivelyCheckTags(const NHXnode *v, TreeIOTraits& traits);
-
-    // Checks what tags are given for node v
-    void checkTags(const NHXnode *v, TreeIOTraits& traits) const;
-
-    // Helper function that reads NHXtrees:
-    NHXtree* readTree();
 
-    TreeExtended* readBeepTree(NHXtree *t, const TreeIOTraits& traits,
-                   std::vector<SetOfNodesEx<Node> > *AC, StrStrMap *gs);
-
-    Node* extendBeepTree(TreeExtended &S, const NHXnode *v,
-                      const TreeIOTraits& traits,
-                      std::vector<SetOfNodesEx<Node> > *AC, StrStrMap *gs,
-                      std::map<const Node*, Node*>* otherParent,
-                      std::map<const Node*, unsigned>* extinct);
-
-    void sanityCheckOnTimes(TreeExtended &S, Node *node, const NHXnode *v,
-                            const TreeIOTraits& traits);
+    // parses the first tree of the source into builder, throws AnError if
+    // there is none
+    void readFirstTree(TreeBuilder &builder);
 
     std::string
     recursivelyWriteBeepTree(Node &u,
@@ -176,17 +152,39 @@ protected:
                              std::map<const Node*,unsigned>* extinct,
                              std::map<unsigned, unsigned>* id);
 
+    // writes the subtree of u, used by both recursivelyWriteBeepTree
+    std::string
+    writeBeepSubtree(Node &u,
+                     const std::map<Node*, std::string> *order,
+                     std::string& least,
+                     const TreeIOTraits& traits,
+                     const GammaMapEx *gamma,
+                     std::map<const Node*,Node*>* otherParent,
+                     std::map<const Node*,unsigned>* extinct,
+                     std::map<unsigned, unsigned>* id);
+
+    // the markup of u, without its subtrees
+    std::string
+    writeNodeMarkup(Node &u,
+                    const TreeIOTraits& traits,
+                    const GammaMapEx *gamma,
+                    std::map<const Node*,Node*>* otherParent,
+                    std::map<const Node*,unsigned>* extinct,
+                    std::map<unsigned, unsigned>* id);
+
     void decideSubtreeOrder(Node &u, std::map<Node*, std::string> order);
 
     std::string getAntiChainMarkup(Node &u, const GammaMapEx &gamma);
 
-    void updateACInfo(const NHXnode *v, Node *new_node,
-                      std::vector<SetOfNodesEx<Node> > &AC);
-
 private:
 
+    // a parser of the source, a file or the standard input is opened only
+    // once and parsed in place
+    NHXParser makeParser();
+
     enum TreeSource source; // Where do we read trees from?
     std::string stringThatWasPreviouslyNamedS;  //filename of current file to read from
+    std::shared_ptr<InputFile> input;  // the file or the standard input, shared by the copies
 
 };
 
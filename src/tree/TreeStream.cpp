@@ -0,0 +1,149 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+
+
+#include <algorithm>
+
+#include "TreeStream.h"
+#include "TreeBuilder.h"
+#include "TreeIOTraits.h"
+#include "Treeextended.h"
+#include "../utils/InputFile.h"
+
+using namespace std;
+
+const unsigned TreeStream::CHECKPOINT_TREES;
+
+namespace
+{
+    // takes the trees that are skipped
+    class SkippedTree : public NHXSink
+    {
+
+    public:
+
+        virtual void beginTree(unsigned) {}
+        virtual unsigned addLeaf(const NHXString &) { return 0; }
+        virtual unsigned addInner(unsigned, unsigned) { return 0; }
+        virtual void setName(unsigned, const NHXString &) {}
+        virtual void addAnnotation(unsigned, const NHXAnnotation &, const int *) {}
+        virtual void endTree(unsigned) {}
+    };
+}
+
+TreeStream::TreeStream(const std::string &filename)
+    : file(filename.empty() ? new InputFile() : new InputFile(filename)),
+      parser(file->begin(), file->end(), file->getName()),
+      weight(1.0),
+      index(0),
+      checkpoints()
+{
+
+}
+
+TreeStream::~TreeStream()
+{
+
+}
+
+TreeExtended* TreeStream::next()
+{
+    TreeBuilder builder;
+    if (!read(builder))
+    {
+        return 0;
+    }
+    TreeIOTraits traits;
+    builder.getTags(traits);
+    traits.setET(false);
+    traits.setNT(false);
+    traits.setBL(traits.hasNW());
+    traits.setNWisET(false);
+    return builder.takeTree(traits);
+}
+
+double TreeStream::getWeight() const
+{
+    return weight;
+}
+
+unsigned long TreeStream::getIndex() const
+{
+    return index;
+}
+
+unsigned long TreeStream::skip(unsigned long n)
+{
+    SkippedTree skipped;
+    unsigned long i = 0;
+    while (i < n && read(skipped))
+    {
+        i++;
+    }
+    return i;
+}
+
+bool TreeStream::seek(unsigned long target)
+{
+    // start from the last checkpoint before the tree unless the stream is
+    // already between the two
+    if (!checkpoints.empty())
+    {
+        const unsigned long k = std::min<unsigned long>(target / CHECKPOINT_TREES,
+                                                        checkpoints.size() - 1);
+        if (target < index || k * CHECKPOINT_TREES > index)
+        {
+            const Checkpoint &c = checkpoints[k];
+            parser = NHXParser(file->begin() + c.offset, file->end(), file->getName(), c.line);
+            index = k * CHECKPOINT_TREES;
+            weight = 1.0;
+        }
+    }
+    const unsigned long n = target - index;
+    return skip(n) == n;
+}
+
+void TreeStream::rewind()
+{
+    parser = NHXParser(file->begin(), file->end(), file->getName());
+    index = 0;
+    weight = 1.0;
+}
+
+bool TreeStream::read(NHXSink &sink)
+{
+    const Checkpoint start = { static_cast<size_t>(parser.getPosition() - file->begin()),
+                               parser.getLine() };
+    double count;
+    weight = parser.readCount(count) ? count : 1.0;
+    if (!parser.next(sink))
+    {
+        return false;
+    }
+    if (index % CHECKPOINT_TREES == 0 && index / CHECKPOINT_TREES == checkpoints.size())
+    {
+        checkpoints.push_back(start);
+    }
+    index++;
+    return true;
+}
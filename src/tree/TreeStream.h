@@ -0,0 +1,112 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+
+
+/* TreeStream reads the trees of a file one at a time, for the files of
+ * sampled trees that are too large to be held in memory as TreeIO does with
+ * readAllNewickTrees(). The file is mapped (see InputFile) and each call to
+ * next() parses and builds only the tree it returns, the tags of a tree
+ * decide how that tree is read, not the tags of the whole file. A line may
+ * start with the number of times its tree was seen, as in
+ *
+ *      1 ((a, b), c);
+ *     12 ((a, c), b);
+ *
+ * which is returned as the weight of the tree. The trees that are skipped
+ * are parsed but not built. The position of every CHECKPOINT_TREES-th tree
+ * is kept, so seeking back does not parse the file from the start. */
+
+#ifndef TREESTREAM_H
+#define TREESTREAM_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../parser/NHXParser.h"
+
+class InputFile;
+class TreeExtended;
+
+using namespace std;
+
+class TreeStream
+{
+
+public:
+
+    // the trees between two checkpoints
+    static const unsigned CHECKPOINT_TREES = 1024;
+
+    // reads the trees of the file, of the standard input if filename is
+    // empty. Throws AnError if the file cannot be opened
+    explicit TreeStream(const std::string &filename);
+    // destructor
+    virtual ~TreeStream();
+
+    // the next tree, 0 at the end of the input. Its lengths are read as
+    // TreeIO::readNewickTree() reads them, throws AnError if the tree is
+    // not well formed. The caller owns the tree
+    TreeExtended* next();
+
+    // the count in front of the tree last returned or skipped, 1 if it has
+    // none
+    double getWeight() const;
+
+    // the index of the tree next() returns, the first tree is 0
+    unsigned long getIndex() const;
+
+    // skips n trees, returns the number skipped, fewer at the end of the input
+    unsigned long skip(unsigned long n);
+
+    // moves to the tree with the index given, so that next() returns it.
+    // Returns false, leaving the stream at the end, if the input has fewer
+    // than index trees
+    bool seek(unsigned long index);
+
+    // moves back to the first tree
+    void rewind();
+
+private:
+
+    // the place where a tree starts
+    struct Checkpoint
+    {
+        size_t offset;
+        unsigned line;
+    };
+
+    TreeStream(const TreeStream &);
+    TreeStream& operator=(const TreeStream &);
+
+    // reads the count and the next tree into sink
+    bool read(NHXSink &sink);
+
+    std::unique_ptr<InputFile> file;
+    NHXParser parser;
+    double weight;
+    unsigned long index;
+    std::vector<Checkpoint> checkpoints;
+};
+
+#endif // TREESTREAM_H
@@ -22,15 +22,98 @@
 
 #include "Treeextended.h"
 #include "Node.h"
+#include "FrozenTree.h"
+#include "Bipartitions.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
 
 using namespace std;
-static const unsigned NONE = -1;
+
+const unsigned TreeExtended::NO_NODE;
 
 TreeExtended::TreeExtended():
-    Tree(),lca_is_valid(false)
+    Tree(),
+    topology_built(static_cast<unsigned long>(-1)),
+    root_(NO_NODE),
+    lca_blocks_(0)
 {
 }
 
+void TreeExtended::build_topology() const
+{
+    const unsigned n = getNumberOfNodes();
+    parent_.assign(n, NO_NODE);
+    left_.assign(n, NO_NODE);
+    right_.assign(n, NO_NODE);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        const Node *v = getNode(i);
+        if (v == 0)
+        {
+            continue;
+        }
+        if (v->getParent())
+        {
+            parent_[i] = v->getParent()->getNumber();
+        }
+        if (!v->isLeaf())
+        {
+            left_[i] = v->getLeftChild()->getNumber();
+            right_[i] = v->getRightChild()->getNumber();
+        }
+    }
+    root_ = getRootNode() ? getRootNode()->getNumber() : NO_NODE;
+
+    // The preorder is built with an explicit stack. Visiting the right
+    // child before the left one gives the postorder reversed.
+    preorder_.clear();
+    postorder_.clear();
+    preorder_index_.assign(n, NO_NODE);
+    postorder_index_.assign(n, NO_NODE);
+    preorder_exit_.assign(n, NO_NODE);
+    if (root_ != NO_NODE)
+    {
+        preorder_.reserve(n);
+        postorder_.reserve(n);
+        std::vector<unsigned> stack(1, root_);
+        while (!stack.empty())
+        {
+            const unsigned v = stack.back();
+            stack.pop_back();
+            preorder_index_[v] = preorder_.size();
+            preorder_.push_back(v);
+            if (left_[v] != NO_NODE)
+            {
+                stack.push_back(right_[v]);
+                stack.push_back(left_[v]);
+            }
+        }
+        stack.push_back(root_);
+        while (!stack.empty())
+        {
+            const unsigned v = stack.back();
+            stack.pop_back();
+            postorder_.push_back(v);
+            if (left_[v] != NO_NODE)
+            {
+                stack.push_back(left_[v]);
+                stack.push_back(right_[v]);
+            }
+        }
+        std::reverse(postorder_.begin(), postorder_.end());
+        for (unsigned i = 0; i < postorder_.size(); ++i)
+        {
+            const unsigned v = postorder_[i];
+            postorder_index_[v] = i;
+            preorder_exit_[v] = left_[v] == NO_NODE ? preorder_index_[v] : preorder_exit_[right_[v]];
+        }
+    }
+    build_lca();
+    topology_built = getTopologyVersion();
+}
+
 Node* TreeExtended::preorder_begin() const 
 {
     return getRootNode();
@@ -38,58 +121,22 @@ Node* TreeExtended::preorder_begin() const
 
 Node* TreeExtended::preorder_next(Node *v) const
 {
-    if (!v->isLeaf())
-    {
-        return v->getLeftChild();
-    }
-    // special case when the tree consists of one vertex only.
-    if (v == getRootNode())
-    {
-        return 0;
-    }
-    
-    while (v != getRootNode() && v->getParent()->getRightChild() == v)
-    {
-        v = v->getParent();
-    }
-    
-    if (v == getRootNode())
-    {
-        return 0;
-    }
-    
-    return v->getParent()->getRightChild();
+    check_topology();
+    const unsigned i = preorder_index_[v->getNumber()] + 1;
+    return i < preorder_.size() ? getNode(preorder_[i]) : 0;
 }
 
 Node* TreeExtended::postorder_begin() const
 {    
-    Node *v = getRootNode();
-    while (!v->isLeaf())
-    {
-        v = v->getLeftChild();
-    }
-    return v;
+    check_topology();
+    return postorder_.empty() ? 0 : getNode(postorder_.front());
 }
 
 Node* TreeExtended::postorder_next(Node *v) const
 {
-    if (v == getRootNode())
-    {
-        return 0;
-    }
-
-    Node *p = v->getParent();
-    Node *r = p->getRightChild();
-
-    if (v == r)
-    {
-        return p;
-    }
-    while (!r->isLeaf())
-    {
-        r = r->getLeftChild();
-    }
-    return r;
+    check_topology();
+    const unsigned i = postorder_index_[v->getNumber()] + 1;
+    return i < postorder_.size() ? getNode(postorder_[i]) : 0;
 }
 
 const char *
@@ -100,105 +147,167 @@ TreeExtended::Invalid_id::what() const throw()
 
 Node* TreeExtended::lca(Node *v1, Node *v2) const
 {
-    assert(static_cast<int>(v1->getNumber()) != -1 && v1->getNumber() < getNumberOfNodes());
-    assert(static_cast<int>(v2->getNumber()) != -1 && v2->getNumber() < getNumberOfNodes());
+    return getNode(lca(v1->getNumber(), v2->getNumber()));
+}
+
+unsigned TreeExtended::lca(unsigned v1, unsigned v2) const
+{
+    assert(v1 < getNumberOfNodes());
+    assert(v2 < getNumberOfNodes());
 
-    if (!lca_is_valid)
+    check_topology();
+    if (v1 == v2)
     {
-        build_lca();
+        return v1;
     }
-    // Get the representatives (i.e, indexes into L) of v1 and v2.
-    unsigned r1 = Ref[v1->getNumber()];
-    unsigned r2 = Ref[v2->getNumber()];
-
-    // Make sure that r2 is the bigger one, so that the range
-    //    of indices is [r1, r2].
+    unsigned r1 = preorder_index_[v1];
+    unsigned r2 = preorder_index_[v2];
     if (r1 > r2)
     {
         std::swap(r1, r2);
     }
-    unsigned k = most_significant_bit(r2 - r1 + 1);
-    unsigned idx1 = M[r1][k];
-    unsigned idx2 = M[r2-(1u<<k)+1][k]; // 1u<<k == 2^k
-    if (L[idx2] < L[idx1])
-    {
-        idx1 = idx2;
-    }
-    return getNode(E[idx1]);
+    // The shallowest node in (r1, r2] is the child of the lca that
+    // leads to the node visited last.
+    return parent_[preorder_[range_min(r1 + 1, r2)]];
 }
 
-void TreeExtended::build_lca() const
+void TreeExtended::lca(const std::vector<std::pair<unsigned, unsigned> > &queries,
+                       std::vector<unsigned> &answers) const
 {
-    // First, we build the E and L arrays, i.e., the Euler tour and
-    // the level array.
-
-    // We define a recursive function to compute E and L.
-    struct Create_EL
+    check_topology();
+    answers.resize(queries.size());
+    for (unsigned i = 0; i < queries.size(); ++i)
     {
-        void operator()(const Tree &tree,
-                        unsigned cur_vertex, unsigned cur_level,
-                        std::vector<unsigned> &E, std::vector<unsigned> &L)
+        unsigned r1 = preorder_index_[queries[i].first];
+        unsigned r2 = preorder_index_[queries[i].second];
+        if (r1 == r2)
         {
-            E.push_back(cur_vertex);
-            L.push_back(cur_level);
-            
-            if (tree.getNode(cur_vertex)->isLeaf())
-            {
-                return;
-            }
-            this->operator()(tree, tree.getNode(cur_vertex)->getLeftChild()->getNumber(), cur_level + 1, E, L);
-            E.push_back(cur_vertex);
-            L.push_back(cur_level);
-            this->operator()(tree,tree.getNode(cur_vertex)->getRightChild()->getNumber(), cur_level + 1, E, L);
-            E.push_back(cur_vertex);
-            L.push_back(cur_level);
+            answers[i] = queries[i].first;
+            continue;
         }
-    };
+        if (r1 > r2)
+        {
+            std::swap(r1, r2);
+        }
+        answers[i] = parent_[preorder_[range_min(r1 + 1, r2)]];
+    }
+}
 
-    E.clear(); E.reserve(this->getNumberOfNodes());
-    L.clear(); L.reserve(this->getNumberOfNodes());
+// the position of the shallower of the preorder positions i and j
+unsigned TreeExtended::min_depth(unsigned i, unsigned j) const
+{
+    return lca_depth_[j] < lca_depth_[i] ? j : i;
+}
 
-    Create_EL create_EL;
-    create_EL(*this, getRootNode()->getNumber(), 0, E, L);
+// minimum of the positions [l, r] of the same block, the candidates for the
+// minimum of a range ending at r are the bits set in lca_mask_[r]
+unsigned TreeExtended::block_min(unsigned l, unsigned r) const
+{
+    const uint64_t candidates = lca_mask_[r] & (~static_cast<uint64_t>(0) << (l % LCA_BLOCK));
+    return r - r % LCA_BLOCK + lowest_bit(candidates);
+}
 
-    // Create the R-vector.
-    Ref.clear();
-    Ref.resize(this->getNumberOfNodes(), NONE);
-    for (unsigned i = 0; i < E.size(); ++i)
+unsigned TreeExtended::range_min(unsigned l, unsigned r) const
+{
+    const unsigned lb = l / LCA_BLOCK;
+    const unsigned rb = r / LCA_BLOCK;
+    if (lb == rb)
     {
-        if (Ref[E[i]] == NONE)
-        {
-            Ref[E[i]] = i;
-        }
+        return block_min(l, r);
+    }
+    unsigned best = min_depth(block_min(l, lb * LCA_BLOCK + LCA_BLOCK - 1),
+                              block_min(rb * LCA_BLOCK, r));
+    if (lb + 1 < rb)
+    {
+        const unsigned k = most_significant_bit(rb - lb - 1);
+        const unsigned *level = &lca_sparse_[k * lca_blocks_];
+        best = min_depth(best, min_depth(level[lb + 1], level[rb - (1u << k)]));
     }
+    return best;
+}
 
+void TreeExtended::build_lca() const
+{
+    // The depths are computed in preorder, the parent comes first.
+    const unsigned n = preorder_.size();
+    lca_depth_.resize(n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        const unsigned v = preorder_[i];
+        lca_depth_[i] = v == root_ ? 0 : lca_depth_[preorder_index_[parent_[v]]] + 1;
+    }
 
-    // Initialize and build the M-matrix.
-    unsigned rows = L.size();
-    unsigned cols = most_significant_bit(L.size()) + 1;
-    M.resize(boost::extents[rows][cols]);
+    // The in block masks. A stack of the positions whose depth is smaller
+    // than the depth of every later position of the block is kept as a bit
+    // set, the minimum of [l, r] is the first position on the stack of r
+    // that is not before l.
+    lca_mask_.resize(n);
+    uint64_t stack = 0;
+    for (unsigned i = 0; i < n; ++i)
+    {
+        const unsigned offset = i % LCA_BLOCK;
+        if (offset == 0)
+        {
+            stack = 0;
+        }
+        while (stack != 0 &&
+               lca_depth_[i - offset + highest_bit(stack)] >= lca_depth_[i])
+        {
+            stack &= ~(static_cast<uint64_t>(1) << highest_bit(stack));
+        }
+        stack |= static_cast<uint64_t>(1) << offset;
+        lca_mask_[i] = stack;
+    }
 
-    for (unsigned i = 0; i < rows; ++i)
+    // The sparse table over the minimum of each block.
+    lca_blocks_ = (n + LCA_BLOCK - 1) / LCA_BLOCK;
+    const unsigned levels = lca_blocks_ == 0 ? 0 : most_significant_bit(lca_blocks_) + 1;
+    lca_sparse_.resize(levels * lca_blocks_);
+    for (unsigned b = 0; b < lca_blocks_; ++b)
     {
-        M[i][0] = i;
+        lca_sparse_[b] = block_min(b * LCA_BLOCK, std::min(n, (b + 1) * LCA_BLOCK) - 1);
     }
-    for (unsigned j = 1; j < cols; ++j)
+    for (unsigned k = 1; k < levels; ++k)
     {
-        unsigned stride = 1u << j;
-        for (unsigned i = 0; i < rows; ++i)
+        const unsigned *prev = &lca_sparse_[(k - 1) * lca_blocks_];
+        unsigned *level = &lca_sparse_[k * lca_blocks_];
+        for (unsigned b = 0; b < lca_blocks_; ++b)
         {
-            if (i + stride/2 >= rows)
-            {
-                M[i][j] = M[i][j-1];
-                continue;
-            }
-            unsigned idx1 = M[i][j-1];
-            unsigned idx2 = M[i + stride/2][j-1];
-            M[i][j] = L[idx2] < L[idx1] ? idx2 : idx1;
+            const unsigned half = b + (1u << (k - 1));
+            level[b] = half < lca_blocks_ ? min_depth(prev[b], prev[half]) : prev[b];
         }
     }
+}
+
+unsigned
+TreeExtended::lowest_bit(uint64_t v)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(v);
+#else
+    unsigned c = 0;
+    while ((v & 1) == 0)
+    {
+        v >>= 1;
+        ++c;
+    }
+    return c;
+#endif
+}
 
-    lca_is_valid = true;
+unsigned
+TreeExtended::highest_bit(uint64_t v)
+{
+#ifdef __GNUC__
+    return 63 - __builtin_clzll(v);
+#else
+    unsigned c = 0;
+    while (v >>= 1)
+    {
+        ++c;
+    }
+    return c;
+#endif
 }
 
 unsigned
@@ -242,35 +351,37 @@ TreeExtended::most_significant_bit(unsigned v)
 bool
 TreeExtended::descendant(Node *v1, Node *v2) const
 {
-    // Is v1 descendant of v2?
-    return lca(v1, v2) == v2;
+    return descendant(v1->getNumber(), v2->getNumber());
 }
 
 
+// The subtree of n is visited in reverse preorder, so the children of a node
+// are done before the node itself
 double TreeExtended::findMaximumDistanceToLeaf(Node *n) const
 {
-    if (n->isLeaf())
-    {
-        return n->getBranchLength();
-    }
-    else
+    const unsigned first = dfs_entry(n->getNumber());
+    const unsigned last = dfs_exit(n->getNumber());
+    std::vector<double> distance(getNumberOfNodes(), 0.0);
+    for (unsigned i = last + 1; i-- > first;)
     {
-        Node *left = n->getLeftChild();
-        Node *right = n->getRightChild();
-
-        double maxleft = findMaximumDistanceToLeaf(left);
-        double maxright = findMaximumDistanceToLeaf(right);
-        if(maxleft > maxright)
+        const unsigned v = preorder_[i];
+        if (is_leaf(v))
+        {
+            distance[v] = getNode(v)->getBranchLength();
+        }
+        else if (distance[left_[v]] > distance[right_[v]])
         {
-            return n->getLeftChild()->getBranchLength() + 1;
+            distance[v] = getNode(left_[v])->getBranchLength() + 1;
         }
         else
         {
-            return n->getRightChild()->getBranchLength() + 1;
+            distance[v] = getNode(right_[v])->getBranchLength() + 1;
         }
     }
+    return distance[n->getNumber()];
 }
 
+// Counts 2 for every node of the subtree of n
 unsigned TreeExtended::getNumberOfChildren(Node *n) const
 {
     if(n == 0)
@@ -279,23 +390,30 @@ unsigned TreeExtended::getNumberOfChildren(Node *n) const
     }
     else
     {
-        return (getNumberOfChildren(n->getLeftChild()) + 1)
-                + (getNumberOfChildren(n->getRightChild()) + 1);
+        const unsigned v = n->getNumber();
+        return 2 * (dfs_exit(v) - dfs_entry(v) + 1);
     }
 }
 
-void TreeExtended::reset()
+FrozenTree TreeExtended::freeze()
 {
-    for(unsigned i = 0; i < getNumberOfNodes(); i++)
-    {
-        Node *n = getNode(i);
-        n->setHostChild(0);
-        n->setHostParent(0);
-        n->setVisited(0);
-        n->setX(0);
-        n->setY(0);
-        n->setReconcilation(Node::Undefined);
-    }
+    Tree::freeze();
+    return FrozenTree(*this);
+}
+
+void TreeExtended::buildIndices() const
+{
+    check_topology();
+}
+
+TreeExtended* TreeExtended::clone() const
+{
+    return new TreeExtended(*this);
+}
+
+Bipartitions TreeExtended::getBipartitions(NameTable &leaves, bool rooted) const
+{
+    return Bipartitions(*this, leaves, rooted);
 }
 
 void TreeExtended::printPostOrder()
@@ -30,11 +30,16 @@
 #include "../utils/AnError.h"
 #include "Tree.h"
 
-#include <boost/multi_array.hpp>
-#include <boost/static_assert.hpp>
+#include <vector>
+#include <utility>
+#include <stdint.h>
 
 using namespace std;
 
+class FrozenTree;
+class Bipartitions;
+class NameTable;
+
 class TreeExtended : public Tree
 {
 
@@ -57,9 +62,43 @@ public:
     
     // returns the least common ancestor the two nodes given
     Node* lca(Node *v1, Node *v2) const;
+    unsigned lca(unsigned v1, unsigned v2) const;
+
+    // answers a batch of queries in one pass over the tables,
+    // answers[i] is the lca of queries[i].first and queries[i].second
+    void lca(const std::vector<std::pair<unsigned, unsigned> > &queries,
+             std::vector<unsigned> &answers) const;
     
     // true is v1 is descendant of v2
     bool descendant(Node *v1, Node *v2) const;
+    bool descendant(unsigned v1, unsigned v2) const;
+
+    // The topology is also kept as arrays indexed by node number, the hot
+    // loops (the DP, the LCA and the lambda computations) use these instead of
+    // following the Node pointers. The arrays are rebuilt when the topology
+    // changes. NO_NODE is returned for the parent of the root and for the
+    // children of a leaf.
+    static const unsigned NO_NODE = static_cast<unsigned>(-1);
+    unsigned root() const;
+    unsigned parent(unsigned v) const;
+    unsigned left(unsigned v) const;
+    unsigned right(unsigned v) const;
+    bool is_leaf(unsigned v) const;
+
+    // the node ids in preorder and in postorder, the traversals are cached
+    // together with the topology arrays so walking the tree is a linear scan
+    const std::vector<unsigned>& preorder() const;
+    const std::vector<unsigned>& postorder() const;
+
+    // DFS interval of a node: entry is its position in preorder() and exit
+    // the position of the last node of its subtree, so the subtree of v is
+    // preorder()[entry(v)..exit(v)] and u is below v iff its entry lies in
+    // the interval of v
+    unsigned dfs_entry(unsigned v) const;
+    unsigned dfs_exit(unsigned v) const;
+
+    // number of edges from the root to v
+    unsigned depth(unsigned v) const;
     
     // returns the maximum distance from leaf to node
     double findMaximumDistanceToLeaf(Node *n) const;
@@ -67,23 +106,137 @@ public:
     // returns the number of children of node n
     unsigned getNumberOfChildren(Node *n) const;
     
-    // reset the tree information
-    void reset();
+    // freezes the tree (see Tree::freeze()) and returns a read only view of
+    // it that can be shared by threads
+    FrozenTree freeze();
+
+    // returns a copy of the tree made with bulk copies of the nodes and of
+    // the cached indices (see Tree::Tree(const Tree&)), the caller owns it
+    TreeExtended* clone() const;
+
+    // the bipartitions of the leaves of the tree as bitsets over the leaf
+    // names in leaves (see Bipartitions.h)
+    Bipartitions getBipartitions(NameTable &leaves, bool rooted = false) const;
     
     // print preOrder and postOrder
     void printPreOrder();
     void printPostOrder();
 
+protected:
+
+    virtual void buildIndices() const;
+
 private:
 
-    mutable bool lca_is_valid;
-    mutable std::vector<unsigned> E; // Euler-path for lca-compuatation.
-    mutable std::vector<unsigned> L; // Level array corresponding to E.
-    mutable std::vector<std::vector<unsigned>::size_type> Ref; // Representative array for lca-computation
-    mutable boost::multi_array<std::vector<unsigned>::size_type, 2> M; // M-matrix for the RMQ-algorithm.
+    void build_topology() const;
+    void check_topology() const;
+
+    mutable unsigned long topology_built; // topology version of the arrays
+    mutable unsigned root_;
+    mutable std::vector<unsigned> parent_;
+    mutable std::vector<unsigned> left_;
+    mutable std::vector<unsigned> right_;
+    mutable std::vector<unsigned> preorder_;
+    mutable std::vector<unsigned> postorder_;
+    mutable std::vector<unsigned> preorder_index_;  // position of a node in preorder_
+    mutable std::vector<unsigned> preorder_exit_;   // last position of its subtree in preorder_
+    mutable std::vector<unsigned> postorder_index_; // position of a node in postorder_
+
+    // The LCA of two different nodes is the parent of the shallowest node
+    // of the preorder range between them. The range minimum queries use the
+    // depths in preorder split in blocks of 64: a bit mask per position
+    // answers the queries inside a block and a sparse table over the block
+    // minimums the rest, which is O(n) memory and O(1) per query. The
+    // tables are built together with the topology arrays.
+    static const unsigned LCA_BLOCK = 64;
+    mutable std::vector<unsigned> lca_depth_;  // depth of preorder_[i]
+    mutable std::vector<uint64_t> lca_mask_;   // in block minimum candidates
+    mutable std::vector<unsigned> lca_sparse_; // sparse table over the blocks
+    mutable unsigned lca_blocks_;
     struct Invalid_id : public std::exception {const char *what() const throw();};
     static unsigned most_significant_bit(unsigned v);
+    static unsigned lowest_bit(uint64_t v);
+    static unsigned highest_bit(uint64_t v);
+    unsigned min_depth(unsigned i, unsigned j) const;
+    unsigned block_min(unsigned l, unsigned r) const;
+    unsigned range_min(unsigned l, unsigned r) const;
     void build_lca() const;
 };
 
+inline void TreeExtended::check_topology() const
+{
+    if (topology_built != getTopologyVersion())
+    {
+        build_topology();
+    }
+}
+
+inline unsigned TreeExtended::root() const
+{
+    check_topology();
+    return root_;
+}
+
+inline unsigned TreeExtended::parent(unsigned v) const
+{
+    check_topology();
+    return parent_[v];
+}
+
+inline unsigned TreeExtended::left(unsigned v) const
+{
+    check_topology();
+    return left_[v];
+}
+
+inline unsigned TreeExtended::right(unsigned v) const
+{
+    check_topology();
+    return right_[v];
+}
+
+inline bool TreeExtended::is_leaf(unsigned v) const
+{
+    check_topology();
+    return left_[v] == NO_NODE;
+}
+
+inline const std::vector<unsigned>& TreeExtended::preorder() const
+{
+    check_topology();
+    return preorder_;
+}
+
+inline const std::vector<unsigned>& TreeExtended::postorder() const
+{
+    check_topology();
+    return postorder_;
+}
+
+inline unsigned TreeExtended::dfs_entry(unsigned v) const
+{
+    check_topology();
+    return preorder_index_[v];
+}
+
+inline unsigned TreeExtended::dfs_exit(unsigned v) const
+{
+    check_topology();
+    return preorder_exit_[v];
+}
+
+inline unsigned TreeExtended::depth(unsigned v) const
+{
+    check_topology();
+    return lca_depth_[preorder_index_[v]];
+}
+
+inline bool TreeExtended::descendant(unsigned v1, unsigned v2) const
+{
+    // Is v1 descendant of v2?
+    check_topology();
+    return preorder_index_[v2] <= preorder_index_[v1] &&
+            preorder_index_[v1] <= preorder_exit_[v2];
+}
+
 #endif // TREEEXTENDED_H
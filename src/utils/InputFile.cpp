@@ -0,0 +1,232 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "InputFile.h"
+#include "AnError.h"
+
+using namespace std;
+
+namespace
+{
+    // the white space of operator>> in the C locale
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+    }
+}
+
+#ifdef _WIN32
+
+InputFile::InputFile()
+    : name("STDIN"),
+      data(0),
+      length(0),
+      mapped(false),
+      buffer()
+{
+    buffer.assign(istreambuf_iterator<char>(cin.rdbuf()), istreambuf_iterator<char>());
+    data = buffer.empty() ? 0 : &buffer[0];
+    length = buffer.size();
+}
+
+InputFile::InputFile(const std::string &filename)
+    : name(filename),
+      data(0),
+      length(0),
+      mapped(false),
+      buffer()
+{
+    ifstream is(filename.c_str(), ios::in | ios::binary);
+    if (!is)
+    {
+        throw AnError("Could not open file for reading ", filename, 1);
+    }
+    buffer.assign(istreambuf_iterator<char>(is.rdbuf()), istreambuf_iterator<char>());
+    data = buffer.empty() ? 0 : &buffer[0];
+    length = buffer.size();
+}
+
+InputFile::~InputFile()
+{}
+
+#else
+
+InputFile::InputFile()
+    : name("STDIN"),
+      data(0),
+      length(0),
+      mapped(false),
+      buffer()
+{
+    load(STDIN_FILENO);
+}
+
+InputFile::InputFile(const std::string &filename)
+    : name(filename),
+      data(0),
+      length(0),
+      mapped(false),
+      buffer()
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw AnError("Could not open file for reading ", filename, 1);
+    }
+    try
+    {
+        load(fd);
+    }
+    catch (...)
+    {
+        close(fd);
+        throw;
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+InputFile::~InputFile()
+{
+    if (mapped)
+    {
+        munmap(const_cast<char*>(data), length);
+    }
+}
+
+void InputFile::load(int fd)
+{
+    struct stat st;
+    const bool known_size = fstat(fd, &st) == 0 && st.st_size > 0;
+    if (known_size && S_ISREG(st.st_mode))
+    {
+        void *p = mmap(0, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+#ifdef MADV_SEQUENTIAL
+            madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+#endif
+            data = static_cast<const char*>(p);
+            length = static_cast<size_t>(st.st_size);
+            mapped = true;
+            return;
+        }
+    }
+
+    // pipes, and the files that cannot be mapped, are read to the end
+    size_t used = 0;
+    buffer.resize(known_size ? static_cast<size_t>(st.st_size) + 1 : 65536);
+    for (;;)
+    {
+        if (used == buffer.size())
+        {
+            buffer.resize(buffer.size() * 2);
+        }
+        const ssize_t n = read(fd, &buffer[used], buffer.size() - used);
+        if (n == 0)
+        {
+            break;
+        }
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw AnError("Could not read ", name + ": " + strerror(errno), 1);
+        }
+        used += static_cast<size_t>(n);
+    }
+    buffer.resize(used);
+    data = buffer.empty() ? 0 : &buffer[0];
+    length = used;
+}
+
+#endif
+
+const char* InputFile::begin() const
+{
+    return data;
+}
+
+const char* InputFile::end() const
+{
+    return data + length;
+}
+
+size_t InputFile::size() const
+{
+    return length;
+}
+
+const std::string& InputFile::getName() const
+{
+    return name;
+}
+
+bool InputFile::isMapped() const
+{
+    return mapped;
+}
+
+bool InputFile::nextWord(const char *&position, const char *end,
+                         const char *&word, size_t &length)
+{
+    while (position != end && isSpace(*position))
+    {
+        ++position;
+    }
+    if (position == end)
+    {
+        return false;
+    }
+    word = position;
+    while (position != end && !isSpace(*position))
+    {
+        ++position;
+    }
+    length = static_cast<size_t>(position - word);
+    return true;
+}
+
+void InputFile::skipLine(const char *&position, const char *end)
+{
+    const char *p = position == end ? 0
+            : static_cast<const char*>(memchr(position, '\n', end - position));
+    position = p ? p + 1 : end;
+}
@@ -0,0 +1,85 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+
+/* InputFile gives read only access to the whole contents of a file or of
+ * the standard input as one block of characters. Regular files are mapped
+ * in memory, so nothing is copied and the pages are shared with every other
+ * process reading the same file; pipes, terminals and the systems without
+ * mmap() get the contents read into a buffer instead. The contents are not
+ * terminated by a null character, the readers must stop at end(). */
+
+#ifndef INPUTFILE_H
+#define INPUTFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class InputFile
+{
+
+public:
+
+    // reads the standard input
+    explicit InputFile();
+    // reads the file, throws AnError if it cannot be opened
+    explicit InputFile(const std::string &filename);
+    // unmaps the file
+    virtual ~InputFile();
+
+    const char* begin() const;
+    const char* end() const;
+    size_t size() const;
+
+    // the file name, "STDIN" for the standard input
+    const std::string& getName() const;
+
+    // true if the contents are mapped rather than copied
+    bool isMapped() const;
+
+    // finds the next word separated by white space from position on, as
+    // operator>> reads words from a stream, and moves position past it.
+    // Returns false if only white space is left
+    static bool nextWord(const char *&position, const char *end,
+                         const char *&word, size_t &length);
+
+    // moves position past the next end of line, to end if there is none
+    static void skipLine(const char *&position, const char *end);
+
+private:
+
+    InputFile(const InputFile &);
+    InputFile& operator=(const InputFile &);
+
+    void load(int fd);
+
+    std::string name;
+    const char *data;
+    size_t length;
+    bool mapped;
+    std::vector<char> buffer;
+};
+
+#endif // INPUTFILE_H
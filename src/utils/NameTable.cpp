@@ -0,0 +1,184 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+#include <cstring>
+
+#include "NameTable.h"
+
+using namespace std;
+
+const unsigned NameTable::NO_NAME;
+
+// the table is never more than half full
+static const size_t MIN_SLOTS = 16;
+
+NameTable::NameTable()
+    : characters(),
+      offsets(1, 0),
+      hashes(),
+      slots(MIN_SLOTS, NO_NAME)
+{
+
+}
+
+NameTable::~NameTable()
+{
+
+}
+
+unsigned
+NameTable::intern(const string &name)
+{
+    return intern(name.data(), name.size());
+}
+
+unsigned
+NameTable::intern(const char *name, size_t length)
+{
+    const uint32_t h = hash(name, length);
+    unsigned s = slot(name, length, h);
+    if (slots[s] != NO_NAME)
+    {
+        return slots[s];
+    }
+
+    const unsigned id = hashes.size();
+    characters.insert(characters.end(), name, name + length);
+    offsets.push_back(characters.size());
+    hashes.push_back(h);
+    slots[s] = id;
+    if (2 * hashes.size() > slots.size())
+    {
+        rehash(2 * slots.size());
+    }
+    return id;
+}
+
+unsigned
+NameTable::find(const string &name) const
+{
+    return find(name.data(), name.size());
+}
+
+unsigned
+NameTable::find(const char *name, size_t length) const
+{
+    return slots[slot(name, length, hash(name, length))];
+}
+
+string
+NameTable::getName(unsigned id) const
+{
+    return string(getData(id), getLength(id));
+}
+
+const char*
+NameTable::getData(unsigned id) const
+{
+    return characters.empty() ? "" : characters.data() + offsets[id];
+}
+
+size_t
+NameTable::getLength(unsigned id) const
+{
+    return offsets[id + 1] - offsets[id];
+}
+
+unsigned
+NameTable::size() const
+{
+    return hashes.size();
+}
+
+void
+NameTable::reserve(unsigned n)
+{
+    offsets.reserve(n + 1);
+    hashes.reserve(n);
+    size_t capacity = slots.size();
+    while (capacity < 2 * static_cast<size_t>(n))
+    {
+        capacity *= 2;
+    }
+    if (capacity != slots.size())
+    {
+        rehash(capacity);
+    }
+}
+
+void
+NameTable::clear()
+{
+    characters.clear();
+    offsets.assign(1, 0);
+    hashes.clear();
+    slots.assign(MIN_SLOTS, NO_NAME);
+}
+
+// FNV-1a
+uint32_t
+NameTable::hash(const char *name, size_t length)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; ++i)
+    {
+        h ^= static_cast<unsigned char>(name[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// the slot holding the name, or the free slot where it would go
+unsigned
+NameTable::slot(const char *name, size_t length, uint32_t h) const
+{
+    const size_t mask = slots.size() - 1;
+    for (size_t s = h & mask; ; s = (s + 1) & mask)
+    {
+        const unsigned id = slots[s];
+        if (id == NO_NAME)
+        {
+            return s;
+        }
+        if (hashes[id] == h && getLength(id) == length &&
+                (length == 0 || memcmp(characters.data() + offsets[id], name, length) == 0))
+        {
+            return s;
+        }
+    }
+}
+
+void
+NameTable::rehash(size_t capacity)
+{
+    slots.assign(capacity, NO_NAME);
+    const size_t mask = capacity - 1;
+    for (unsigned id = 0; id < hashes.size(); ++id)
+    {
+        size_t s = hashes[id] & mask;
+        while (slots[s] != NO_NAME)
+        {
+            s = (s + 1) & mask;
+        }
+        slots[s] = id;
+    }
+}
@@ -0,0 +1,94 @@
+/*
+    PrimeTV2 : a visualizer for phylogenetic reconciled trees.
+    Copyright (C) 2011  <Jose Fernandez Navarro> <jc.fernandez.navarro@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    Author : Jose Fernandez Navarro  -  jc.fernandez.navarro@gmail.com
+*/
+
+
+/* NameTable interns strings: every distinct name is stored once, one after
+ * the other in a single character buffer, and gets a dense integer id. The
+ * ids are found through an open addressing hash table with linear probing,
+ * so looking up a name costs one hash and usually one string comparison,
+ * and two interned names can be compared by their ids.
+ *
+ * Each Tree and each StrStrMap owns its table instead of sharing one, the
+ * ids are therefore only comparable within one owner. A shared table would
+ * outlive the trees that are cleared, copied and read again (see
+ * Mainops::start()) and would only grow. The gene to species mapping does
+ * not need shared ids: create_gene_species_map() looks each species of the
+ * map up once in the species tree and then maps every gene leaf through the
+ * species id of the StrStrMap, one hash per gene leaf. */
+
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+class NameTable
+{
+
+public:
+
+    // returned by find() for the names not in the table
+    static const unsigned NO_NAME = static_cast<unsigned>(-1);
+
+    // constructor
+    explicit NameTable();
+    // destructor
+    virtual ~NameTable();
+
+    // returns the id of the name, adding it to the table if needed
+    unsigned intern(const std::string &name);
+    unsigned intern(const char *name, size_t length);
+
+    // returns the id of the name or NO_NAME
+    unsigned find(const std::string &name) const;
+    unsigned find(const char *name, size_t length) const;
+
+    // the name with the given id, the pointer returned by getData() is
+    // valid until the next call to intern()
+    std::string getName(unsigned id) const;
+    const char* getData(unsigned id) const;
+    size_t getLength(unsigned id) const;
+
+    // number of names in the table
+    unsigned size() const;
+
+    // makes room for n names
+    void reserve(unsigned n);
+
+    void clear();
+
+private:
+
+    static uint32_t hash(const char *name, size_t length);
+    unsigned slot(const char *name, size_t length, uint32_t h) const;
+    void rehash(size_t capacity);
+
+    std::vector<char> characters;    // the names one after the other
+    std::vector<size_t> offsets;     // the name i is [offsets[i], offsets[i+1])
+    std::vector<uint32_t> hashes;    // the hash of each name
+    std::vector<unsigned> slots;     // the hash table, NO_NAME marks a free slot
+};
+
+#endif // NAMETABLE_H